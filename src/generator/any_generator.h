@@ -0,0 +1,165 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_ANY_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_ANY_GENERATOR_H
+
+// A type-erased generator that stores an inline (stackful) coroutine frame inside a buffer of
+// `BufferSize` bytes in the generator object itself. Unlike `inline_gen<T, CoroFrame>`, the type
+// doesn't depend on the frame, so `any_generator`s can cross API boundaries and be stored in
+// containers. Unlike `heap_generator`, there is no heap allocation. Frames that don't fit into the
+// buffer are rejected at compile time.
+//
+// `resume()` and `destroy()` are dispatched through a small static vtable per frame type. The
+// addresses of the promise and of the `done_` flag of the `stackful_coro_crtp` are cached in the
+// handle (and updated when the frame is relocated), so `done()` and accessing the current value
+// don't need an indirect call.
+//
+// Example:
+//   any_generator<int> numbers(bool squares, int n) {
+//     if (squares) return make_any_generator(iota_unified<false>(0, n) | map(square));
+//     return make_any_generator(iota_unified<false>(0, n));
+//   }
+//
+// Moving an `any_generator` moves the frame to the buffer of the new generator, and the pointers of
+// the promise into the frame (to the current value or batch) are rebased, as for the frames of a
+// `small_generator`. A started generator can only be moved if the move constructor of its frame
+// moves all the locals that are alive (see `stackless_coro_crtp::ramp_in_buffer`).
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "generator/unified_generator.h"
+
+namespace detail {
+// The type-erased operations on a frame of type `Frame` that is stored inside a buffer.
+template <typename Promise>
+struct any_frame_vtable {
+  void (*resume)(void* frame);
+  // Destroy the suspended coroutine and the frame object.
+  void (*destroy)(void* frame);
+  // Move-construct the frame at `to` and destroy the frame object at `from`. Pointers in the
+  // promise that point into the old frame are moved to the new one, see
+  // `stackless_coro_crtp::relocate`.
+  void (*relocate)(void* from, void* to);
+  Promise* (*promise)(void* frame);
+  const bool* (*done_flag)(const void* frame);
+
+  template <typename Frame>
+  static constexpr any_frame_vtable make() noexcept {
+    return {
+        [](void* frame) { static_cast<Frame*>(frame)->doStep(); },
+        [](void* frame) {
+          auto* f = static_cast<Frame*>(frame);
+          f->destroy();
+          f->~Frame();
+        },
+        [](void* from, void* to) {
+          auto* source = static_cast<Frame*>(from);
+          auto* target = new (to) Frame(std::move(*source));
+          if constexpr (coro_detail::has_rebase<Promise>::value) {
+            target->promise().rebase(source, target, sizeof(Frame));
+          }
+          source->~Frame();
+        },
+        [](void* frame) { return &static_cast<Frame*>(frame)->promise(); },
+        [](const void* frame) { return &static_cast<const Frame*>(frame)->done_; },
+    };
+  }
+};
+
+template <typename Promise, typename Frame>
+inline constexpr any_frame_vtable<Promise> any_frame_vtable_for =
+    any_frame_vtable<Promise>::template make<Frame>();
+
+// The handle of an `any_generator`, which owns the buffer with the frame. Is empty after it has
+// been moved from.
+template <typename Promise, size_t BufferSize>
+class any_frame_handle {
+ public:
+  template <typename Frame>
+  explicit any_frame_handle(Frame&& frame) noexcept(std::is_nothrow_move_constructible_v<Frame>) {
+    static_assert(sizeof(Frame) <= BufferSize,
+                  "The frame doesn't fit into the buffer of the `any_generator`, increase the "
+                  "`BufferSize`");
+    static_assert(alignof(Frame) <= alignof(std::max_align_t));
+    static_assert(std::is_same_v<std::decay_t<decltype(frame.promise())>, Promise>);
+    auto* f = new (buffer_) Frame(std::move(frame));
+    vtable_ = &any_frame_vtable_for<Promise, Frame>;
+    promise_ = &f->promise();
+    done_ = &f->done_;
+  }
+
+  any_frame_handle(any_frame_handle&& other) noexcept { takeFrom(other); }
+
+  any_frame_handle& operator=(any_frame_handle&& other) noexcept {
+    if (this != &other) {
+      destroy();
+      takeFrom(other);
+    }
+    return *this;
+  }
+
+  any_frame_handle(const any_frame_handle&) = delete;
+  any_frame_handle& operator=(const any_frame_handle&) = delete;
+
+  // As for the `stackful_coroutine_handle`, destroying the frame is the responsibility of the
+  // owning generator.
+  ~any_frame_handle() = default;
+
+  void resume() { vtable_->resume(buffer_); }
+  bool done() const { return *done_; }
+  Promise& promise() { return *promise_; }
+  const Promise& promise() const { return *promise_; }
+
+  void destroy() {
+    if (vtable_) {
+      vtable_->destroy(buffer_);
+      vtable_ = nullptr;
+      promise_ = nullptr;
+      done_ = nullptr;
+    }
+  }
+
+  explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+ private:
+  void takeFrom(any_frame_handle& other) noexcept {
+    vtable_ = std::exchange(other.vtable_, nullptr);
+    promise_ = std::exchange(other.promise_, nullptr);
+    done_ = std::exchange(other.done_, nullptr);
+    if (vtable_) {
+      vtable_->relocate(other.buffer_, buffer_);
+      promise_ = vtable_->promise(buffer_);
+      done_ = vtable_->done_flag(buffer_);
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char buffer_[BufferSize];
+  const any_frame_vtable<Promise>* vtable_ = nullptr;
+  Promise* promise_ = nullptr;
+  const bool* done_ = nullptr;
+};
+}  // namespace detail
+
+// Policy for generators that store a type-erased inline frame in a buffer of `BufferSize` bytes.
+// The generator is not nullable, but the handle is empty after a move, in which case `destroy()`
+// is a noop.
+template <typename T, size_t BufferSize>
+struct AnyGeneratorPolicy {
+  using promise_type = detail::unified_generator_promise<T>;
+  using handle_type = detail::any_frame_handle<promise_type, BufferSize>;
+  static constexpr bool nullable = false;
+};
+
+template <typename T, size_t BufferSize = 256>
+using any_generator = unified_generator<T, AnyGeneratorPolicy<T, BufferSize>>;
+
+// Move the frame of the inline generator `gen` into the buffer of an `any_generator`. `gen` must
+// not have been started yet.
+template <size_t BufferSize = 256, typename T, typename Frame>
+any_generator<T, BufferSize> make_any_generator(inline_gen<T, Frame>&& gen) {
+  using handle_type = typename AnyGeneratorPolicy<T, BufferSize>::handle_type;
+  return any_generator<T, BufferSize>{handle_type{std::move(gen.handle().frame)}};
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_ANY_GENERATOR_H
@@ -0,0 +1,220 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_ARITHMETIC_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_ARITHMETIC_GENERATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+template <typename T>
+class arithmetic_generator;
+
+namespace detail {
+// The promise of an `arithmetic_generator`. The complete state of the sequence (and not only the
+// last value) lives in the promise, so the generator object can inspect and modify it while the
+// frame is suspended. The sequence is `first_ + i * step_` for `i` in `[next_, end_)`. Computing
+// each value from its index (instead of adding up the steps) makes `advance()` O(1), lets
+// sub-ranges produce the same values, and doesn't accumulate rounding errors for floating types.
+template <typename T>
+class arithmetic_generator_promise : public unified_generator_promise<T> {
+ public:
+  arithmetic_generator<T> get_return_object() noexcept;
+
+  void init(T first, T step, size_t begin, size_t end) noexcept {
+    first_ = first;
+    step_ = step;
+    next_ = begin;
+    end_ = end;
+  }
+
+  bool has_next() const noexcept { return next_ < end_; }
+
+  T pop_next() noexcept { return at(next_++); }
+
+  // The number of values that have not been produced yet.
+  size_t size() const noexcept { return end_ - next_; }
+
+  void advance(size_t n) noexcept { next_ += std::min(n, size()); }
+
+  T first() const noexcept { return first_; }
+  T step() const noexcept { return step_; }
+  size_t next_index() const noexcept { return next_; }
+
+  T at(size_t i) const noexcept {
+    if constexpr (std::is_integral_v<T>) {
+      // Unsigned arithmetic wraps around, so this is also correct for negative steps. Types smaller
+      // than `unsigned` would be promoted to (signed, possibly overflowing) `int`.
+      using U = std::make_unsigned_t<std::common_type_t<std::make_unsigned_t<T>, unsigned>>;
+      return static_cast<T>(static_cast<U>(first_) + static_cast<U>(i) * static_cast<U>(step_));
+    } else {
+      return first_ + static_cast<T>(i) * step_;
+    }
+  }
+
+ private:
+  T first_{};
+  T step_{};
+  size_t next_ = 0;
+  size_t end_ = 0;
+};
+
+// The number of values of the half-open sequence `[first, last)` with the given `step`. Throws
+// `std::invalid_argument` if the step is zero, if a floating bound or step is not finite, or if the
+// number of values doesn't fit into a `size_t`.
+template <typename T>
+size_t arithmetic_sequence_size(T first, T last, T step) {
+  if (step == T{0}) {
+    throw std::invalid_argument{"arithmetic_sequence: step must not be zero"};
+  }
+  if constexpr (std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<T>;
+    if (step > T{0} ? last <= first : last >= first) {
+      return 0;
+    }
+    U distance = step > T{0} ? static_cast<U>(last) - static_cast<U>(first)
+                             : static_cast<U>(first) - static_cast<U>(last);
+    U stride = step > T{0} ? static_cast<U>(step) : U{0} - static_cast<U>(step);
+    return static_cast<size_t>(distance / stride + (distance % stride != 0));
+  } else {
+    if (!std::isfinite(first) || !std::isfinite(last) || !std::isfinite(step)) {
+      throw std::invalid_argument{"arithmetic_sequence: bounds and step must be finite"};
+    }
+    T count = std::ceil((last - first) / step);
+    if (!(count > T{0})) {
+      return 0;
+    }
+    if (count >= static_cast<T>(std::numeric_limits<size_t>::max())) {
+      throw std::invalid_argument{"arithmetic_sequence: too many values"};
+    }
+    return static_cast<size_t>(count);
+  }
+}
+
+/**
+ * The C++17 rewrite of the following generator, where the loop state lives in the promise:
+ *   arithmetic_generator<T> arithmetic_sequence_impl(T first, T step, size_t begin, size_t end) {
+ *     for (size_t i = begin; i < end; ++i) co_yield first + i * step;
+ *   }
+ */
+template <typename T>
+arithmetic_generator<T> arithmetic_sequence_impl(T first, T step, size_t begin, size_t end) {
+  using promise_type = arithmetic_generator_promise<T>;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+
+    CoroFrame(T first, T step, size_t begin, size_t end) {
+      this->promise().init(first, step, begin, end);
+    }
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (this->promise().has_next()) {
+        CO_YIELD(1, initial_awaiter_, this->promise().pop_next());
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(first, step, begin, end);
+}
+}  // namespace detail
+
+template <typename T>
+struct ArithmeticGeneratorPolicy {
+  using promise_type = detail::arithmetic_generator_promise<T>;
+  using handle_type = stackless_coroutine_handle<promise_type>;
+  static constexpr bool nullable = true;
+};
+
+// A heap generator for an arithmetic sequence that knows its remaining size, and that can skip
+// values and be split into sub-ranges without resuming the frame, see `arithmetic_sequence`.
+template <typename T>
+class [[nodiscard]] arithmetic_generator
+    : public unified_generator<T, ArithmeticGeneratorPolicy<T>> {
+  using Base = unified_generator<T, ArithmeticGeneratorPolicy<T>>;
+
+ public:
+  using Base::Base;
+
+  // The number of values that the generator will still yield. Before the first call to `begin()`
+  // these are all the values, afterwards the value that the iterator currently points to is not
+  // counted.
+  size_t size() const noexcept { return this->handle() ? this->handle().promise().size() : 0; }
+
+  // Skip the next `n` values (or all the remaining ones) in O(1).
+  void advance(size_t n) noexcept {
+    if (this->handle()) {
+      this->handle().promise().advance(n);
+    }
+  }
+
+  // Split the remaining values into `k` contiguous sub-ranges of (nearly) equal size, which are
+  // independent generators, e.g. for processing them in parallel. The sizes of the sub-ranges
+  // differ by at most one, some of them are empty if `k > size()`. This generator is not modified.
+  // Throws `std::invalid_argument` if `k` is zero.
+  std::vector<arithmetic_generator> split(size_t k) const {
+    if (k == 0) {
+      throw std::invalid_argument{"arithmetic_generator::split: k must not be zero"};
+    }
+    std::vector<arithmetic_generator> result;
+    result.reserve(k);
+    const size_t total = size();
+    size_t begin = this->handle() ? this->handle().promise().next_index() : 0;
+    for (size_t i = 0; i < k; ++i) {
+      size_t count = total / k + (i < total % k);
+      if (this->handle()) {
+        const auto& promise = this->handle().promise();
+        result.push_back(detail::arithmetic_sequence_impl(promise.first(), promise.step(), begin,
+                                                          begin + count));
+      } else {
+        result.emplace_back();
+      }
+      begin += count;
+    }
+    return result;
+  }
+};
+
+// The values `first, first + step, first + 2 * step, ...` that are less than `last` (greater than
+// `last` for a negative `step`) for any integral or floating type. Throws `std::invalid_argument`
+// for a zero `step`, see `detail::arithmetic_sequence_size` for the other invalid arguments.
+template <typename T>
+arithmetic_generator<T> arithmetic_sequence(T first, T last, std::common_type_t<T> step = T{1}) {
+  return detail::arithmetic_sequence_impl(first, step, 0,
+                                          detail::arithmetic_sequence_size(first, last, step));
+}
+
+namespace detail {
+template <typename T>
+arithmetic_generator<T> arithmetic_generator_promise<T>::get_return_object() noexcept {
+  using handle_t = stackless_coroutine_handle<arithmetic_generator_promise<T>>;
+  return arithmetic_generator<T>{handle_t::from_promise(*this)};
+}
+}  // namespace detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_ARITHMETIC_GENERATOR_H
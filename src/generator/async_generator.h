@@ -0,0 +1,167 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_ASYNC_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_ASYNC_GENERATOR_H
+
+// A generator that may `co_await` (e.g. `task`s or I/O) between its `co_yield`s. Inspired by
+// `cppcoro::async_generator`. The consumer is itself a coroutine, which obtains the values via
+//   while (auto* value = co_await gen.next()) { ... }
+// `next()` resumes the producer via symmetric transfer, and the producer transfers control back to
+// the waiting consumer when it yields a value or finishes. Awaited tasks continue the producer when
+// they are done, so the consumer, the producer and the awaited tasks form a chain of symmetric
+// transfers that is trampolined by `stackless_handle_base::resume()`. If an awaited operation
+// really suspends, then the consumer is resumed from wherever the producer is resumed.
+//
+// Unlike `unified_generator_promise`, the promise has no deleted `await_transform`, so all the
+// awaitables that the `CO_AWAIT` macro supports can be awaited by the producer. Only the address of
+// the yielded value is stored, so the value has to live in the frame of the producer until the
+// producer is resumed.
+
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "util/coroutine_handle.h"
+#include "util/suspend.h"
+
+template <typename T>
+class async_generator;
+
+namespace detail {
+template <typename T>
+class async_generator_promise {
+ public:
+  using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+  using reference_type = std::conditional_t<std::is_reference_v<T>, T, const T&>;
+  using pointer_type = std::add_pointer_t<reference_type>;
+  using handle_type = stackless_coroutine_handle<async_generator_promise>;
+
+  async_generator_promise() = default;
+
+  async_generator<T> get_return_object() noexcept;
+
+  // The producer only starts once the consumer awaits the first value.
+  constexpr SuspendAlways initial_suspend() const noexcept { return {}; }
+
+  // Transfer control back to the consumer that waits in `co_await gen.next()`.
+  struct consumer_awaiter {
+    static constexpr bool await_ready() noexcept { return false; }
+
+    stackless_coroutine_handle<void> await_suspend(handle_type h) noexcept {
+      return h.promise().consumer_;
+    }
+
+    static constexpr void await_resume() noexcept {}
+  };
+
+  consumer_awaiter final_suspend() const noexcept { return {}; }
+
+  consumer_awaiter yield_value(reference_type value) noexcept {
+    m_value = std::addressof(value);
+    return {};
+  }
+
+  void unhandled_exception() { m_exception = std::current_exception(); }
+
+  void return_void() {}
+
+  pointer_type value() const noexcept { return m_value; }
+
+  void rethrow_if_exception() {
+    if (m_exception) {
+      std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+  }
+
+  // The consumer that is currently waiting for the next value.
+  stackless_coroutine_handle<void> consumer_;
+
+ private:
+  pointer_type m_value = nullptr;
+  std::exception_ptr m_exception;
+};
+
+// Awaiter for `co_await gen.next()`. Resumes the producer until it yields the next value, and
+// returns a pointer to that value, or `nullptr` once the producer is exhausted. An exception of the
+// producer is rethrown to the consumer.
+template <typename T>
+class async_generator_next_awaiter {
+  using promise_type = async_generator_promise<T>;
+  using handle_type = stackless_coroutine_handle<promise_type>;
+
+ public:
+  explicit async_generator_next_awaiter(handle_type producer) noexcept : producer_(producer) {}
+
+  bool await_ready() const noexcept { return !producer_ || producer_.done(); }
+
+  template <typename ConsumerPromise>
+  stackless_coroutine_handle<void> await_suspend(
+      stackless_coroutine_handle<ConsumerPromise> consumer) noexcept {
+    producer_.promise().consumer_ = stackless_coroutine_handle<void>{consumer.ptr};
+    return stackless_coroutine_handle<void>{producer_.ptr};
+  }
+
+  typename promise_type::pointer_type await_resume() {
+    if (!producer_) {
+      return nullptr;
+    }
+    if (producer_.done()) {
+      producer_.promise().rethrow_if_exception();
+      return nullptr;
+    }
+    return producer_.promise().value();
+  }
+
+ private:
+  handle_type producer_;
+};
+}  // namespace detail
+
+template <typename T>
+class [[nodiscard]] async_generator {
+ public:
+  using promise_type = detail::async_generator_promise<T>;
+  using handle_type = stackless_coroutine_handle<promise_type>;
+  using value_type = typename promise_type::value_type;
+  using next_awaiter = detail::async_generator_next_awaiter<T>;
+
+  async_generator() noexcept : m_handle(nullptr) {}
+
+  explicit async_generator(handle_type h) noexcept : m_handle(h) {}
+
+  async_generator(async_generator&& other) noexcept : m_handle(other.m_handle) {
+    other.m_handle = nullptr;
+  }
+
+  async_generator& operator=(async_generator&& other) noexcept {
+    if (this != &other) {
+      if (m_handle) m_handle.destroy();
+      m_handle = other.m_handle;
+      other.m_handle = nullptr;
+    }
+    return *this;
+  }
+
+  async_generator(const async_generator&) = delete;
+  async_generator& operator=(const async_generator&) = delete;
+
+  // Must not be called while the producer is running (e.g. while it awaits a task that really
+  // suspends).
+  ~async_generator() {
+    if (m_handle) m_handle.destroy();
+  }
+
+  // To be awaited by the consumer, see above. The previous value is invalidated.
+  next_awaiter next() noexcept { return next_awaiter{m_handle}; }
+
+ private:
+  handle_type m_handle;
+};
+
+namespace detail {
+template <typename T>
+async_generator<T> async_generator_promise<T>::get_return_object() noexcept {
+  return async_generator<T>{handle_type::from_promise(*this)};
+}
+}  // namespace detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_ASYNC_GENERATOR_H
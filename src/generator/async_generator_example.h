@@ -0,0 +1,154 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_ASYNC_GENERATOR_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_ASYNC_GENERATOR_EXAMPLE_H
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+#include "generator/async_generator.h"
+#include "task/task.h"
+#include "task/task_example.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * An async generator that awaits a task for each of its values. Manually lowered equivalent of:
+ *   async_generator<size_t> async_compute_values(size_t a, size_t b, size_t failAt) {
+ *     for (size_t i = a; i < b; ++i) {
+ *       if (i == failAt) throw std::runtime_error{"async_compute_values failed"};
+ *       size_t value = co_await compute_value(i);
+ *       co_yield value;
+ *     }
+ *   }
+ */
+inline async_generator<size_t> async_compute_values(
+    size_t a, size_t b, size_t failAt = std::numeric_limits<size_t>::max()) {
+  using promise_type = async_generator<size_t>::promise_type;
+  using inner_task = task<size_t, stackless_coroutine_handle>;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    size_t i_;
+    size_t end_;
+    size_t failAt_;
+    size_t value_;
+
+    coro_storage<inner_task&, true> task_storage_;
+    coro_storage<detail::task_awaiter<size_t, stackless_coroutine_handle>&, true> awaiter_storage_;
+    coro_storage<promise_type::consumer_awaiter&, true> yield_awaiter_;
+
+    CoroFrame(size_t a, size_t b, size_t failAt) : i_(a), end_(b), failAt_(failAt) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      for (; this->i_ < this->end_; ++this->i_) {
+        if (this->i_ == this->failAt_) {
+          throw std::runtime_error{"async_compute_values failed"};
+        }
+        // size_t value = co_await compute_value(i);
+        CO_INIT(task_storage_, (compute_value(this->i_)));
+        CO_AWAIT(1, awaiter_storage_, CO_GET(task_storage_), this->value_ =);
+        this->task_storage_.destroy();
+
+        CO_YIELD(2, yield_awaiter_, this->value_);
+      }
+      CO_RETURN_VOID(3, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->awaiter_storage_.destroy();
+          this->task_storage_.destroy();
+          return;
+        case 2:
+          this->yield_awaiter_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+
+    // The `compute_value` tasks don't throw, so the only exception is the one thrown directly
+    // inside the loop, where no locals are alive.
+    ExceptionResult dispatchExceptionHandling() { return this->unhandled_exception(); }
+  };
+  return CoroFrame::ramp(a, b, failAt);
+}
+
+/**
+ * A task that consumes an async generator. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> sum_async(async_generator<size_t>& gen) {
+ *     size_t sum = 0;
+ *     while (const size_t* value = co_await gen.next()) sum += *value;
+ *     co_return sum;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> sum_async(async_generator<size_t>& gen) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    async_generator<size_t>& gen_;
+    size_t sum_ = 0;
+    const size_t* value_ = nullptr;
+
+    coro_storage<async_generator<size_t>::next_awaiter&, true> next_awaiter_;
+
+    CoroFrame(async_generator<size_t>& gen) : gen_(gen) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (true) {
+        CO_AWAIT(1, next_awaiter_, this->gen_.next(), this->value_ =);
+        if (!this->value_) {
+          break;
+        }
+        this->sum_ += *this->value_;
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->sum_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->next_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    // Exceptions of the producer are rethrown by `await_resume()`, before the awaiter is
+    // destroyed.
+    ExceptionResult dispatchExceptionHandling() {
+      this->next_awaiter_.destroy();
+      return this->unhandled_exception();
+    }
+  };
+  return CoroFrame::ramp(gen);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_ASYNC_GENERATOR_EXAMPLE_H
@@ -0,0 +1,63 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_CHANNEL_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_CHANNEL_GENERATOR_H
+
+#include <optional>
+
+#include "generator/unified_generator.h"
+#include "task/channel.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * The values of the `channel` as a generator, for a synchronous consumer at the end of a pipeline
+ * of tasks. Advancing the generator blocks the calling thread while the channel is empty (see
+ * `async_channel::recv_blocking`), and the generator ends once the channel is closed and drained.
+ * Manually lowered equivalent of:
+ *   generator<T> channel_generator(async_channel<T>& channel) {
+ *     while (std::optional<T> value = channel.recv_blocking()) co_yield std::move(*value);
+ *   }
+ */
+template <typename T>
+heap_generator<T> channel_generator(async_channel<T>& channel) {
+  using promise_type = typename heap_generator<T>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    async_channel<T>& channel_;
+    std::optional<T> value_;
+
+    explicit CoroFrame(async_channel<T>& channel) : channel_(channel) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while ((this->value_ = this->channel_.recv_blocking())) {
+        CO_YIELD(1, initial_awaiter_, std::move(*this->value_));
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    // Only `recv_blocking` can throw (e.g. a throwing move of a value), no awaiter is alive then.
+    ExceptionResult dispatchExceptionHandling() { return this->unhandled_exception(); }
+  };
+  return CoroFrame::ramp(channel);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_CHANNEL_GENERATOR_H
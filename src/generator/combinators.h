@@ -0,0 +1,437 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_COMBINATORS_H
+#define GENERATOR_REWRITE_EXAMPLES_COMBINATORS_H
+
+// Lazy combinators (`map`, `filter`, `take`, `zip`, `concat`) on `unified_generator`s. Each
+// combinator is itself a hand-written coroutine frame that owns its upstream generator(s) and
+// drives them directly via their handles.
+//
+// If all the upstream generators are inline generators (`InlineGeneratorPolicy`), then the
+// combinator frame is an inline frame as well, and the whole pipeline is a single object on the
+// stack, e.g. the type of `iota_unified<false>(0, n) | filter(p) | map(f)` nests the frames of
+// `filter` and `iota` inside the frame of `map`. Every `resume()` in such a chain is a direct call,
+// so the compiler can fuse the state machines and the function objects into a single loop. For
+// all other upstream generators the combinator frame is allocated on the heap.
+//
+// As with all inline generators, an inline pipeline must not be moved after it has been started.
+
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_frame.h"
+#include "util/inline_coroutine_frame.h"
+#include "util/macros.h"
+
+namespace combinators_detail {
+// The type that `*it` yields for a generator of type `Gen`.
+template <typename Gen>
+using upstream_reference_t = typename Gen::promise_type::return_type;
+
+// Combinator frames are inline iff all their upstream generators are inline.
+template <typename... Gens>
+constexpr bool is_stackless_v = (Gens::policy_type::nullable || ...);
+
+// Advance the upstream generator to its next value (which might be the next value of a batch, see
+// `detail::advance_generator`). Returns false (and rethrows a stored exception) if it is exhausted,
+// in which case it must not be stepped again.
+template <typename Gen>
+bool step(Gen& gen) {
+  auto& handle = gen.handle();
+  if constexpr (Gen::policy_type::nullable) {
+    if (!handle) return false;
+  }
+  return detail::advance_generator(handle);
+}
+
+template <typename Gen>
+decltype(auto) current(Gen& gen) {
+  return gen.handle().promise().value();
+}
+
+// Common base of all combinator frames. None of the combinators catches exceptions (from the
+// upstream generators or from the user-supplied function objects), so all of them are stored in
+// the promise and rethrown to the consumer. `Derived::destroyLocals()` has to destroy the locals
+// that are alive when an exception is thrown. The combinators yield their elements one by one
+// (`is_unbatched`), so stepping an inline combinator skips the checks for batches.
+template <typename Derived, bool stackless, typename Out>
+struct combinator_frame : FrameCRTP<stackless, Derived, detail::unified_generator_promise<Out>,
+                                    false> {
+  using output_type = Out;
+  using is_unbatched = std::true_type;
+  static constexpr bool is_stackless = stackless;
+
+  // Used by `stackless_coro_crtp`.
+  ExceptionResult dispatchExceptionHandling() {
+    static_cast<Derived*>(this)->destroyLocals();
+    return this->unhandled_exception();
+  }
+
+  // Used by `stackful_coro_crtp`.
+  size_t dispatchExceptionHandling(std::exception_ptr) {
+    static_cast<Derived*>(this)->destroyLocals();
+    this->setDone();
+    this->promise().unhandled_exception();
+    CO_STORAGE_CONSTRUCT(this->final_awaiter_, (this->promise().final_suspend()));
+    return this->suspendIdx_;
+  }
+
+  void destroyLocals() {}
+};
+
+// Run the ramp function of the combinator `Frame` and wrap the result into a generator.
+template <typename Frame, typename... Args>
+auto make_combinator(Args&&... args) {
+  if constexpr (Frame::is_stackless) {
+    return Frame::ramp(std::forward<Args>(args)...);
+  } else {
+    return inline_gen<typename Frame::output_type, Frame>{
+        stackful_coroutine_handle<Frame>{Frame::ramp(std::forward<Args>(args)...)}};
+  }
+}
+
+/**
+ * template <typename Upstream, typename F>
+ * generator<std::invoke_result_t<F&, upstream_reference_t<Upstream>>> map(Upstream up, F f) {
+ *   for (auto&& x : up) co_yield f(x);
+ * }
+ */
+template <bool stackless, typename Upstream, typename F>
+struct map_frame
+    : combinator_frame<map_frame<stackless, Upstream, F>, stackless,
+                       std::invoke_result_t<F&, upstream_reference_t<Upstream>>> {
+  using R = std::invoke_result_t<F&, upstream_reference_t<Upstream>>;
+  Upstream upstream_;
+  F f_;
+
+  // Owns the result of `f`, unless `f` returns a reference. Value-initialized, because the frame
+  // of an inline `map` is moved out of `ramp` before `tmp_` is constructed.
+  using tmp_type =
+      coro_storage<std::conditional_t<std::is_reference_v<R>, R, R&&>, !std::is_reference_v<R>>;
+  tmp_type tmp_{};
+  struct {
+    bool tmp_ = false;
+  } __constructed;
+
+  map_frame(Upstream&& upstream, F f) : upstream_(std::move(upstream)), f_(std::move(f)) {}
+
+  stackless_coroutine_handle<void> doStepImpl() {
+    switch (this->suspendIdx_) {
+      case 0:
+        break;
+      case 1:
+        goto label_1;
+    }
+
+    CO_GET(initial_awaiter_).await_resume();
+    this->initial_awaiter_.destroy();
+    while (step(this->upstream_)) {
+      CO_INIT_EX(tmp_, (this->f_(current(this->upstream_))));
+      CO_YIELD(1, initial_awaiter_, CO_GET(tmp_));
+      DESTROY_UNCONDITIONALLY(tmp_);
+    }
+    CO_RETURN_VOID(2, final_awaiter_);
+  }
+
+  void destroySuspendedCoro(size_t suspendIdx_) {
+    switch (suspendIdx_) {
+      case 0:
+        this->initial_awaiter_.destroy();
+        return;
+      case 1:
+        this->initial_awaiter_.destroy();
+        this->tmp_.destroy();
+        return;
+      case 2:
+        return;
+    }
+  }
+
+  void destroyLocals() { DESTROY_IF_CONSTRUCTED(tmp_); }
+};
+
+/**
+ * template <typename Upstream, typename Pred>
+ * generator<upstream_reference_t<Upstream>> filter(Upstream up, Pred pred) {
+ *   for (auto&& x : up) if (pred(x)) co_yield x;
+ * }
+ */
+template <bool stackless, typename Upstream, typename Pred>
+struct filter_frame : combinator_frame<filter_frame<stackless, Upstream, Pred>, stackless,
+                                       upstream_reference_t<Upstream>> {
+  Upstream upstream_;
+  Pred pred_;
+
+  filter_frame(Upstream&& upstream, Pred pred)
+      : upstream_(std::move(upstream)), pred_(std::move(pred)) {}
+
+  stackless_coroutine_handle<void> doStepImpl() {
+    switch (this->suspendIdx_) {
+      case 0:
+        break;
+      case 1:
+        goto label_1;
+    }
+
+    CO_GET(initial_awaiter_).await_resume();
+    this->initial_awaiter_.destroy();
+    while (step(this->upstream_)) {
+      if (this->pred_(current(this->upstream_))) {
+        CO_YIELD(1, initial_awaiter_, current(this->upstream_));
+      }
+    }
+    CO_RETURN_VOID(2, final_awaiter_);
+  }
+
+  void destroySuspendedCoro(size_t suspendIdx_) {
+    switch (suspendIdx_) {
+      case 0:
+      case 1:
+        this->initial_awaiter_.destroy();
+        return;
+      case 2:
+        return;
+    }
+  }
+};
+
+/**
+ * template <typename Upstream>
+ * generator<upstream_reference_t<Upstream>> take(Upstream up, size_t n) {
+ *   for (size_t i = 0; i < n && <up has another element x>; ++i) co_yield x;
+ * }
+ * The upstream is not resumed once `n` elements have been yielded.
+ */
+template <bool stackless, typename Upstream>
+struct take_frame
+    : combinator_frame<take_frame<stackless, Upstream>, stackless, upstream_reference_t<Upstream>> {
+  Upstream upstream_;
+  size_t n_;
+  size_t i_ = 0;
+
+  take_frame(Upstream&& upstream, size_t n) : upstream_(std::move(upstream)), n_(n) {}
+
+  stackless_coroutine_handle<void> doStepImpl() {
+    switch (this->suspendIdx_) {
+      case 0:
+        break;
+      case 1:
+        goto label_1;
+    }
+
+    CO_GET(initial_awaiter_).await_resume();
+    this->initial_awaiter_.destroy();
+    for (this->i_ = 0; this->i_ < this->n_ && step(this->upstream_); ++this->i_) {
+      CO_YIELD(1, initial_awaiter_, current(this->upstream_));
+    }
+    CO_RETURN_VOID(2, final_awaiter_);
+  }
+
+  void destroySuspendedCoro(size_t suspendIdx_) {
+    switch (suspendIdx_) {
+      case 0:
+      case 1:
+        this->initial_awaiter_.destroy();
+        return;
+      case 2:
+        return;
+    }
+  }
+};
+
+/**
+ * template <typename A, typename B>
+ * generator<std::pair<upstream_reference_t<A>, upstream_reference_t<B>>> zip(A a, B b) {
+ *   while (<a has another element x> && <b has another element y>) co_yield {x, y};
+ * }
+ */
+template <bool stackless, typename A, typename B>
+struct zip_frame
+    : combinator_frame<zip_frame<stackless, A, B>, stackless,
+                       std::pair<upstream_reference_t<A>, upstream_reference_t<B>>> {
+  using pair_type = std::pair<upstream_reference_t<A>, upstream_reference_t<B>>;
+  A a_;
+  B b_;
+
+  // Value-initialized for the same reason as `map_frame::tmp_`.
+  coro_storage<pair_type&&, true> tmp_{};
+  struct {
+    bool tmp_ = false;
+  } __constructed;
+
+  zip_frame(A&& a, B&& b) : a_(std::move(a)), b_(std::move(b)) {}
+
+  stackless_coroutine_handle<void> doStepImpl() {
+    switch (this->suspendIdx_) {
+      case 0:
+        break;
+      case 1:
+        goto label_1;
+    }
+
+    CO_GET(initial_awaiter_).await_resume();
+    this->initial_awaiter_.destroy();
+    while (step(this->a_) && step(this->b_)) {
+      CO_INIT_EX(tmp_, (pair_type{current(this->a_), current(this->b_)}));
+      CO_YIELD(1, initial_awaiter_, CO_GET(tmp_));
+      DESTROY_UNCONDITIONALLY(tmp_);
+    }
+    CO_RETURN_VOID(2, final_awaiter_);
+  }
+
+  void destroySuspendedCoro(size_t suspendIdx_) {
+    switch (suspendIdx_) {
+      case 0:
+        this->initial_awaiter_.destroy();
+        return;
+      case 1:
+        this->initial_awaiter_.destroy();
+        this->tmp_.destroy();
+        return;
+      case 2:
+        return;
+    }
+  }
+
+  void destroyLocals() { DESTROY_IF_CONSTRUCTED(tmp_); }
+};
+
+/**
+ * template <typename A, typename B>
+ * generator<upstream_reference_t<A>> concat(A a, B b) {
+ *   for (auto&& x : a) co_yield x;
+ *   for (auto&& x : b) co_yield x;
+ * }
+ */
+template <bool stackless, typename A, typename B>
+struct concat_frame
+    : combinator_frame<concat_frame<stackless, A, B>, stackless, upstream_reference_t<A>> {
+  static_assert(std::is_same_v<upstream_reference_t<A>, upstream_reference_t<B>>,
+                "`concat` requires generators with the same reference type");
+  A a_;
+  B b_;
+
+  concat_frame(A&& a, B&& b) : a_(std::move(a)), b_(std::move(b)) {}
+
+  stackless_coroutine_handle<void> doStepImpl() {
+    switch (this->suspendIdx_) {
+      case 0:
+        break;
+      case 1:
+        goto label_1;
+      case 2:
+        goto label_2;
+    }
+
+    CO_GET(initial_awaiter_).await_resume();
+    this->initial_awaiter_.destroy();
+    while (step(this->a_)) {
+      CO_YIELD(1, initial_awaiter_, current(this->a_));
+    }
+    while (step(this->b_)) {
+      CO_YIELD(2, initial_awaiter_, current(this->b_));
+    }
+    CO_RETURN_VOID(3, final_awaiter_);
+  }
+
+  void destroySuspendedCoro(size_t suspendIdx_) {
+    switch (suspendIdx_) {
+      case 0:
+      case 1:
+      case 2:
+        this->initial_awaiter_.destroy();
+        return;
+      case 3:
+        return;
+    }
+  }
+};
+
+// Closures for the pipe syntax `gen | map(f)`.
+template <typename F>
+struct map_closure {
+  F f_;
+};
+
+template <typename Pred>
+struct filter_closure {
+  Pred pred_;
+};
+
+struct take_closure {
+  size_t n_;
+};
+}  // namespace combinators_detail
+
+namespace combinators {
+
+template <typename T, typename Policy, typename F>
+auto map(unified_generator<T, Policy>&& gen, F f) {
+  using Gen = unified_generator<T, Policy>;
+  using Frame = combinators_detail::map_frame<combinators_detail::is_stackless_v<Gen>, Gen, F>;
+  return combinators_detail::make_combinator<Frame>(std::move(gen), std::move(f));
+}
+
+template <typename T, typename Policy, typename Pred>
+auto filter(unified_generator<T, Policy>&& gen, Pred pred) {
+  using Gen = unified_generator<T, Policy>;
+  using Frame =
+      combinators_detail::filter_frame<combinators_detail::is_stackless_v<Gen>, Gen, Pred>;
+  return combinators_detail::make_combinator<Frame>(std::move(gen), std::move(pred));
+}
+
+template <typename T, typename Policy>
+auto take(unified_generator<T, Policy>&& gen, size_t n) {
+  using Gen = unified_generator<T, Policy>;
+  using Frame = combinators_detail::take_frame<combinators_detail::is_stackless_v<Gen>, Gen>;
+  return combinators_detail::make_combinator<Frame>(std::move(gen), n);
+}
+
+template <typename T1, typename P1, typename T2, typename P2>
+auto zip(unified_generator<T1, P1>&& a, unified_generator<T2, P2>&& b) {
+  using A = unified_generator<T1, P1>;
+  using B = unified_generator<T2, P2>;
+  using Frame = combinators_detail::zip_frame<combinators_detail::is_stackless_v<A, B>, A, B>;
+  return combinators_detail::make_combinator<Frame>(std::move(a), std::move(b));
+}
+
+template <typename T1, typename P1, typename T2, typename P2>
+auto concat(unified_generator<T1, P1>&& a, unified_generator<T2, P2>&& b) {
+  using A = unified_generator<T1, P1>;
+  using B = unified_generator<T2, P2>;
+  using Frame = combinators_detail::concat_frame<combinators_detail::is_stackless_v<A, B>, A, B>;
+  return combinators_detail::make_combinator<Frame>(std::move(a), std::move(b));
+}
+
+template <typename F>
+combinators_detail::map_closure<F> map(F f) {
+  return {std::move(f)};
+}
+
+template <typename Pred>
+combinators_detail::filter_closure<Pred> filter(Pred pred) {
+  return {std::move(pred)};
+}
+
+inline combinators_detail::take_closure take(size_t n) { return {n}; }
+}  // namespace combinators
+
+namespace combinators_detail {
+template <typename T, typename Policy, typename F>
+auto operator|(unified_generator<T, Policy>&& gen, map_closure<F> closure) {
+  return combinators::map(std::move(gen), std::move(closure.f_));
+}
+
+template <typename T, typename Policy, typename Pred>
+auto operator|(unified_generator<T, Policy>&& gen, filter_closure<Pred> closure) {
+  return combinators::filter(std::move(gen), std::move(closure.pred_));
+}
+
+template <typename T, typename Policy>
+auto operator|(unified_generator<T, Policy>&& gen, take_closure closure) {
+  return combinators::take(std::move(gen), closure.n_);
+}
+}  // namespace combinators_detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_COMBINATORS_H
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include "./any_generator.h"
+#include "./combinators.h"
+#include "./iota_unified.h"
+#include "./variant_generator.h"
+
+// The pipeline `iota(0, n) | filter(even) | map(3 * x) | take(n / 4)`, summed up.
+namespace {
+auto isEven = [](int i) { return i % 2 == 0; };
+auto timesThree = [](int i) { return 3 * i; };
+}  // namespace
+
+// The hand-written loop that the pipeline is equivalent to.
+static void BM_PipelineHandLoop(benchmark::State& state) {
+  const int n = state.range(0);
+  for (auto _ : state) {
+    int sum = 0;
+    size_t taken = 0;
+    for (int i = 0; i < n && taken < static_cast<size_t>(n / 4); ++i) {
+      if (isEven(i)) {
+        sum += timesThree(i);
+        ++taken;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// All the frames are nested inline frames.
+static void BM_PipelineInline(benchmark::State& state) {
+  using namespace combinators;
+  const int n = state.range(0);
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = iota_unified<false>(0, n) | filter(isEven) | map(timesThree) | take(n / 4);
+    gen.for_each([&sum](int val) { sum += val; });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Every stage is a heap-allocated frame.
+static void BM_PipelineHeap(benchmark::State& state) {
+  using namespace combinators;
+  const int n = state.range(0);
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = iota_unified<true>(0, n) | filter(isEven) | map(timesThree) | take(n / 4);
+    gen.for_each([&sum](int val) { sum += val; });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// A function that returns one of two generators, chosen at runtime (alternating between the
+// iterations), either type-erased on the heap, type-erased in the buffer of an `any_generator`, or
+// as a `variant_generator`.
+namespace {
+heap_generator<int> heapIotaOrTimesThree(bool timesThreeSelected, int n) {
+  auto iota = iota_unified<true>(0, n);
+  if (timesThreeSelected) return std::move(iota) | combinators::map(timesThree);
+  return iota;
+}
+
+any_generator<int> anyIotaOrTimesThree(bool timesThreeSelected, int n) {
+  auto iota = iota_unified<false>(0, n);
+  if (timesThreeSelected) return make_any_generator(std::move(iota) | combinators::map(timesThree));
+  return make_any_generator(std::move(iota));
+}
+
+using IotaFrame = inline_frame_t<decltype(iota_unified<false>(0, 0))>;
+using TimesThreeFrame =
+    inline_frame_t<decltype(iota_unified<false>(0, 0) | combinators::map(timesThree))>;
+
+variant_generator<IotaFrame, TimesThreeFrame> variantIotaOrTimesThree(bool timesThreeSelected,
+                                                                      int n) {
+  auto iota = iota_unified<false>(0, n);
+  if (timesThreeSelected) {
+    return make_variant_generator<IotaFrame, TimesThreeFrame>(std::move(iota) |
+                                                              combinators::map(timesThree));
+  }
+  return make_variant_generator<IotaFrame, TimesThreeFrame>(std::move(iota));
+}
+}  // namespace
+
+static void BM_ChoiceHeap(benchmark::State& state) {
+  const int n = state.range(0);
+  bool selected = false;
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = heapIotaOrTimesThree(selected = !selected, n);
+    for (int val : gen) {
+      sum += val;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+static void BM_ChoiceAny(benchmark::State& state) {
+  const int n = state.range(0);
+  bool selected = false;
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = anyIotaOrTimesThree(selected = !selected, n);
+    for (int val : gen) {
+      sum += val;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+static void BM_ChoiceVariant(benchmark::State& state) {
+  const int n = state.range(0);
+  bool selected = false;
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = variantIotaOrTimesThree(selected = !selected, n);
+    for (int val : gen) {
+      sum += val;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+BENCHMARK(BM_PipelineHandLoop)->Arg(10)->Arg(10000);
+BENCHMARK(BM_PipelineInline)->Arg(10)->Arg(10000);
+BENCHMARK(BM_PipelineHeap)->Arg(10)->Arg(10000);
+BENCHMARK(BM_ChoiceHeap)->Arg(10)->Arg(10000);
+BENCHMARK(BM_ChoiceAny)->Arg(10)->Arg(10000);
+BENCHMARK(BM_ChoiceVariant)->Arg(10)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,114 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_EXPECTED_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_EXPECTED_GENERATOR_H
+
+// A generator with a typed error channel. The generator reports errors of type `E` as values,
+// either via `co_yield generator_error{e}` (recoverable: the consumer can clear the error and
+// continue) or via `co_return generator_error{e}` (terminal). The consumer's iteration stops at an
+// error, and the error can then be inspected via `has_error()` and `error()`. No exception objects
+// are allocated and no stack is unwound, so errors cost the same as values.
+//
+// Note: In C++20 a promise cannot have both `return_void` and `return_value`, so in actual C++20
+// coroutines the terminal error would have to be expressed as `co_yield` followed by `co_return`.
+// The hand-written frames in this repository can use both.
+
+#include <optional>
+#include <utility>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_handle.h"
+
+// Wrapper for errors that are yielded or returned from an `expected_generator`.
+template <typename E>
+struct generator_error {
+  E error_;
+};
+
+template <typename E>
+generator_error(E) -> generator_error<E>;
+
+template <typename T, typename E>
+class expected_generator;
+
+namespace detail {
+template <typename T, typename E>
+class expected_generator_promise : public unified_generator_promise<T> {
+ public:
+  using unified_generator_promise<T>::yield_value;
+
+  expected_generator<T, E> get_return_object() noexcept;
+
+  SuspendAlways yield_value(generator_error<E> error) {
+    m_error.emplace(std::move(error.error_));
+    return {};
+  }
+
+  void return_value(generator_error<E> error) { m_error.emplace(std::move(error.error_)); }
+
+  bool has_error() const noexcept { return m_error.has_value(); }
+  E& error() noexcept { return *m_error; }
+  const E& error() const noexcept { return *m_error; }
+  void clear_error() noexcept { m_error.reset(); }
+
+ private:
+  std::optional<E> m_error;
+};
+
+// The handle of an `expected_generator`. A pending error makes the generator look `done()` to the
+// generic code in `unified_generator` (iterators, `for_each`, `next_chunk`), which thus stops at an
+// error without any additional checks.
+template <typename Promise>
+struct expected_generator_handle : stackless_coroutine_handle<Promise> {
+  using base = stackless_coroutine_handle<Promise>;
+  using base::base;
+  using base::operator=;
+
+  expected_generator_handle(base h) noexcept : base(h) {}
+
+  bool done() const { return base::done() || this->promise().has_error(); }
+
+  // Whether the frame has actually run to completion (e.g. after a terminal error).
+  bool frame_done() const { return base::done(); }
+};
+}  // namespace detail
+
+template <typename T, typename E>
+struct ExpectedGeneratorPolicy {
+  using promise_type = detail::expected_generator_promise<T, E>;
+  using handle_type = detail::expected_generator_handle<promise_type>;
+  static constexpr bool nullable = true;
+};
+
+template <typename T, typename E>
+class [[nodiscard]] expected_generator
+    : public unified_generator<T, ExpectedGeneratorPolicy<T, E>> {
+  using Base = unified_generator<T, ExpectedGeneratorPolicy<T, E>>;
+
+ public:
+  using Base::Base;
+  using error_type = E;
+
+  bool has_error() const noexcept { return this->handle() && this->handle().promise().has_error(); }
+
+  // Precondition: `has_error()`.
+  E& error() noexcept { return this->handle().promise().error(); }
+  const E& error() const noexcept { return this->handle().promise().error(); }
+
+  // Clear a pending error. Returns true if the error was yielded, then the consumer can continue
+  // with the remaining values via `begin()`. Returns false after a returned (terminal) error or at
+  // the end of the generator.
+  bool clear_error() noexcept {
+    if (!this->handle()) return false;
+    this->handle().promise().clear_error();
+    return !this->handle().frame_done();
+  }
+};
+
+namespace detail {
+template <typename T, typename E>
+expected_generator<T, E> expected_generator_promise<T, E>::get_return_object() noexcept {
+  using handle_t = stackless_coroutine_handle<expected_generator_promise<T, E>>;
+  return expected_generator<T, E>{handle_t::from_promise(*this)};
+}
+}  // namespace detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_EXPECTED_GENERATOR_H
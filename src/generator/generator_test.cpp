@@ -0,0 +1,985 @@
+// Unit tests for the unified generators.
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "generator/any_generator.h"
+#include "generator/arithmetic_generator.h"
+#include "generator/async_generator_example.h"
+#include "generator/channel_generator.h"
+#include "generator/combinators.h"
+#include "generator/iota_unified.h"
+#include "generator/parse_ints.h"
+#include "generator/prefetch.h"
+#include "generator/sliding_windows.h"
+#include "generator/string_prepend.h"
+#include "generator/throwing_parse_ints.h"
+#include "generator/tree_walk.h"
+#include "generator/variant_generator.h"
+#include "task/channel_example.h"
+
+namespace {
+template <typename T = int, typename Generator>
+std::vector<T> toVector(Generator&& gen) {
+  std::vector<T> result;
+  for (auto val : gen) {
+    result.push_back(val);
+  }
+  return result;
+}
+}  // namespace
+
+// ============================================================================
+// MemoryResourceGeneratorTest - Generator frames allocated from a memory resource
+// ============================================================================
+
+TEST(MemoryResourceGeneratorTest, FramesAreAllocatedFromTheArena) {
+  alignas(std::max_align_t) char buffer[1024];
+  std::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource()};
+  // The `null_memory_resource` throws if the arena runs out of memory, so this also checks that
+  // the frames really are placed inside the `buffer`.
+  auto first = iota_unified(std::allocator_arg, &arena, 0, 3);
+  auto second = iota_unified(std::allocator_arg, &arena, 10, 12);
+  EXPECT_EQ(toVector(first), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(toVector(second), (std::vector<int>{10, 11}));
+}
+
+TEST(MemoryResourceGeneratorTest, DefaultAllocationIsUnchanged) {
+  EXPECT_EQ(toVector(iota_unified(0, 3)), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(toVector(iota_unified<false>(0, 3)), (std::vector<int>{0, 1, 2}));
+}
+
+// ============================================================================
+// SmallBufferGeneratorTest - Generators that store small frames inline
+// ============================================================================
+
+TEST(SmallBufferGeneratorTest, SmallFrameIsStoredInline) {
+  auto gen = iota_small_buffer(0, 4);
+  EXPECT_TRUE(gen.frame_is_inline());
+  EXPECT_EQ(toVector(gen), (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(SmallBufferGeneratorTest, LargeFrameFallsBackToTheHeap) {
+  auto gen = iota_small_buffer<8>(0, 4);
+  EXPECT_FALSE(gen.frame_is_inline());
+  EXPECT_EQ(toVector(gen), (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(SmallBufferGeneratorTest, MoveRelocatesSuspendedFrame) {
+  auto gen = iota_small_buffer(0, 5);
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 0);
+  ++it;
+  EXPECT_EQ(*it, 1);
+  // Move the generator while it is suspended in the middle of the loop.
+  auto moved = std::move(gen);
+  EXPECT_FALSE(gen.frame_is_inline());
+  EXPECT_TRUE(moved.frame_is_inline());
+  std::vector<int> rest;
+  for (auto it2 = moved.begin(); it2 != moved.end(); ++it2) {
+    rest.push_back(*it2);
+  }
+  EXPECT_EQ(rest, (std::vector<int>{2, 3, 4}));
+}
+
+TEST(SmallBufferGeneratorTest, SwapAndEarlyDestruction) {
+  auto a = iota_small_buffer(0, 100);
+  auto b = iota_small_buffer(10, 13);
+  a.begin();
+  swap(a, b);
+  EXPECT_TRUE(a.frame_is_inline());
+  EXPECT_TRUE(b.frame_is_inline());
+  EXPECT_EQ(toVector(a), (std::vector<int>{10, 11, 12}));
+  // `b` is destroyed while it is suspended inside the loop.
+}
+
+namespace {
+// Lowered version of
+//   small_generator<std::string, 256> growingWords(size_t n) {
+//     for (std::string word; word.size() < n;) { word += 'a'; co_yield word; }
+//   }
+// The yielded `word` is a local of the frame, and short enough for the small string buffer, so it
+// points into the frame itself. Only a `Relocatable` frame is stored inside the buffer.
+template <bool Relocatable>
+small_generator<std::string, 256> growingWords(size_t n) {
+  using promise_type = small_generator<std::string, 256>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    // The implicit move constructor moves the `word_`.
+    using is_relocatable [[maybe_unused]] = std::bool_constant<Relocatable>;
+    size_t n_;
+    std::string word_;
+
+    CoroFrame(size_t n) : n_(n) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (this->word_.size() < this->n_) {
+        this->word_ += 'a';
+        CO_YIELD(1, initial_awaiter_, this->word_);
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      if (suspendIdx_ < 2) {
+        this->initial_awaiter_.destroy();
+      }
+    }
+  };
+  return CoroFrame::template ramp_in_buffer<small_generator<std::string, 256>>(n);
+}
+
+// Lowered version of
+//   small_generator<int> squaresInBatches(int n) {
+//     int batch[4];
+//     for (int i = 0; i < n; i += 4) {
+//       for (int k = 0; k < 4; ++k) batch[k] = (i + k) * (i + k);
+//       co_yield generator_chunk<int>{batch, 4};
+//     }
+//   }
+small_generator<int> squaresInBatches(int n) {
+  using promise_type = small_generator<int>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using is_relocatable [[maybe_unused]] = std::true_type;
+    int n_;
+    int i_ = 0;
+    int batch_[4] = {};
+
+    CoroFrame(int n) : n_(n) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      for (; this->i_ < this->n_; this->i_ += 4) {
+        for (int k = 0; k < 4; ++k) {
+          this->batch_[k] = (this->i_ + k) * (this->i_ + k);
+        }
+        CO_YIELD(1, initial_awaiter_, (generator_chunk<int>{this->batch_, 4}));
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      if (suspendIdx_ < 2) {
+        this->initial_awaiter_.destroy();
+      }
+    }
+  };
+  return CoroFrame::template ramp_in_buffer<small_generator<int>>(n);
+}
+}  // namespace
+
+TEST(SmallBufferGeneratorTest, OnlyRelocatableFramesAreStoredInline) {
+  auto relocatable = growingWords<true>(3);
+  auto other = growingWords<false>(3);
+  EXPECT_TRUE(relocatable.frame_is_inline());
+  EXPECT_FALSE(other.frame_is_inline());
+  EXPECT_EQ(toVector<std::string>(other), (std::vector<std::string>{"a", "aa", "aaa"}));
+}
+
+TEST(SmallBufferGeneratorTest, MoveRebasesValueThatPointsIntoTheFrame) {
+  auto gen = growingWords<true>(4);
+  auto it = gen.begin();
+  ++it;
+  ASSERT_EQ(*it, "aa");
+  auto moved = std::move(gen);
+  ASSERT_TRUE(moved.frame_is_inline());
+  // The current value is the `word_` inside the relocated frame.
+  EXPECT_EQ(moved.handle().promise().value(), "aa");
+  EXPECT_EQ(toVector<std::string>(moved), (std::vector<std::string>{"aaa", "aaaa"}));
+}
+
+TEST(SmallBufferGeneratorTest, MoveRebasesBatchThatPointsIntoTheFrame) {
+  auto gen = squaresInBatches(8);
+  ASSERT_TRUE(gen.frame_is_inline());
+  // Move the generator between the resume and the consumption of the batch.
+  gen.handle().resume();
+  auto moved = std::move(gen);
+  auto chunk = moved.handle().promise().take_chunk();
+  const auto* begin = reinterpret_cast<const char*>(&moved);
+  const auto* data = reinterpret_cast<const char*>(chunk.data());
+  EXPECT_TRUE(data >= begin && data < begin + sizeof(moved));
+  EXPECT_EQ(std::vector<int>(chunk.begin(), chunk.end()), (std::vector<int>{0, 1, 4, 9}));
+  chunk = moved.next_chunk();
+  EXPECT_EQ(std::vector<int>(chunk.begin(), chunk.end()), (std::vector<int>{16, 25, 36, 49}));
+  EXPECT_TRUE(moved.next_chunk().empty());
+}
+
+// ============================================================================
+// ChunkedGeneratorTest - Batched yields and chunk-wise consumption
+// ============================================================================
+
+namespace {
+template <typename Generator>
+std::vector<int> chunksToVector(Generator&& gen, std::vector<size_t>* chunkSizes = nullptr) {
+  std::vector<int> result;
+  for (const auto& chunk : gen.chunks()) {
+    if (chunkSizes) chunkSizes->push_back(chunk.size());
+    result.insert(result.end(), chunk.begin(), chunk.end());
+  }
+  return result;
+}
+}  // namespace
+
+TEST(ChunkedGeneratorTest, BatchesArePassedThrough) {
+  std::vector<size_t> sizes;
+  auto values = chunksToVector(iota_chunked<true, 4>(0, 10), &sizes);
+  EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  EXPECT_EQ(sizes, (std::vector<size_t>{4, 4, 2}));
+}
+
+TEST(ChunkedGeneratorTest, InlineGenerator) {
+  std::vector<size_t> sizes;
+  auto values = chunksToVector(iota_chunked<false, 3>(5, 9), &sizes);
+  EXPECT_EQ(values, (std::vector<int>{5, 6, 7, 8}));
+  EXPECT_EQ(sizes, (std::vector<size_t>{3, 1}));
+}
+
+TEST(ChunkedGeneratorTest, SingleValuesBecomeChunksOfSizeOne) {
+  auto gen = iota_unified(0, 3);
+  std::vector<size_t> sizes;
+  EXPECT_EQ(chunksToVector(gen, &sizes), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(sizes, (std::vector<size_t>{1, 1, 1}));
+  EXPECT_TRUE(gen.next_chunk().empty());
+}
+
+TEST(ChunkedGeneratorTest, IteratorsVisitTheValuesOfBatches) {
+  using namespace combinators;
+  EXPECT_EQ(toVector(iota_chunked<true, 4>(0, 6)), (std::vector<int>{0, 1, 2, 3, 4, 5}));
+  std::vector<int> visited;
+  iota_chunked<false, 3>(5, 9).for_each([&](int val) { visited.push_back(val); });
+  EXPECT_EQ(visited, (std::vector<int>{5, 6, 7, 8}));
+  auto doubled = iota_chunked<false, 3>(0, 5) | map([](int val) { return 2 * val; });
+  EXPECT_EQ(toVector(doubled), (std::vector<int>{0, 2, 4, 6, 8}));
+}
+
+TEST(ChunkedGeneratorTest, EmptyRange) {
+  EXPECT_TRUE(iota_chunked(3, 3).next_chunk().empty());
+  EXPECT_TRUE(heap_generator<int>{}.next_chunk().empty());
+}
+
+// ============================================================================
+// InternalIterationTest - for_each and fold
+// ============================================================================
+
+TEST(InternalIterationTest, ForEachVisitsAllValues) {
+  std::vector<int> heap;
+  iota_unified(0, 4).for_each([&](int val) { heap.push_back(val); });
+  EXPECT_EQ(heap, (std::vector<int>{0, 1, 2, 3}));
+  std::vector<int> inl;
+  iota_unified<false>(0, 4).for_each([&](int val) { inl.push_back(val); });
+  EXPECT_EQ(inl, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(InternalIterationTest, ForEachAfterBeginVisitsRemainingValues) {
+  auto gen = iota_unified(0, 4);
+  EXPECT_EQ(*gen.begin(), 0);
+  std::vector<int> rest;
+  gen.for_each([&](int val) { rest.push_back(val); });
+  EXPECT_EQ(rest, (std::vector<int>{1, 2, 3}));
+  // Exhausted generators and empty heap generators are no-ops.
+  gen.for_each([&](int val) { rest.push_back(val); });
+  heap_generator<int>{}.for_each([&](int val) { rest.push_back(val); });
+  EXPECT_EQ(rest.size(), 3u);
+}
+
+TEST(InternalIterationTest, Fold) {
+  EXPECT_EQ(iota_unified(1, 5).fold(0, [](int acc, int val) { return acc + val; }), 10);
+  EXPECT_EQ(iota_unified<false>(1, 5).fold(1, [](int acc, int val) { return acc * val; }), 24);
+  EXPECT_EQ(iota_small_buffer(3, 3).fold(7, [](int acc, int val) { return acc + val; }), 7);
+}
+
+// ============================================================================
+// RecursiveGeneratorTest - Nested generators via elements_of
+// ============================================================================
+
+TEST(RecursiveGeneratorTest, TreeWalkInOrder) {
+  /*
+   *        4
+   *      /   \
+   *     2     6
+   *    / \     \
+   *   1   3     7
+   */
+  tree_node n1{1}, n3{3}, n7{7};
+  tree_node n2{2, &n1, &n3};
+  tree_node n6{6, nullptr, &n7};
+  tree_node root{4, &n2, &n6};
+  EXPECT_EQ(toVector(tree_walk(&root)), (std::vector<int>{1, 2, 3, 4, 6, 7}));
+  EXPECT_TRUE(toVector(tree_walk(nullptr)).empty());
+}
+
+TEST(RecursiveGeneratorTest, DeepNesting) {
+  EXPECT_EQ(toVector(nested_recursive(1000, 3)), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(toVector(nested_reyield(10, 3)), (std::vector<int>{0, 1, 2}));
+  EXPECT_TRUE(toVector(nested_recursive(5, 0)).empty());
+}
+
+TEST(RecursiveGeneratorTest, EarlyDestructionDestroysNestedFrames) {
+  auto gen = nested_recursive(50, 10);
+  int count = 0;
+  for (int val : gen) {
+    EXPECT_EQ(val, count);
+    if (++count == 4) break;
+  }
+}
+
+// ============================================================================
+// CombinatorsTest - map/filter/take/zip/concat on inline and heap generators
+// ============================================================================
+
+TEST(CombinatorsTest, InlinePipeline) {
+  using namespace combinators;
+  auto gen = iota_unified<false>(0, 100) | filter([](int i) { return i % 2 == 0; }) |
+             map([](int i) { return 3 * i; }) | take(4);
+  // The whole pipeline is a single inline frame.
+  static_assert(!decltype(gen)::policy_type::nullable);
+  EXPECT_EQ(toVector(gen), (std::vector<int>{0, 6, 12, 18}));
+}
+
+TEST(CombinatorsTest, HeapPipeline) {
+  using namespace combinators;
+  auto gen = iota_unified(0, 100) | filter([](int i) { return i % 2 == 0; }) |
+             map([](int i) { return 3 * i; }) | take(4);
+  static_assert(decltype(gen)::policy_type::nullable);
+  EXPECT_EQ(toVector(gen), (std::vector<int>{0, 6, 12, 18}));
+}
+
+TEST(CombinatorsTest, TakeDoesNotOverrun) {
+  using namespace combinators;
+  EXPECT_EQ(toVector(iota_unified<false>(0, 3) | take(10)), (std::vector<int>{0, 1, 2}));
+  EXPECT_TRUE(toVector(iota_unified(0, 3) | take(0)).empty());
+}
+
+TEST(CombinatorsTest, MapToNonTrivialType) {
+  using namespace combinators;
+  std::vector<std::string> result;
+  for (const std::string& s : iota_unified<false>(1, 4) | map([](int i) {
+                                return std::string(static_cast<size_t>(i), 'x');
+                              })) {
+    result.push_back(s);
+  }
+  EXPECT_EQ(result, (std::vector<std::string>{"x", "xx", "xxx"}));
+}
+
+TEST(CombinatorsTest, Zip) {
+  using namespace combinators;
+  std::vector<std::pair<int, int>> result;
+  for (const auto& [a, b] : zip(iota_unified<false>(0, 3), iota_unified(10, 20))) {
+    result.emplace_back(a, b);
+  }
+  EXPECT_EQ(result, (std::vector<std::pair<int, int>>{{0, 10}, {1, 11}, {2, 12}}));
+}
+
+TEST(CombinatorsTest, Concat) {
+  using namespace combinators;
+  EXPECT_EQ(toVector(concat(iota_unified<false>(0, 2), iota_unified<false>(5, 7))),
+            (std::vector<int>{0, 1, 5, 6}));
+  EXPECT_EQ(toVector(concat(iota_unified(0, 0), iota_unified(5, 7))), (std::vector<int>{5, 6}));
+}
+
+TEST(CombinatorsTest, ExceptionsArePropagated) {
+  using namespace combinators;
+  auto throwAtThree = [](int i) {
+    if (i == 3) throw std::runtime_error("three");
+    return i;
+  };
+  auto inlineGen = iota_unified<false>(0, 10) | map(throwAtThree);
+  std::vector<int> result;
+  EXPECT_THROW(
+      {
+        for (int i : inlineGen) result.push_back(i);
+      },
+      std::runtime_error);
+  EXPECT_EQ(result, (std::vector<int>{0, 1, 2}));
+
+  auto heapGen = iota_unified(0, 10) | filter([](int) { return true; }) | map(throwAtThree);
+  EXPECT_THROW(toVector(heapGen), std::runtime_error);
+}
+
+TEST(CombinatorsTest, EarlyDestruction) {
+  using namespace combinators;
+  auto gen = iota_unified(0, 100) | map([](int i) { return std::to_string(i); });
+  auto it = gen.begin();
+  EXPECT_EQ(*it, "0");
+  ++it;
+  EXPECT_EQ(*it, "1");
+}
+
+// ============================================================================
+// PrefetchTest - Generators that are run on a worker thread
+// ============================================================================
+
+TEST(PrefetchTest, ValuesArriveInOrder) {
+  std::vector<int> expected;
+  for (int i = 0; i < 10000; ++i) expected.push_back(i);
+  EXPECT_EQ(toVector(prefetch(iota_unified(0, 10000), 16)), expected);
+  EXPECT_EQ(toVector(prefetch(iota_unified<false>(0, 10000), 1)), expected);
+  EXPECT_TRUE(toVector(prefetch(iota_unified(0, 0))).empty());
+}
+
+TEST(PrefetchTest, NonTrivialValues) {
+  using namespace combinators;
+  std::vector<std::string> result;
+  for (const std::string& s :
+       prefetch(iota_unified(0, 100) | map([](int i) { return std::to_string(i); }), 4)) {
+    result.push_back(s);
+  }
+  ASSERT_EQ(result.size(), 100u);
+  EXPECT_EQ(result[0], "0");
+  EXPECT_EQ(result[99], "99");
+}
+
+TEST(PrefetchTest, ExceptionsAreForwardedAfterTheValues) {
+  std::vector<std::string> strings{"1", "2", "notANumber", "4"};
+  std::vector<int> result;
+  EXPECT_THROW(
+      {
+        for (int i : prefetch(throwing_parse_ints(strings, false))) result.push_back(i);
+      },
+      std::invalid_argument);
+  EXPECT_EQ(result, (std::vector<int>{1, 2}));
+}
+
+TEST(PrefetchTest, EarlyDestructionCancelsTheProducer) {
+  // The upstream would run for a very long time, so this only terminates if the producer is
+  // cancelled.
+  auto gen = prefetch(iota_unified(0, INT_MAX), 8);
+  int count = 0;
+  for (int val : gen) {
+    EXPECT_EQ(val, count);
+    if (++count == 100) break;
+  }
+}
+
+// ============================================================================
+// ChannelGeneratorTest - A channel that is fed by tasks, consumed as a generator
+// ============================================================================
+
+TEST(ChannelGeneratorTest, TasksOnOtherThreadsFeedASynchronousConsumer) {
+  async_channel<size_t> channel{8};
+  auto first = produce_values(channel, 0, 500, false);
+  auto second = produce_values(channel, 500, 1000, false);
+  std::thread producers{[&] {
+    first.start();
+    second.start();
+  }};
+  std::vector<bool> seen(1000, false);
+  size_t count = 0;
+  for (size_t value : channel_generator(channel)) {
+    ASSERT_LT(value, seen.size());
+    EXPECT_FALSE(seen[value]);
+    seen[value] = true;
+    // Both producers are done once all the values have arrived.
+    if (++count == seen.size()) {
+      channel.close();
+    }
+  }
+  producers.join();
+  EXPECT_EQ(count, seen.size());
+  EXPECT_EQ(first.result(), 500u);
+  EXPECT_EQ(second.result(), 500u);
+}
+
+TEST(ChannelGeneratorTest, ClosedChannelEndsTheGenerator) {
+  async_channel<std::string> channel{4};
+  EXPECT_TRUE(channel.try_send(std::string{"a"}));
+  EXPECT_TRUE(channel.try_send(std::string{"b"}));
+  channel.close();
+  EXPECT_EQ(toVector<std::string>(channel_generator(channel)),
+            (std::vector<std::string>{"a", "b"}));
+}
+
+// ============================================================================
+// ArithmeticGeneratorTest - Sized and skippable arithmetic sequences
+// ============================================================================
+
+TEST(ArithmeticGeneratorTest, Values) {
+  EXPECT_EQ(toVector(arithmetic_sequence(0, 10, 3)), (std::vector<int>{0, 3, 6, 9}));
+  EXPECT_EQ(toVector(arithmetic_sequence(10, 0, -4)), (std::vector<int>{10, 6, 2}));
+  EXPECT_TRUE(toVector(arithmetic_sequence(5, 5)).empty());
+  EXPECT_TRUE(toVector(arithmetic_sequence(5, 0)).empty());
+  EXPECT_EQ(toVector<unsigned>(arithmetic_sequence(2u, 5u)), (std::vector<unsigned>{2, 3, 4}));
+  EXPECT_EQ(toVector<double>(arithmetic_sequence(0.0, 1.0, 0.25)),
+            (std::vector<double>{0.0, 0.25, 0.5, 0.75}));
+}
+
+TEST(ArithmeticGeneratorTest, Size) {
+  EXPECT_EQ(arithmetic_sequence(0, 10, 3).size(), 4u);
+  EXPECT_EQ(arithmetic_sequence<signed char>(-128, 127).size(), 255u);
+  EXPECT_EQ(arithmetic_sequence(0.0, 1.0, 0.3).size(), 4u);
+  EXPECT_EQ(arithmetic_generator<int>{}.size(), 0u);
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  EXPECT_THROW((void)arithmetic_sequence(0.0, inf), std::invalid_argument);
+  EXPECT_THROW((void)arithmetic_sequence(0.0, 1.0, std::nan("")), std::invalid_argument);
+  EXPECT_THROW((void)arithmetic_sequence(0.0, 1e300, 1e-300), std::invalid_argument);
+  EXPECT_THROW((void)arithmetic_sequence(0, 10, 0), std::invalid_argument);
+  EXPECT_THROW((void)arithmetic_sequence(0u, 10u, 0u), std::invalid_argument);
+  EXPECT_THROW((void)arithmetic_sequence(0.0, 1.0, 0.0), std::invalid_argument);
+
+  auto gen = arithmetic_sequence(0, 5);
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 0);
+  EXPECT_EQ(gen.size(), 4u);
+  for (; it != gen.end(); ++it) {
+  }
+  EXPECT_EQ(gen.size(), 0u);
+}
+
+TEST(ArithmeticGeneratorTest, Advance) {
+  auto gen = arithmetic_sequence(0, 100, 2);
+  gen.advance(45);
+  EXPECT_EQ(toVector(gen), (std::vector<int>{90, 92, 94, 96, 98}));
+
+  auto gen2 = arithmetic_sequence(0, 10);
+  auto it = gen2.begin();
+  EXPECT_EQ(*it, 0);
+  gen2.advance(3);
+  ++it;
+  EXPECT_EQ(*it, 4);
+  gen2.advance(100);
+  ++it;
+  EXPECT_TRUE(it == gen2.end());
+
+  // `i * step` doesn't fit into an `int` (which `unsigned short` is promoted to).
+  auto gen3 = arithmetic_sequence<short>(32767, -32768, -1);
+  gen3.advance(65533);
+  EXPECT_EQ(toVector<short>(gen3), (std::vector<short>{-32766, -32767}));
+}
+
+TEST(ArithmeticGeneratorTest, Split) {
+  auto gen = arithmetic_sequence(0, 20, 2);
+  gen.advance(1);
+  auto parts = gen.split(4);
+  ASSERT_EQ(parts.size(), 4u);
+  EXPECT_EQ(toVector(parts[0]), (std::vector<int>{2, 4, 6}));
+  EXPECT_EQ(toVector(parts[1]), (std::vector<int>{8, 10}));
+  EXPECT_EQ(toVector(parts[2]), (std::vector<int>{12, 14}));
+  EXPECT_EQ(toVector(parts[3]), (std::vector<int>{16, 18}));
+  // The original generator is unchanged.
+  EXPECT_EQ(gen.size(), 9u);
+
+  auto small = arithmetic_sequence(0, 2).split(3);
+  EXPECT_EQ(small[0].size() + small[1].size() + small[2].size(), 2u);
+  EXPECT_TRUE(toVector(small[2]).empty());
+
+  EXPECT_THROW((void)gen.split(0), std::invalid_argument);
+  EXPECT_THROW((void)arithmetic_generator<int>{}.split(0), std::invalid_argument);
+}
+
+// ============================================================================
+// InPlaceYieldTest - Values that are constructed inside the promise
+// ============================================================================
+
+TEST(InPlaceYieldTest, StringPrependReuse) {
+  std::vector<std::string> words{"a", "longer word that doesn't fit into the small buffer", "c"};
+  std::vector<std::string> expected;
+  for (const auto& s : string_prepend(words, "pre-")) expected.push_back(s);
+  std::vector<std::string> result;
+  for (const auto& s : string_prepend_reuse(words, "pre-")) result.push_back(s);
+  EXPECT_EQ(result, expected);
+  EXPECT_EQ(result[1], "pre-longer word that doesn't fit into the small buffer");
+}
+
+TEST(InPlaceYieldTest, TakeValueMovesOutOfTheBuffer) {
+  std::vector<std::string> words{"a", "b", "a very long word that doesn't fit into the SSO buffer"};
+  std::vector<std::string> result;
+  auto gen = string_prepend_reuse(words, "x");
+  for (auto it = gen.begin(); it != gen.end(); ++it) {
+    result.push_back(it.take_value());
+  }
+  EXPECT_EQ(result, (std::vector<std::string>{"xa", "xb", "x" + words[2]}));
+}
+
+TEST(InPlaceYieldTest, TakeValueCopiesLvalues) {
+  std::vector<std::string> words{"a", "b"};
+  auto gen = combinators::map(iota_unified(0, 2), [&words](int i) -> std::string& {
+    return words[static_cast<size_t>(i)];
+  });
+  for (auto it = gen.begin(); it != gen.end(); ++it) {
+    std::string value = it.take_value();
+    EXPECT_EQ(value, *it);
+  }
+  // The yielded lvalues were copied, not moved from.
+  EXPECT_EQ(words, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST(InPlaceYieldTest, EmplaceYield) {
+  std::vector<int> values{1, 2, 3, 4};
+  std::vector<std::vector<int>> result;
+  for (const auto& window : sliding_windows(values, 2)) result.push_back(window);
+  EXPECT_EQ(result, (std::vector<std::vector<int>>{{1, 2}, {2, 3}, {3, 4}}));
+  EXPECT_TRUE(toVector<std::vector<int>>(sliding_windows(values, 5)).empty());
+}
+
+TEST(InPlaceYieldTest, MovingThePromiseRebasesTheValue) {
+  // This happens when a frame in a `small_generator` is relocated.
+  detail::unified_generator_promise<std::string> promise;
+  (void)promise.yield_value(emplace_yield(size_t{40}, 'x'));
+  auto moved = std::move(promise);
+  EXPECT_EQ(moved.value(), std::string(40, 'x'));
+  EXPECT_EQ(&moved.value(), &moved.yield_buffer());
+}
+
+// ============================================================================
+// StringPrependTest - The allocation-free variants of `string_prepend`
+// ============================================================================
+
+TEST(StringPrependTest, ViewsIntoAReusedBuffer) {
+  std::vector<std::string> words{"a", "", "a longer word that doesn't fit into the SSO buffer"};
+  std::vector<std::string> result;
+  for (std::string_view s : string_prepend_view(words, "pre-")) result.emplace_back(s);
+  EXPECT_EQ(result, (std::vector<std::string>{"pre-a", "pre-", "pre-" + words[2]}));
+}
+
+TEST(StringPrependTest, LazyConcatenation) {
+  std::vector<std::string> words{"a", "", "bc"};
+  std::vector<std::string> result;
+  for (const prefixed_string& s : string_prepend_lazy(words, "pre-")) {
+    EXPECT_EQ(s.suffix().data(), words[result.size()].data());
+    EXPECT_EQ(s.size(), s.str().size());
+    EXPECT_TRUE(s == s.str());
+    result.push_back(s.str());
+  }
+  EXPECT_EQ(result, (std::vector<std::string>{"pre-a", "pre-", "pre-bc"}));
+
+  prefixed_string s{"ab", "cd"};
+  EXPECT_EQ(s[1], 'b');
+  EXPECT_EQ(s[2], 'c');
+  EXPECT_TRUE(s != "abce");
+  EXPECT_TRUE(s != "abc");
+}
+
+// ============================================================================
+// ParseIntsTest - Exception-free parsing with the semantics of `std::stoi`
+// ============================================================================
+
+TEST(ParseIntsTest, SameRulesAsStoi) {
+  for (std::string s : {"42", "-17", "+5", "  12", "\t-3", "7abc", "0x10", "2147483647",
+                        "-2147483648"}) {
+    auto result = parse_int(s);
+    ASSERT_TRUE(result.ok()) << s;
+    EXPECT_EQ(result.value_, std::stoi(s)) << s;
+  }
+  for (std::string s : {"", "abc", "+-1", "-", "  ", "+"}) {
+    EXPECT_EQ(parse_int(s).status_, parse_status::invalid_argument) << s;
+    EXPECT_THROW((void)std::stoi(s), std::invalid_argument) << s;
+  }
+  for (std::string s : {"2147483648", "-2147483649", "99999999999999999999"}) {
+    EXPECT_EQ(parse_int(s).status_, parse_status::out_of_range) << s;
+    EXPECT_THROW((void)std::stoi(s), std::out_of_range) << s;
+  }
+}
+
+TEST(ParseIntsTest, CatchErrorsSkipsInvalidAndStopsAtOutOfRange) {
+  std::vector<std::string> strings{"1", "x", "2", "99999999999", "3"};
+  std::vector<int> expected = toVector(throwing_parse_ints(strings, true));
+  std::vector<int> result;
+  for (auto r : parse_ints(strings, true)) {
+    ASSERT_TRUE(r.ok());
+    result.push_back(r.value_);
+  }
+  EXPECT_EQ(result, expected);
+  EXPECT_EQ(result, (std::vector<int>{1, 2}));
+}
+
+TEST(ParseIntsTest, ErrorsAreReportedWithoutCatchErrors) {
+  std::vector<std::string> strings{"1", "x", "2"};
+  std::vector<parse_int_result> result;
+  for (auto r : parse_ints(strings, false)) result.push_back(r);
+  ASSERT_EQ(result.size(), 2u);
+  EXPECT_EQ(result[0].value_, 1);
+  EXPECT_EQ(result[1].status_, parse_status::invalid_argument);
+}
+
+// ============================================================================
+// ExpectedGeneratorTest - Typed errors instead of exceptions
+// ============================================================================
+
+TEST(ExpectedGeneratorTest, YieldedErrorsAreRecoverable) {
+  std::vector<std::string> strings{"1", "x", "2", "y", "3"};
+  auto gen = parse_ints_expected(strings);
+  std::vector<int> values;
+  int numErrors = 0;
+  while (true) {
+    for (int v : gen) values.push_back(v);
+    if (!gen.has_error()) break;
+    EXPECT_EQ(gen.error(), parse_status::invalid_argument);
+    ++numErrors;
+    ASSERT_TRUE(gen.clear_error());
+  }
+  EXPECT_EQ(values, (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(numErrors, 2);
+  EXPECT_FALSE(gen.has_error());
+}
+
+TEST(ExpectedGeneratorTest, ReturnedErrorsAreTerminal) {
+  std::vector<std::string> strings{"1", "99999999999", "2"};
+  auto gen = parse_ints_expected(strings);
+  EXPECT_EQ(toVector(gen), (std::vector<int>{1}));
+  ASSERT_TRUE(gen.has_error());
+  EXPECT_EQ(gen.error(), parse_status::out_of_range);
+  EXPECT_FALSE(gen.clear_error());
+  EXPECT_FALSE(gen.has_error());
+}
+
+TEST(ExpectedGeneratorTest, InternalIterationStopsAtErrors) {
+  std::vector<std::string> strings{"1", "2", "x", "3"};
+  auto gen = parse_ints_expected(strings);
+  EXPECT_EQ(gen.fold(0, [](int acc, int v) { return acc + v; }), 3);
+  EXPECT_TRUE(gen.has_error());
+  ASSERT_TRUE(gen.clear_error());
+  EXPECT_EQ(gen.fold(0, [](int acc, int v) { return acc + v; }), 3);
+  EXPECT_FALSE(gen.has_error());
+  EXPECT_FALSE((expected_generator<int, parse_status>{}.has_error()));
+}
+
+// ============================================================================
+// VariantGeneratorTest - A closed set of inline frames, dispatched by index
+// ============================================================================
+
+namespace {
+auto twice = [](int i) { return 2 * i; };
+using IotaFrame = inline_frame_t<decltype(iota_unified<false>(0, 0))>;
+using TwiceFrame =
+    inline_frame_t<decltype(iota_unified<false>(0, 0) | combinators::map(twice))>;
+using IotaOrTwice = variant_generator<IotaFrame, TwiceFrame>;
+
+IotaOrTwice iotaOrTwice(bool doubled, int n) {
+  auto iota = iota_unified<false>(0, n);
+  if (doubled) {
+    return make_variant_generator<IotaFrame, TwiceFrame>(std::move(iota) |
+                                                         combinators::map(twice));
+  }
+  return make_variant_generator<IotaFrame, TwiceFrame>(std::move(iota));
+}
+}  // namespace
+
+TEST(VariantGeneratorTest, DispatchesToTheActiveFrame) {
+  static_assert(std::is_same_v<IotaOrTwice::value_type, int>);
+  auto plain = iotaOrTwice(false, 4);
+  EXPECT_EQ(plain.handle().frame.index(), 0u);
+  EXPECT_EQ(toVector(plain), (std::vector<int>{0, 1, 2, 3}));
+  auto doubled = iotaOrTwice(true, 4);
+  EXPECT_EQ(doubled.handle().frame.index(), 1u);
+  EXPECT_EQ(toVector(doubled), (std::vector<int>{0, 2, 4, 6}));
+}
+
+TEST(VariantGeneratorTest, InternalIterationAndEarlyDestruction) {
+  EXPECT_EQ(iotaOrTwice(true, 10).fold(0, [](int acc, int v) { return acc + v; }), 90);
+  auto gen = iotaOrTwice(true, 10);
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 0);
+  ++it;
+  EXPECT_EQ(*it, 2);
+}
+
+// ============================================================================
+// AnyGeneratorTest - Type-erased inline frames in a small buffer
+// ============================================================================
+
+TEST(AnyGeneratorTest, DifferentFramesInOneContainer) {
+  std::vector<any_generator<int>> gens;
+  // Growing the vector relocates the (not yet started) frames.
+  gens.push_back(make_any_generator(iota_unified<false>(0, 3)));
+  gens.push_back(make_any_generator(iota_unified<false>(0, 3) | combinators::map(twice)));
+  gens.push_back(make_any_generator(iota_unified<false>(0, 10) | combinators::take(2)));
+  EXPECT_EQ(toVector(gens[0]), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(toVector(gens[1]), (std::vector<int>{0, 2, 4}));
+  EXPECT_EQ(toVector(gens[2]), (std::vector<int>{0, 1}));
+}
+
+TEST(AnyGeneratorTest, MoveAssignmentAndEarlyDestruction) {
+  auto gen = make_any_generator(iota_unified<false>(0, 3));
+  EXPECT_EQ(gen.fold(0, [](int acc, int v) { return acc + v; }), 3);
+  gen = make_any_generator(iota_unified<false>(0, 3) | combinators::map(twice));
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 0);
+  ++it;
+  EXPECT_EQ(*it, 2);
+  auto other = std::move(gen);
+  EXPECT_FALSE(gen.handle());
+}
+
+TEST(AnyGeneratorTest, MovingAStartedGeneratorRebasesTheCurrentBatch) {
+  auto gen = make_any_generator(iota_chunked<false, 4>(0, 10));
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 0);
+  // The current batch lives in the frame. Reusing the old buffer overwrites it.
+  auto moved = std::move(gen);
+  gen = make_any_generator(iota_chunked<false, 4>(100, 110));
+  EXPECT_EQ(moved.fold(0, [](int acc, int v) { return acc + v; }), 45);
+}
+
+TEST(AnyGeneratorTest, ExceptionsArePropagated) {
+  auto gen = make_any_generator(iota_unified<false>(0, 5) | combinators::map([](int i) {
+                                  if (i == 2) throw std::runtime_error("two");
+                                  return i;
+                                }));
+  std::vector<int> values;
+  EXPECT_THROW(
+      {
+        for (int v : gen) values.push_back(v);
+      },
+      std::runtime_error);
+  EXPECT_EQ(values, (std::vector<int>{0, 1}));
+}
+
+// ============================================================================
+// AsyncGeneratorTest - Generators that await tasks, consumed by a task
+// ============================================================================
+
+TEST(AsyncGeneratorTest, ProducerAwaitsTasks) {
+  auto gen = async_compute_values(0, 10);
+  auto sum = sum_async(gen);
+  sum.start();
+  ASSERT_TRUE(sum.done());
+  // compute_value(i) == 2 * i.
+  EXPECT_EQ(sum.result(), 90u);
+}
+
+TEST(AsyncGeneratorTest, EmptyAndExhaustedGenerators) {
+  auto gen = async_compute_values(3, 3);
+  auto sum = sum_async(gen);
+  sum.start();
+  EXPECT_EQ(sum.result(), 0u);
+  // The exhausted generator doesn't yield anything else.
+  auto again = sum_async(gen);
+  again.start();
+  EXPECT_EQ(again.result(), 0u);
+  async_generator<size_t> empty;
+  auto emptySum = sum_async(empty);
+  emptySum.start();
+  EXPECT_EQ(emptySum.result(), 0u);
+}
+
+TEST(AsyncGeneratorTest, ExceptionsArePropagatedToTheConsumer) {
+  auto gen = async_compute_values(0, 10, 4);
+  auto sum = sum_async(gen);
+  sum.start();
+  ASSERT_TRUE(sum.done());
+  EXPECT_THROW(sum.result(), std::runtime_error);
+}
+
+TEST(AsyncGeneratorTest, EarlyDestruction) {
+  // The producer is never started.
+  { auto gen = async_compute_values(0, 10); }
+  // The consumer is destroyed before it awaits anything, then the producer is destroyed while it
+  // is suspended at its initial suspension point.
+  auto gen = async_compute_values(0, 10);
+  { auto sum = sum_async(gen); }
+}
+
+// ============================================================================
+// CloneTest - Forking suspended inline generators
+// ============================================================================
+
+namespace {
+// Too large to be stored by value in the promise, so the promise stores a pointer into the frame.
+struct Triple {
+  long a_, b_, c_;
+};
+
+// Lowered version of
+//   generator<Triple> triples(long n) {
+//     for (Triple t{0, 0, 0}; t.a_ < n; ++t.a_) { t.b_ = 2 * t.a_; t.c_ = 3 * t.a_; co_yield t; }
+//   }
+auto inlineTriples(long n) {
+  using promise_type = detail::unified_generator_promise<Triple>;
+  struct CoroFrame : stackful_coro_crtp<CoroFrame, promise_type, true> {
+    using is_cloneable [[maybe_unused]] = std::true_type;
+    long n_;
+    Triple t_{0, 0, 0};
+
+    CoroFrame(long n) : n_(n) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      for (; this->t_.a_ < this->n_; ++this->t_.a_) {
+        this->t_.b_ = 2 * this->t_.a_;
+        this->t_.c_ = 3 * this->t_.a_;
+        CO_YIELD(1, initial_awaiter_, this->t_);
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      if (suspendIdx_ < 2) {
+        this->initial_awaiter_.destroy();
+      }
+    }
+  };
+  return inline_gen<Triple, CoroFrame>{stackful_coroutine_handle<CoroFrame>{CoroFrame::ramp(n)}};
+}
+}  // namespace
+
+TEST(CloneTest, CloneContinuesFromTheSameSuspensionPoint) {
+  auto gen = iota_unified<false>(0, 6);
+  auto it = gen.begin();
+  ++it;
+  ++it;
+  ASSERT_EQ(*it, 2);
+  auto fork = gen.clone();
+  // The current value of the clone points into its own frame.
+  EXPECT_EQ(fork.handle().promise().value(), 2);
+  EXPECT_EQ(toVector(gen), (std::vector<int>{3, 4, 5}));
+  EXPECT_EQ(toVector(fork), (std::vector<int>{3, 4, 5}));
+}
+
+TEST(CloneTest, CloneOfUnstartedAndExhaustedGenerators) {
+  auto gen = iota_unified<false>(0, 3);
+  auto fresh = gen.clone();
+  EXPECT_EQ(toVector(gen), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(toVector(fresh), (std::vector<int>{0, 1, 2}));
+  auto exhausted = gen.clone();
+  EXPECT_TRUE(exhausted.handle().done());
+  EXPECT_TRUE(toVector(exhausted).empty());
+}
+
+TEST(CloneTest, ValuePointerFollowsTheClonedFrame) {
+  auto gen = inlineTriples(4);
+  auto it = gen.begin();
+  ++it;
+  auto fork = gen.clone();
+  const Triple& original = gen.handle().promise().value();
+  const Triple& cloned = fork.handle().promise().value();
+  EXPECT_NE(&original, &cloned);
+  EXPECT_EQ(cloned.c_, 3);
+  // Advancing the original doesn't change the current value of the clone.
+  ++it;
+  EXPECT_EQ((*it).a_, 2);
+  EXPECT_EQ(cloned.a_, 1);
+  std::vector<long> rest;
+  for (const Triple& t : fork) rest.push_back(t.b_);
+  EXPECT_EQ(rest, (std::vector<long>{4, 6}));
+}
@@ -1,5 +1,6 @@
 #include <benchmark/benchmark.h>
 
+#include "./arithmetic_generator.h"
 #include "./iota_unified.h"
 
 // Callback-based iota implementation for comparison
@@ -47,6 +48,156 @@ static void BM_UnifiedHeapIota(benchmark::State& state) {
   }
 }
 
+// Benchmarks for the internal iteration via `for_each`
+static void BM_UnifiedInlineIotaForEach(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    auto gen = iota_unified<false>(0, range);
+    int sum = 0;
+    gen.for_each([&sum](int val) { benchmark::DoNotOptimize(sum += val); });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+static void BM_UnifiedHeapIotaForEach(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    auto gen = iota_unified<true>(0, range);
+    int sum = 0;
+    gen.for_each([&sum](int val) { benchmark::DoNotOptimize(sum += val); });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Benchmark for a heap generator whose frame is stored inside the generator object
+static void BM_UnifiedSmallBufferIota(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    auto gen = iota_small_buffer(0, range);
+    int sum = 0;
+    for (int val : gen) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Benchmarks for generators that yield batches of 64 values per resume.
+template <bool stackless>
+static void BM_UnifiedIotaChunked(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    auto gen = iota_chunked<stackless>(0, range);
+    int sum = 0;
+    for (auto chunk = gen.next_chunk(); !chunk.empty(); chunk = gen.next_chunk()) {
+      for (int val : chunk) {
+        benchmark::DoNotOptimize(sum += val);
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// The arithmetic generator, which stores its whole state in the promise.
+static void BM_ArithmeticSequence(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    int sum = 0;
+    for (int val : arithmetic_sequence(0, range)) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Sum up the second half of the range, skipping the first half by resuming the generator.
+static void BM_UnifiedHeapIotaSkipHalf(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = iota_unified(0, range);
+    auto it = gen.begin();
+    for (int i = 0; i < range / 2; ++i) {
+      ++it;
+    }
+    for (; it != gen.end(); ++it) {
+      benchmark::DoNotOptimize(sum += *it);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// The same, but skipping the first half in O(1) via `advance`.
+static void BM_ArithmeticSkipHalf(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = arithmetic_sequence(0, range);
+    gen.advance(range / 2);
+    for (int val : gen) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Speculative processing: consume the first half of an inline iota, then consume the second half
+// twice (e.g. for two alternative parses). Without `clone()`, the second pass has to rerun the
+// generator from the start.
+static void BM_UnifiedInlineIotaReplay(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = iota_unified<false>(0, range);
+    auto it = gen.begin();
+    for (int i = 0; i < range / 2; ++i, ++it) {
+      benchmark::DoNotOptimize(sum += *it);
+    }
+    for (; it != gen.end(); ++it) {
+      benchmark::DoNotOptimize(sum += *it);
+    }
+    auto replay = iota_unified<false>(0, range);
+    auto it2 = replay.begin();
+    for (int i = 0; i < range / 2; ++i) {
+      ++it2;
+    }
+    for (; it2 != replay.end(); ++it2) {
+      benchmark::DoNotOptimize(sum += *it2);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// The same, but the second pass continues from a clone that was taken at the checkpoint.
+static void BM_UnifiedInlineIotaClone(benchmark::State& state) {
+  const int range = state.range(0);
+
+  for (auto _ : state) {
+    int sum = 0;
+    auto gen = iota_unified<false>(0, range);
+    auto it = gen.begin();
+    for (int i = 0; i + 1 < range / 2; ++i, ++it) {
+      benchmark::DoNotOptimize(sum += *it);
+    }
+    auto fork = gen.clone();
+    for (; it != gen.end(); ++it) {
+      benchmark::DoNotOptimize(sum += *it);
+    }
+    for (int val : fork) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
 // Benchmark for callback-based implementation
 static void BM_CallbackIota(benchmark::State& state) {
   const int range = state.range(0);
@@ -68,10 +219,20 @@ BENCHMARK(BM_UnifiedInlineIota)
     ->Arg(
 
         10);
+BENCHMARK(BM_UnifiedInlineIotaForEach)->Arg(10);
 BENCHMARK(BM_UnifiedHeapIota)
     ->Arg(
 
         10);
+BENCHMARK(BM_UnifiedHeapIotaForEach)->Arg(10);
+BENCHMARK(BM_UnifiedSmallBufferIota)->Arg(10);
+BENCHMARK_TEMPLATE(BM_UnifiedIotaChunked, false)->Arg(10);
+BENCHMARK_TEMPLATE(BM_UnifiedIotaChunked, true)->Arg(10);
+BENCHMARK(BM_ArithmeticSequence)->Arg(10);
+BENCHMARK(BM_UnifiedHeapIotaSkipHalf)->Arg(10);
+BENCHMARK(BM_ArithmeticSkipHalf)->Arg(10);
+BENCHMARK(BM_UnifiedInlineIotaReplay)->Arg(10);
+BENCHMARK(BM_UnifiedInlineIotaClone)->Arg(10);
 
 BENCHMARK(BM_CallbackIota)
     ->Arg(
@@ -81,9 +242,19 @@ BENCHMARK(BM_UnifiedInlineIota)
     ->Arg(
 
         10000);
+BENCHMARK(BM_UnifiedInlineIotaForEach)->Arg(10000);
 BENCHMARK(BM_UnifiedHeapIota)
     ->Arg(
 
         10000);
+BENCHMARK(BM_UnifiedHeapIotaForEach)->Arg(10000);
+BENCHMARK(BM_UnifiedSmallBufferIota)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_UnifiedIotaChunked, false)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_UnifiedIotaChunked, true)->Arg(10000);
+BENCHMARK(BM_ArithmeticSequence)->Arg(10000);
+BENCHMARK(BM_UnifiedHeapIotaSkipHalf)->Arg(10000);
+BENCHMARK(BM_ArithmeticSkipHalf)->Arg(10000);
+BENCHMARK(BM_UnifiedInlineIotaReplay)->Arg(10000);
+BENCHMARK(BM_UnifiedInlineIotaClone)->Arg(10000);
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -1,16 +1,84 @@
 #ifndef GENERATOR_REWRITE_EXAMPLES_IOTA_UNIFIED_H
 #define GENERATOR_REWRITE_EXAMPLES_IOTA_UNIFIED_H
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
+#include <memory_resource>
 
 #include "generator/unified_generator.h"
 #include "util/coroutine_frame.h"
 #include "util/inline_coroutine_frame.h"
 #include "util/macros.h"
+#include "util/memory_resource_allocation.h"
+
+namespace detail {
+// The actual implementation of the `iota_unified` overloads below. The `args` are either
+// `(start, end)` or `(std::allocator_arg, resource, start, end)`. If `SmallBufferGenerator` is
+// not `void`, then the frame is constructed inside the buffer of that generator type.
+template <bool stackless, typename SmallBufferGenerator = void, typename... Args>
+auto iota_unified_impl(Args&&... args) {
+  // Only frames with the allocator arguments pay for the allocation from a resource.
+  constexpr bool withResource = sizeof...(Args) == 4;
+  using base_promise = std::conditional_t<stackless, heap_generator<int>::promise_type,
+                                          detail::unified_generator_promise<int>>;
+  using promise_type =
+      std::conditional_t<withResource, resource_allocated<base_promise>, base_promise>;
+  struct CoroFrame : FrameCRTP<stackless, CoroFrame, promise_type, true> {
+    using CoroFrameBase = FrameCRTP<stackless, CoroFrame, promise_type, true>;
+    // All the locals are trivially copyable, so inline generators can be cloned, and frames in
+    // the buffer of a `small_generator` can be relocated. The values are yielded one by one.
+    using is_cloneable [[maybe_unused]] = std::true_type;
+    using is_relocatable [[maybe_unused]] = std::true_type;
+    using is_unbatched [[maybe_unused]] = std::true_type;
+    int start_;
+    int end_;
+
+    CoroFrame(int s, int e) : start_(s), end_(e) {}
+
+    // The allocator arguments are consumed by the promise's `operator new`.
+    CoroFrame(std::allocator_arg_t, std::pmr::memory_resource*, int s, int e) : CoroFrame(s, e) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (this->start_ < this->end_) {
+        CO_YIELD(1, initial_awaiter_, (this->start_));
+        ++this->start_;
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->initial_awaiter_.destroy();
+        case 2:
+          return;
+      }
+    }
+  };
+  if constexpr (!std::is_void_v<SmallBufferGenerator>) {
+    return CoroFrame::template ramp_in_buffer<SmallBufferGenerator>(std::forward<Args>(args)...);
+  } else if constexpr (stackless) {
+    return CoroFrame::ramp(std::forward<Args>(args)...);
+  } else {
+    return inline_gen<int, CoroFrame>{
+        stackful_coroutine_handle<CoroFrame>{CoroFrame::ramp(std::forward<Args>(args)...)}};
+  }
+}
+}  // namespace detail
 
-template <bool isStackless, typename Frame, typename promise, bool isNoexcept>
-using FrameCRTP = std::conditional_t<isStackless, stackless_coro_crtp<Frame, promise, isNoexcept>,
-                                     stackful_coro_crtp<Frame, promise, isNoexcept>>;
 /**
  * A simple `iota` generator using the unified heap_generator alias.
  * Direct replacement of:
@@ -18,12 +86,48 @@ using FrameCRTP = std::conditional_t<isStackless, stackless_coro_crtp<Frame, pro
  */
 template <bool stackless = true>
 auto iota_unified(int start, int end) {
-  using promise_type = std::conditional_t<stackless, heap_generator<int>::promise_type,
-                                          detail::unified_generator_promise<int>>;
+  return detail::iota_unified_impl<stackless>(start, end);
+}
+
+/**
+ * Same as `iota_unified<true>(start, end)`, but the frame is allocated from the `resource`.
+ */
+inline heap_generator<int> iota_unified(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                        int start, int end) {
+  return detail::iota_unified_impl<true>(std::allocator_arg, resource, start, end);
+}
+
+/**
+ * Same as `iota_unified<true>(start, end)`, but the frame is stored inside the returned generator
+ * object if it fits into `BufferSize` bytes.
+ */
+template <size_t BufferSize = 128>
+small_generator<int, BufferSize> iota_small_buffer(int start, int end) {
+  return detail::iota_unified_impl<true, small_generator<int, BufferSize>>(start, end);
+}
+/**
+ * An `iota` generator that produces its values in batches of (at most) `ChunkSize` elements via
+ * `yield_batch`. Is best consumed via `next_chunk()` or `chunks()`, the iterators visit the values
+ * one by one. Lowered version of:
+ *   generator<int> iota_chunked(int start, int end) {
+ *     int buffer[ChunkSize];
+ *     while (start < end) {
+ *       int n = std::min<int>(ChunkSize, end - start);
+ *       for (int i = 0; i < n; ++i) buffer[i] = start + i;
+ *       start += n;
+ *       co_yield generator_chunk<int>{buffer, n};
+ *     }
+ *   }
+ */
+template <bool stackless = true, size_t ChunkSize = 64>
+auto iota_chunked(int start, int end) {
+  using promise_type = detail::unified_generator_promise<int>;
   struct CoroFrame : FrameCRTP<stackless, CoroFrame, promise_type, true> {
     using CoroFrameBase = FrameCRTP<stackless, CoroFrame, promise_type, true>;
     int start_;
     int end_;
+    int buffer_[ChunkSize]{};
+    int n_ = 0;
 
     CoroFrame(int s, int e) : start_(s), end_(e) {}
 
@@ -38,8 +142,13 @@ auto iota_unified(int start, int end) {
       CO_GET(initial_awaiter_).await_resume();
       this->initial_awaiter_.destroy();
       while (this->start_ < this->end_) {
-        CO_YIELD(1, initial_awaiter_, (this->start_));
-        ++this->start_;
+        this->n_ = std::min(static_cast<int>(ChunkSize), this->end_ - this->start_);
+        for (int i = 0; i < this->n_; ++i) {
+          this->buffer_[i] = this->start_ + i;
+        }
+        this->start_ += this->n_;
+        CO_YIELD(1, initial_awaiter_,
+                 (generator_chunk<int>{this->buffer_, static_cast<size_t>(this->n_)}));
       }
       CO_RETURN_VOID(2, final_awaiter_);
     }
@@ -63,4 +172,5 @@ auto iota_unified(int start, int end) {
         stackful_coroutine_handle<CoroFrame>{CoroFrame::ramp(start, end)}};
   }
 }
+
 #endif  // GENERATOR_REWRITE_EXAMPLES_IOTA_UNIFIED_H
\ No newline at end of file
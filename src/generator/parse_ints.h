@@ -0,0 +1,222 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_PARSE_INTS_H
+#define GENERATOR_REWRITE_EXAMPLES_PARSE_INTS_H
+
+#include <cctype>
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+#include "generator/expected_generator.h"
+#include "generator/unified_generator.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+enum class parse_status : unsigned char { ok, invalid_argument, out_of_range };
+
+// The result of parsing a single integer, the `value_` is only meaningful if `ok()`.
+struct parse_int_result {
+  int value_ = 0;
+  parse_status status_ = parse_status::ok;
+
+  bool ok() const noexcept { return status_ == parse_status::ok; }
+};
+
+// Parse an `int` with the same rules as `std::stoi` (leading whitespace and a leading '+' are
+// skipped, trailing characters are ignored), but report errors via the status instead of
+// exceptions. The actual parsing is done by `std::from_chars`.
+inline parse_int_result parse_int(std::string_view s) noexcept {
+  const char* first = s.data();
+  const char* last = s.data() + s.size();
+  while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+    ++first;
+  }
+  // `from_chars` doesn't accept a '+', but it would accept the '-' in "+-1" after we skip the '+'.
+  if (first != last && *first == '+') {
+    ++first;
+    if (first != last && *first == '-') {
+      return {0, parse_status::invalid_argument};
+    }
+  }
+  parse_int_result result;
+  auto [ptr, ec] = std::from_chars(first, last, result.value_);
+  if (ec == std::errc::invalid_argument) {
+    result.status_ = parse_status::invalid_argument;
+  } else if (ec == std::errc::result_out_of_range) {
+    result.status_ = parse_status::out_of_range;
+  }
+  return result;
+}
+
+/**
+ * The exception-free sibling of `throwing_parse_ints`, which uses `parse_int` instead of
+ * `std::stoi`. The error handling has the same semantics, but the errors are yielded as values
+ * instead of being thrown:
+ *   generator<parse_int_result, std::coroutine_handle> parse_ints(RangeOfStrings&& strings,
+ *                                                                 bool catch_errors) {
+ *     for (const auto& s : strings) {
+ *       auto result = parse_int(s);
+ *       if (result.ok()) {
+ *         co_yield result;
+ *       } else if (!catch_errors) {
+ *         co_yield result;  // report to the caller, then stop (`throw` in `throwing_parse_ints`)
+ *         co_return;
+ *       } else if (result.status_ == parse_status::invalid_argument) {
+ *         continue;
+ *       } else {
+ *         break;
+ *       }
+ *     }
+ *   }
+ * With `catch_errors == true` only successfully parsed values are yielded.
+ */
+template <typename RangeOfStrings>
+heap_generator<parse_int_result> parse_ints(RangeOfStrings&& strings, bool catch_errors) {
+  using promise_type = heap_generator<parse_int_result>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    RangeOfStrings&& strings_;
+    bool catch_errors_;
+
+    using It = decltype(std::begin(strings_));
+    using End = decltype(std::end(strings_));
+    coro_storage<It&, std::is_object_v<It>> it_;
+    coro_storage<const End&, std::is_object_v<End>> end_;
+    parse_int_result result_;
+
+    CoroFrame(RangeOfStrings&& s, bool catch_errors)
+        : strings_(std::forward<RangeOfStrings>(s)), catch_errors_(catch_errors) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_INIT(it_, (this->strings_.begin()));
+      CO_INIT(end_, (this->strings_.end()));
+      for (; CO_GET(it_) != CO_GET(end_); ++CO_GET(it_)) {
+        this->result_ = parse_int(*CO_GET(it_));
+        if (this->result_.ok()) {
+          CO_YIELD(1, initial_awaiter_, this->result_);
+        } else if (!this->catch_errors_) {
+          CO_YIELD(2, initial_awaiter_, this->result_);
+          break;
+        } else if (this->result_.status_ == parse_status::invalid_argument) {
+          continue;
+        } else {
+          break;
+        }
+      }
+      this->end_.destroy();
+      this->it_.destroy();
+      CO_RETURN_VOID(3, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+        case 2:
+          this->initial_awaiter_.destroy();
+          this->end_.destroy();
+          this->it_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(std::forward<RangeOfStrings>(strings), catch_errors);
+}
+
+/**
+ * The same as `parse_ints`, but with the errors reported via the error channel of an
+ * `expected_generator`. Invalid strings are recoverable errors (the consumer can clear them and
+ * continue), an out-of-range value is a terminal error:
+ *   expected_generator<int, parse_status> parse_ints_expected(RangeOfStrings&& strings) {
+ *     for (const auto& s : strings) {
+ *       auto result = parse_int(s);
+ *       if (result.ok()) {
+ *         co_yield result.value_;
+ *       } else if (result.status_ == parse_status::invalid_argument) {
+ *         co_yield generator_error{result.status_};
+ *       } else {
+ *         co_return generator_error{result.status_};
+ *       }
+ *     }
+ *   }
+ */
+template <typename RangeOfStrings>
+expected_generator<int, parse_status> parse_ints_expected(RangeOfStrings&& strings) {
+  using promise_type = expected_generator<int, parse_status>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    RangeOfStrings&& strings_;
+
+    using It = decltype(std::begin(strings_));
+    using End = decltype(std::end(strings_));
+    coro_storage<It&, std::is_object_v<It>> it_;
+    coro_storage<const End&, std::is_object_v<End>> end_;
+    parse_int_result result_;
+
+    CoroFrame(RangeOfStrings&& s) : strings_(std::forward<RangeOfStrings>(s)) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_INIT(it_, (this->strings_.begin()));
+      CO_INIT(end_, (this->strings_.end()));
+      for (; CO_GET(it_) != CO_GET(end_); ++CO_GET(it_)) {
+        this->result_ = parse_int(*CO_GET(it_));
+        if (this->result_.ok()) {
+          CO_YIELD(1, initial_awaiter_, this->result_.value_);
+        } else if (this->result_.status_ == parse_status::invalid_argument) {
+          CO_YIELD(2, initial_awaiter_, generator_error{this->result_.status_});
+        } else {
+          this->end_.destroy();
+          this->it_.destroy();
+          CO_RETURN_VALUE(3, final_awaiter_, generator_error{this->result_.status_});
+        }
+      }
+      this->end_.destroy();
+      this->it_.destroy();
+      CO_RETURN_VOID(3, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+        case 2:
+          this->initial_awaiter_.destroy();
+          this->end_.destroy();
+          this->it_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(std::forward<RangeOfStrings>(strings));
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_PARSE_INTS_H
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "./parse_ints.h"
+#include "./throwing_parse_ints.h"
+
+// `n` strings, `errorPercent` percent of which are not numbers (evenly spread).
+static std::vector<std::string> makeInput(size_t n, size_t errorPercent) {
+  std::vector<std::string> strings;
+  strings.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    if ((i * errorPercent) % 100 + errorPercent >= 100) {
+      strings.push_back("not a number");
+    } else {
+      strings.push_back(std::to_string(i * 7919));
+    }
+  }
+  return strings;
+}
+
+// `std::stoi`, the errors are thrown and caught inside the generator.
+static void BM_ThrowingParseInts(benchmark::State& state) {
+  auto strings = makeInput(10000, state.range(0));
+  for (auto _ : state) {
+    long sum = 0;
+    for (int val : throwing_parse_ints(strings, true)) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// `std::from_chars`, the errors are status values.
+static void BM_ParseInts(benchmark::State& state) {
+  auto strings = makeInput(10000, state.range(0));
+  for (auto _ : state) {
+    long sum = 0;
+    for (auto result : parse_ints(strings, true)) {
+      benchmark::DoNotOptimize(sum += result.value_);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// The errors are yielded via the typed error channel of an `expected_generator`, the consumer
+// skips them.
+static void BM_ParseIntsExpected(benchmark::State& state) {
+  auto strings = makeInput(10000, state.range(0));
+  for (auto _ : state) {
+    long sum = 0;
+    auto gen = parse_ints_expected(strings);
+    do {
+      for (int val : gen) {
+        benchmark::DoNotOptimize(sum += val);
+      }
+    } while (gen.has_error() && gen.clear_error());
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// The error rate in percent.
+BENCHMARK(BM_ThrowingParseInts)->Arg(0)->Arg(1)->Arg(10)->Arg(25)->Arg(50);
+BENCHMARK(BM_ParseInts)->Arg(0)->Arg(1)->Arg(10)->Arg(25)->Arg(50);
+BENCHMARK(BM_ParseIntsExpected)->Arg(0)->Arg(1)->Arg(10)->Arg(25)->Arg(50);
+
+BENCHMARK_MAIN();
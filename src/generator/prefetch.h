@@ -0,0 +1,138 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_PREFETCH_H
+#define GENERATOR_REWRITE_EXAMPLES_PREFETCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+#include "util/spsc_ring.h"
+
+/**
+ * Run the `upstream` generator on a dedicated worker thread, and pass its values to the consumer
+ * through a lock-free ring buffer of (at least) `capacity` elements. This lets a CPU-heavy producer
+ * and a CPU-heavy consumer run in parallel. The values are copied (or moved, for generators of
+ * rvalue references) into the ring buffer. The consumer sees them in the same order.
+ *
+ * The worker starts right away, so values are prefetched before the consumer asks for them.
+ * Exceptions in the upstream generator are rethrown to the consumer after all the values that were
+ * produced before them. Destroying the returned generator early cancels the producer and joins
+ * the worker thread. The upstream generator itself is destroyed on the consumer's thread.
+ *
+ * Both sides busy-wait (with `std::this_thread::yield()`) while the ring is full or empty. This
+ * suits the intended use, where both sides are busy, but a slow consumer keeps the worker thread
+ * spinning.
+ *
+ * There is no C++20 equivalent that is shorter than the frame below, as the worker thread is
+ * explicit anyway:
+ *   generator<V> prefetch(Gen upstream, size_t capacity) {
+ *     <start a thread that pushes all the values of `upstream` into a ring buffer>
+ *     while (<wait for the next value `v` in the ring buffer, or the end>) co_yield std::move(v);
+ *     <rethrow a stored exception>
+ *   }
+ */
+template <typename T, typename Policy>
+auto prefetch(unified_generator<T, Policy>&& upstream, size_t capacity = 1024) {
+  using Upstream = unified_generator<T, Policy>;
+  using value_type = typename Upstream::value_type;
+  using promise_type = typename heap_generator<value_type>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    Upstream upstream_;
+    // The ring keeps its indices on separate cache lines, which needs more alignment than the heap
+    // frame gets from the promise's `operator new`, so it lives in its own allocation.
+    std::unique_ptr<coro_detail::spsc_ring<value_type>> ring_;
+    // `finished_` is set by the producer after its last push. `exception_` is only read by the
+    // consumer after it has observed `finished_`.
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> cancelled_{false};
+    std::exception_ptr exception_;
+    std::thread worker_;
+
+    // As the frame is always allocated on the heap, the worker can keep a pointer to it.
+    CoroFrame(Upstream&& upstream, size_t cap)
+        : upstream_(std::move(upstream)),
+          ring_(std::make_unique<coro_detail::spsc_ring<value_type>>(cap)) {
+      worker_ = std::thread([this] { produce(); });
+    }
+
+    ~CoroFrame() {
+      cancelled_.store(true, std::memory_order_relaxed);
+      worker_.join();
+    }
+
+    void produce() {
+      try {
+        for (auto&& value : upstream_) {
+          while (!ring_->try_emplace(std::forward<decltype(value)>(value))) {
+            if (cancelled_.load(std::memory_order_relaxed)) {
+              break;
+            }
+            std::this_thread::yield();
+          }
+          if (cancelled_.load(std::memory_order_relaxed)) {
+            break;
+          }
+        }
+      } catch (...) {
+        exception_ = std::current_exception();
+      }
+      finished_.store(true, std::memory_order_release);
+    }
+
+    // Wait until there is a value in the ring, return false if there will be none.
+    bool waitForValue() {
+      while (!ring_->front()) {
+        if (finished_.load(std::memory_order_acquire)) {
+          // The producer might have pushed its last values before setting `finished_`.
+          return ring_->front() != nullptr;
+        }
+        std::this_thread::yield();
+      }
+      return true;
+    }
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (waitForValue()) {
+        CO_YIELD(1, initial_awaiter_, std::move(*this->ring_->front()));
+        this->ring_->pop();
+      }
+      if (this->exception_) {
+        std::rethrow_exception(this->exception_);
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    // The only exception that can escape is the rethrown one of the producer, no locals are alive.
+    ExceptionResult dispatchExceptionHandling() { return this->unhandled_exception(); }
+  };
+  return CoroFrame::ramp(std::move(upstream), capacity);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_PREFETCH_H
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "./combinators.h"
+#include "./iota_unified.h"
+#include "./prefetch.h"
+
+// A producer and a consumer that both do `state.range(1)` units of work per element.
+namespace {
+uint64_t busyWork(uint64_t x, int64_t work) {
+  for (int64_t i = 0; i < work; ++i) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+  return x;
+}
+
+auto producer(int n, int64_t work) {
+  return iota_unified(0, n) | combinators::map([work](int i) {
+           return static_cast<int>(busyWork(static_cast<uint64_t>(i), work) & 0xffff);
+         });
+}
+}  // namespace
+
+// Producer and consumer on the same thread.
+static void BM_SerialProducerConsumer(benchmark::State& state) {
+  const int n = state.range(0);
+  const int64_t work = state.range(1);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (int val : producer(n, work)) {
+      sum += busyWork(static_cast<uint64_t>(val), work);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// The producer runs on a worker thread.
+static void BM_PrefetchProducerConsumer(benchmark::State& state) {
+  const int n = state.range(0);
+  const int64_t work = state.range(1);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (int val : prefetch(producer(n, work), 256)) {
+      sum += busyWork(static_cast<uint64_t>(val), work);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+BENCHMARK(BM_SerialProducerConsumer)
+    ->Args({10000, 0})
+    ->Args({10000, 100})
+    ->Args({10000, 1000})
+    ->UseRealTime();
+BENCHMARK(BM_PrefetchProducerConsumer)
+    ->Args({10000, 0})
+    ->Args({10000, 100})
+    ->Args({10000, 1000})
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,239 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_RECURSIVE_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_RECURSIVE_GENERATOR_H
+
+// A generator that can delegate to nested generators via `co_yield elements_of(child)` in O(1) per
+// element, independent of the nesting depth. Inspired by `cppcoro::recursive_generator` and the
+// `elements_of` of `std::generator` (C++23).
+//
+// All the promises of a tree of nested generators know the promise of the outermost (root)
+// generator, and the root knows the currently active innermost generator (the leaf). The consumer
+// always resumes the leaf directly, and the leaf stores the address of the yielded values in the
+// root's promise. Starting a nested generator and returning to the parent once it is exhausted are
+// both done via symmetric transfer, which is trampolined by `stackless_handle_base::resume()`.
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_handle.h"
+#include "util/suspend.h"
+
+template <typename T>
+class recursive_generator;
+
+// Wrapper for `co_yield elements_of(child)`, which yields all the elements of the `child`.
+template <typename T>
+struct elements_of_t {
+  recursive_generator<T> generator_;
+};
+
+template <typename T>
+elements_of_t<T> elements_of(recursive_generator<T>&& generator) {
+  return elements_of_t<T>{std::move(generator)};
+}
+
+namespace detail {
+template <typename T>
+class recursive_generator_promise {
+ public:
+  using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+  using reference_type = std::conditional_t<std::is_reference_v<T>, T, const T&>;
+  using pointer_type = std::add_pointer_t<reference_type>;
+  using handle_type = stackless_coroutine_handle<recursive_generator_promise>;
+
+  recursive_generator_promise() = default;
+
+  recursive_generator<T> get_return_object() noexcept;
+
+  constexpr SuspendAlways initial_suspend() const noexcept { return {}; }
+
+  // Once a nested generator is exhausted, control returns to its parent, which becomes the leaf
+  // again. The root returns to the consumer.
+  struct final_awaiter {
+    static constexpr bool await_ready() noexcept { return false; }
+
+    stackless_coroutine_handle<void> await_suspend(handle_type h) noexcept {
+      auto& promise = h.promise();
+      if (promise.parent_) {
+        promise.root_->leaf_ = promise.parent_;
+        return stackless_coroutine_handle<void>{handle_type::from_promise(*promise.parent_).ptr};
+      }
+      return {};
+    }
+
+    static constexpr void await_resume() noexcept {}
+  };
+
+  final_awaiter final_suspend() const noexcept { return {}; }
+
+  // Awaiter for `co_yield elements_of(child)`. Owns the child, links it into the tree of nested
+  // generators, and directly transfers control to it.
+  struct nested_awaiter {
+    recursive_generator<T> child_;
+
+    bool await_ready() const noexcept { return !child_.m_handle; }
+
+    stackless_coroutine_handle<void> await_suspend(handle_type parent) noexcept {
+      auto& parentPromise = parent.promise();
+      auto& childPromise = child_.m_handle.promise();
+      childPromise.parent_ = &parentPromise;
+      childPromise.root_ = parentPromise.root_;
+      parentPromise.root_->leaf_ = &childPromise;
+      return stackless_coroutine_handle<void>{child_.m_handle.ptr};
+    }
+
+    // Exceptions from the child are propagated to the parent.
+    void await_resume() {
+      if (child_.m_handle) {
+        child_.m_handle.promise().rethrow_if_exception();
+      }
+    }
+  };
+
+  // Only the address of the value is stored (in the root), so the value has to live in the frame
+  // of the yielding generator until it is resumed.
+  SuspendAlways yield_value(reference_type value) noexcept {
+    root_->m_value = std::addressof(value);
+    return {};
+  }
+
+  nested_awaiter yield_value(elements_of_t<T>&& elements) noexcept {
+    return nested_awaiter{std::move(elements.generator_)};
+  }
+
+  void unhandled_exception() { m_exception = std::current_exception(); }
+
+  void return_void() {}
+
+  // Don't allow any use of 'co_await' inside the generator coroutine.
+  template <typename U>
+  void await_transform(U&& value) = delete;
+
+  // Only valid on the root.
+  reference_type value() const noexcept { return static_cast<reference_type>(*m_value); }
+
+  handle_type leaf() noexcept { return handle_type::from_promise(*leaf_); }
+
+  void rethrow_if_exception() {
+    if (m_exception) {
+      std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+  }
+
+ private:
+  // The links between the nested generators. A generator that hasn't been yielded via
+  // `elements_of` is its own root and leaf.
+  recursive_generator_promise* root_ = this;
+  recursive_generator_promise* parent_ = nullptr;
+  recursive_generator_promise* leaf_ = this;
+
+  // The last yielded value of the whole tree, only used in the root.
+  pointer_type m_value = nullptr;
+  std::exception_ptr m_exception;
+};
+
+template <typename T>
+class recursive_generator_iterator {
+  using promise_type = recursive_generator_promise<T>;
+  using handle_type = stackless_coroutine_handle<promise_type>;
+
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = typename promise_type::value_type;
+  using reference = typename promise_type::reference_type;
+
+  recursive_generator_iterator() noexcept : m_root(nullptr) {}
+
+  explicit recursive_generator_iterator(handle_type root) noexcept : m_root(root) {}
+
+  friend bool operator==(const recursive_generator_iterator& it,
+                         unified_generator_sentinel) noexcept {
+    return !it.m_root || it.m_root.done();
+  }
+
+  friend bool operator!=(const recursive_generator_iterator& it,
+                         unified_generator_sentinel s) noexcept {
+    return !(it == s);
+  }
+
+  // Always resume the innermost active generator.
+  recursive_generator_iterator& operator++() {
+    m_root.promise().leaf().resume();
+    if (m_root.done()) {
+      m_root.promise().rethrow_if_exception();
+    }
+    return *this;
+  }
+
+  void operator++(int) { (void)operator++(); }
+
+  reference operator*() const noexcept { return m_root.promise().value(); }
+
+ private:
+  handle_type m_root;
+};
+}  // namespace detail
+
+template <typename T>
+class [[nodiscard]] recursive_generator {
+ public:
+  using promise_type = detail::recursive_generator_promise<T>;
+  using handle_type = stackless_coroutine_handle<promise_type>;
+  using iterator = detail::recursive_generator_iterator<T>;
+  using value_type = typename promise_type::value_type;
+
+  recursive_generator() noexcept : m_handle(nullptr) {}
+
+  explicit recursive_generator(handle_type h) noexcept : m_handle(h) {}
+
+  recursive_generator(recursive_generator&& other) noexcept : m_handle(other.m_handle) {
+    other.m_handle = nullptr;
+  }
+
+  recursive_generator& operator=(recursive_generator&& other) noexcept {
+    if (this != &other) {
+      if (m_handle) m_handle.destroy();
+      m_handle = other.m_handle;
+      other.m_handle = nullptr;
+    }
+    return *this;
+  }
+
+  recursive_generator(const recursive_generator&) = delete;
+  recursive_generator& operator=(const recursive_generator&) = delete;
+
+  // Destroying the root also destroys all the nested generators, as they are owned by the
+  // `nested_awaiter`s inside the frames of their parents.
+  ~recursive_generator() {
+    if (m_handle) m_handle.destroy();
+  }
+
+  iterator begin() {
+    if (!m_handle) return iterator{};
+    m_handle.promise().leaf().resume();
+    if (m_handle.done()) {
+      m_handle.promise().rethrow_if_exception();
+    }
+    return iterator{m_handle};
+  }
+
+  detail::unified_generator_sentinel end() noexcept { return {}; }
+
+ private:
+  friend struct promise_type::nested_awaiter;
+  handle_type m_handle;
+};
+
+namespace detail {
+template <typename T>
+recursive_generator<T> recursive_generator_promise<T>::get_return_object() noexcept {
+  return recursive_generator<T>{handle_type::from_promise(*this)};
+}
+}  // namespace detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_RECURSIVE_GENERATOR_H
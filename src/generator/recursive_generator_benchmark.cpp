@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include "./tree_walk.h"
+
+// Nested generators that re-yield every element: O(depth) per element.
+static void BM_NestedReyield(benchmark::State& state) {
+  const int depth = state.range(0);
+  const int n = state.range(1);
+
+  for (auto _ : state) {
+    int sum = 0;
+    for (int val : nested_reyield(depth, n)) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Nested generators that delegate via `elements_of`: O(1) per element.
+static void BM_NestedRecursive(benchmark::State& state) {
+  const int depth = state.range(0);
+  const int n = state.range(1);
+
+  for (auto _ : state) {
+    int sum = 0;
+    for (int val : nested_recursive(depth, n)) {
+      benchmark::DoNotOptimize(sum += val);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+BENCHMARK(BM_NestedReyield)->Args({1, 10000})->Args({8, 10000})->Args({64, 10000});
+BENCHMARK(BM_NestedRecursive)->Args({1, 10000})->Args({8, 10000})->Args({64, 10000});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,64 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_SLIDING_WINDOWS_H
+#define GENERATOR_REWRITE_EXAMPLES_SLIDING_WINDOWS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * All the windows of `width` consecutive elements of `values`. Each window is constructed inside
+ * the promise via `emplace_yield`, which reuses the vector (and its capacity) of the previous
+ * window:
+ *   generator<std::vector<int>> sliding_windows(const std::vector<int>& values, size_t width) {
+ *     for (size_t i = 0; i + width <= values.size(); ++i) {
+ *       co_yield emplace_yield(values.begin() + i, values.begin() + i + width);
+ *     }
+ *   }
+ */
+inline heap_generator<std::vector<int>> sliding_windows(const std::vector<int>& values,
+                                                        size_t width) {
+  using promise_type = heap_generator<std::vector<int>>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    const std::vector<int>& values_;
+    size_t width_;
+    size_t i_;
+
+    CoroFrame(const std::vector<int>& values, size_t width) : values_(values), width_(width) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      for (this->i_ = 0; this->i_ + this->width_ <= this->values_.size(); ++this->i_) {
+        CO_YIELD(1, initial_awaiter_,
+                 emplace_yield(this->values_.begin() + this->i_,
+                               this->values_.begin() + this->i_ + this->width_));
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(values, width);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_SLIDING_WINDOWS_H
@@ -1,6 +1,11 @@
 #ifndef GENERATOR_REWRITE_EXAMPLES_STRING_PREPEND_H
 #define GENERATOR_REWRITE_EXAMPLES_STRING_PREPEND_H
 
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
 #include "./unified_generator.h"
 #include "util/coroutine_frame.h"
 #include "util/macros.h"
@@ -70,4 +75,250 @@ heap_generator<std::string> string_prepend(RangeOfStrings&& rangeOfStrings, std:
   return CoroFrame::ramp(std::forward<RangeOfStrings>(rangeOfStrings), std::move(prefix));
 }
 
+/**
+ * Same as `string_prepend`, but the strings are built in place inside the promise's
+ * `yield_buffer()`. The buffer keeps its capacity across yields, so once it is large enough no
+ * allocations happen per element (unless the consumer moves the strings out via `take_value()`):
+ *   generator<std::string, std::coroutine_handle> prepend(auto&& rangeOfStrings, std::string
+ * prefix) { for (const auto& s : rangeOfStrings) { auto& buffer = <promise>.yield_buffer();
+ *       buffer.assign(prefix); buffer.append(s); co_yield buffer;
+ *     }
+ *   }
+ */
+template <typename RangeOfStrings>
+heap_generator<std::string> string_prepend_reuse(RangeOfStrings&& rangeOfStrings,
+                                                 std::string prefix) {
+  using promise_type = heap_generator<std::string>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    RangeOfStrings&& rangeOfStrings_;
+    std::string prefix_;
+
+    using It = decltype(std::begin(rangeOfStrings_));
+    using End = decltype(std::end(rangeOfStrings_));
+    coro_storage<It&, std::is_object_v<It>> it_;
+    coro_storage<const End&, std::is_object_v<End>> end_;
+
+    CoroFrame(RangeOfStrings&& ros, std::string pref)
+        : rangeOfStrings_(std::forward<RangeOfStrings>(ros)), prefix_(std::move(pref)) {}
+
+    // The body of the loop before the `co_yield`. This is a separate function, as the `goto` into
+    // the loop must not skip the initialization of the local `buffer` reference.
+    std::string& buildValue() {
+      auto& buffer = this->promise().yield_buffer();
+      std::string_view word{*CO_GET(it_)};
+      // A no-op in the steady state, but a single allocation if the consumer has taken the buffer.
+      buffer.reserve(prefix_.size() + word.size());
+      buffer.assign(prefix_);
+      buffer.append(word);
+      return buffer;
+    }
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_INIT(it_, (this->rangeOfStrings_.begin()));
+      CO_INIT(end_, (this->rangeOfStrings_.end()));
+      for (; CO_GET(it_) != CO_GET(end_); ++CO_GET(it_)) {
+        CO_YIELD(1, initial_awaiter_, buildValue());
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(std::forward<RangeOfStrings>(rangeOfStrings), std::move(prefix));
+}
+
+/**
+ * Same as `string_prepend`, but without any per-element allocations: The prefix is written once
+ * into a buffer inside the frame, each suffix is appended in place, and a view of the buffer is
+ * yielded. The view is only valid until the generator is resumed:
+ *   generator<std::string_view, std::coroutine_handle> prepend(auto&& rangeOfStrings,
+ * std::string prefix) { std::string buffer = prefix; for (const auto& s : rangeOfStrings) {
+ *       buffer.resize(prefix.size()); buffer.append(s); co_yield std::string_view{buffer};
+ *     }
+ *   }
+ */
+template <typename RangeOfStrings>
+heap_generator<std::string_view> string_prepend_view(RangeOfStrings&& rangeOfStrings,
+                                                     std::string prefix) {
+  using promise_type = heap_generator<std::string_view>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    RangeOfStrings&& rangeOfStrings_;
+    // Starts with the prefix, the suffixes are appended behind it.
+    std::string buffer_;
+    size_t prefixSize_;
+
+    using It = decltype(std::begin(rangeOfStrings_));
+    using End = decltype(std::end(rangeOfStrings_));
+    coro_storage<It&, std::is_object_v<It>> it_;
+    coro_storage<const End&, std::is_object_v<End>> end_;
+
+    CoroFrame(RangeOfStrings&& ros, std::string pref)
+        : rangeOfStrings_(std::forward<RangeOfStrings>(ros)),
+          buffer_(std::move(pref)),
+          prefixSize_(buffer_.size()) {}
+
+    std::string_view buildValue() {
+      buffer_.resize(prefixSize_);
+      buffer_.append(std::string_view{*CO_GET(it_)});
+      return buffer_;
+    }
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_INIT(it_, (this->rangeOfStrings_.begin()));
+      CO_INIT(end_, (this->rangeOfStrings_.end()));
+      for (; CO_GET(it_) != CO_GET(end_); ++CO_GET(it_)) {
+        CO_YIELD(1, initial_awaiter_, buildValue());
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(std::forward<RangeOfStrings>(rangeOfStrings), std::move(prefix));
+}
+
+// The lazy concatenation of a prefix and a suffix, which only stores views of the two parts. The
+// characters are only copied when the string is materialized via `append_to` or `str`.
+class prefixed_string {
+ public:
+  prefixed_string(std::string_view prefix, std::string_view suffix) noexcept
+      : prefix_(prefix), suffix_(suffix) {}
+
+  std::string_view prefix() const noexcept { return prefix_; }
+  std::string_view suffix() const noexcept { return suffix_; }
+  size_t size() const noexcept { return prefix_.size() + suffix_.size(); }
+  bool empty() const noexcept { return size() == 0; }
+
+  char operator[](size_t i) const noexcept {
+    return i < prefix_.size() ? prefix_[i] : suffix_[i - prefix_.size()];
+  }
+
+  void append_to(std::string& target) const {
+    target.append(prefix_);
+    target.append(suffix_);
+  }
+
+  std::string str() const {
+    std::string result;
+    result.reserve(size());
+    append_to(result);
+    return result;
+  }
+
+  friend bool operator==(const prefixed_string& a, std::string_view b) noexcept {
+    return a.size() == b.size() && b.substr(0, a.prefix_.size()) == a.prefix_ &&
+           b.substr(a.prefix_.size()) == a.suffix_;
+  }
+
+  friend bool operator!=(const prefixed_string& a, std::string_view b) noexcept {
+    return !(a == b);
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const prefixed_string& s) {
+    return os << s.prefix_ << s.suffix_;
+  }
+
+ private:
+  std::string_view prefix_;
+  std::string_view suffix_;
+};
+
+/**
+ * Same as `string_prepend`, but yields lazy `prefixed_string`s that refer to the prefix (stored in
+ * the frame) and the elements of the range, so nothing is copied at all. The values stay valid
+ * as long as the generator and the range:
+ *   generator<prefixed_string, std::coroutine_handle> prepend(auto&& rangeOfStrings,
+ * std::string prefix) { for (const auto& s : rangeOfStrings) {
+ *       co_yield emplace_yield(prefix, s);
+ *     }
+ *   }
+ */
+template <typename RangeOfStrings>
+heap_generator<prefixed_string> string_prepend_lazy(RangeOfStrings&& rangeOfStrings,
+                                                    std::string prefix) {
+  using promise_type = heap_generator<prefixed_string>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    RangeOfStrings&& rangeOfStrings_;
+    std::string prefix_;
+
+    using It = decltype(std::begin(rangeOfStrings_));
+    using End = decltype(std::end(rangeOfStrings_));
+    coro_storage<It&, std::is_object_v<It>> it_;
+    coro_storage<const End&, std::is_object_v<End>> end_;
+
+    CoroFrame(RangeOfStrings&& ros, std::string pref)
+        : rangeOfStrings_(std::forward<RangeOfStrings>(ros)), prefix_(std::move(pref)) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_INIT(it_, (this->rangeOfStrings_.begin()));
+      CO_INIT(end_, (this->rangeOfStrings_.end()));
+      for (; CO_GET(it_) != CO_GET(end_); ++CO_GET(it_)) {
+        CO_YIELD(1, initial_awaiter_,
+                 emplace_yield(std::string_view{this->prefix_}, std::string_view{*CO_GET(it_)}));
+      }
+      CO_RETURN_VOID(2, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(std::forward<RangeOfStrings>(rangeOfStrings), std::move(prefix));
+}
+
 #endif  // GENERATOR_REWRITE_EXAMPLES_STRING_PREPEND_H
\ No newline at end of file
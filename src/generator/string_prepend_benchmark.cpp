@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "./string_prepend.h"
+#include "util/allocation_counter.h"
+
+// Words that are long enough that the prefixed strings don't fit into the small string buffer.
+static std::vector<std::string> makeWords(size_t n) {
+  std::vector<std::string> words;
+  for (size_t i = 0; i < n; ++i) {
+    words.push_back("word number " + std::to_string(i));
+  }
+  return words;
+}
+
+static const std::string prefix = "a prefix that is too long for SSO: ";
+
+// The current version: a new string per element.
+static void BM_StringPrepend(benchmark::State& state) {
+  auto words = makeWords(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    size_t total = 0;
+    for (const auto& s : string_prepend(words, prefix)) {
+      benchmark::DoNotOptimize(total += s.size());
+    }
+    allocations += numAllocations() - before;
+  }
+  state.counters["allocs_per_element"] =
+      static_cast<double>(allocations) / static_cast<double>(state.iterations() * words.size());
+}
+
+// The strings are built in the reused `yield_buffer()` of the promise.
+static void BM_StringPrependReuse(benchmark::State& state) {
+  auto words = makeWords(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    size_t total = 0;
+    for (const auto& s : string_prepend_reuse(words, prefix)) {
+      benchmark::DoNotOptimize(total += s.size());
+    }
+    allocations += numAllocations() - before;
+  }
+  state.counters["allocs_per_element"] =
+      static_cast<double>(allocations) / static_cast<double>(state.iterations() * words.size());
+}
+
+// The consumer keeps all the strings, which are moved out of the `yield_buffer()`.
+static void BM_StringPrependReuseTakeValue(benchmark::State& state) {
+  auto words = makeWords(state.range(0));
+  size_t allocations = 0;
+  std::vector<std::string> result;
+  result.reserve(words.size());
+  for (auto _ : state) {
+    result.clear();
+    size_t before = numAllocations();
+    auto gen = string_prepend_reuse(words, prefix);
+    for (auto it = gen.begin(); it != gen.end(); ++it) {
+      result.push_back(it.take_value());
+    }
+    allocations += numAllocations() - before;
+    benchmark::DoNotOptimize(result.data());
+  }
+  state.counters["allocs_per_element"] =
+      static_cast<double>(allocations) / static_cast<double>(state.iterations() * words.size());
+}
+
+// Views into a buffer inside the frame.
+static void BM_StringPrependView(benchmark::State& state) {
+  auto words = makeWords(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    size_t total = 0;
+    for (std::string_view s : string_prepend_view(words, prefix)) {
+      benchmark::DoNotOptimize(total += s.size() + s.back());
+    }
+    allocations += numAllocations() - before;
+  }
+  state.counters["allocs_per_element"] =
+      static_cast<double>(allocations) / static_cast<double>(state.iterations() * words.size());
+}
+
+// Lazy (prefix, suffix) views, no characters are copied.
+static void BM_StringPrependLazy(benchmark::State& state) {
+  auto words = makeWords(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    size_t total = 0;
+    for (const prefixed_string& s : string_prepend_lazy(words, prefix)) {
+      benchmark::DoNotOptimize(total += s.size() + s[s.size() - 1]);
+    }
+    allocations += numAllocations() - before;
+  }
+  state.counters["allocs_per_element"] =
+      static_cast<double>(allocations) / static_cast<double>(state.iterations() * words.size());
+}
+
+BENCHMARK(BM_StringPrepend)->Arg(10)->Arg(10000);
+BENCHMARK(BM_StringPrependReuse)->Arg(10)->Arg(10000);
+BENCHMARK(BM_StringPrependReuseTakeValue)->Arg(10)->Arg(10000);
+BENCHMARK(BM_StringPrependView)->Arg(10)->Arg(10000);
+BENCHMARK(BM_StringPrependLazy)->Arg(10)->Arg(10000);
+
+BENCHMARK_MAIN();
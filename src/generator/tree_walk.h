@@ -0,0 +1,210 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_TREE_WALK_H
+#define GENERATOR_REWRITE_EXAMPLES_TREE_WALK_H
+
+#include "generator/recursive_generator.h"
+#include "generator/unified_generator.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+struct tree_node {
+  int value_;
+  const tree_node* left_ = nullptr;
+  const tree_node* right_ = nullptr;
+};
+
+/**
+ * In-order traversal of a binary tree. The C++17 rewrite of:
+ *   recursive_generator<int> tree_walk(const tree_node* node) {
+ *     if (!node) co_return;
+ *     co_yield elements_of(tree_walk(node->left_));
+ *     co_yield node->value_;
+ *     co_yield elements_of(tree_walk(node->right_));
+ *   }
+ */
+inline recursive_generator<int> tree_walk(const tree_node* node) {
+  using promise_type = recursive_generator<int>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    const tree_node* node_;
+
+    coro_storage<promise_type::nested_awaiter&, true> nested_;
+
+    CoroFrame(const tree_node* node) : node_(node) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+        case 3:
+          goto label_3;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      if (!this->node_) {
+        CO_RETURN_VOID(4, final_awaiter_);
+      }
+      CO_YIELD(1, nested_, elements_of(tree_walk(this->node_->left_)));
+      CO_YIELD(2, initial_awaiter_, this->node_->value_);
+      CO_YIELD(3, nested_, elements_of(tree_walk(this->node_->right_)));
+      CO_RETURN_VOID(4, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+        case 3:
+          this->nested_.destroy();
+          return;
+        case 2:
+          this->initial_awaiter_.destroy();
+          return;
+        case 4:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(node);
+}
+
+/**
+ * A chain of `depth` nested generators, the innermost of which yields `0, ..., n-1`. Each level
+ * delegates via `elements_of`, so each element costs O(1) independent of the `depth`:
+ *   recursive_generator<int> nested_recursive(int depth, int n) {
+ *     if (depth == 0) {
+ *       for (int i = 0; i < n; ++i) co_yield i;
+ *     } else {
+ *       co_yield elements_of(nested_recursive(depth - 1, n));
+ *     }
+ *   }
+ */
+inline recursive_generator<int> nested_recursive(int depth, int n) {
+  using promise_type = recursive_generator<int>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    int depth_;
+    int n_;
+    int i_ = 0;
+
+    coro_storage<promise_type::nested_awaiter&, true> nested_;
+
+    CoroFrame(int depth, int n) : depth_(depth), n_(n) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      if (this->depth_ == 0) {
+        for (this->i_ = 0; this->i_ < this->n_; ++this->i_) {
+          CO_YIELD(1, initial_awaiter_, this->i_);
+        }
+      } else {
+        CO_YIELD(2, nested_, elements_of(nested_recursive(this->depth_ - 1, this->n_)));
+      }
+      CO_RETURN_VOID(3, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          this->nested_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(depth, n);
+}
+
+/**
+ * The same chain as `nested_recursive`, but with ordinary heap generators, where each level
+ * re-yields every element of the next level, so each element costs O(depth):
+ *   heap_generator<int> nested_reyield(int depth, int n) {
+ *     if (depth == 0) {
+ *       for (int i = 0; i < n; ++i) co_yield i;
+ *     } else {
+ *       for (int v : nested_reyield(depth - 1, n)) co_yield v;
+ *     }
+ *   }
+ */
+inline heap_generator<int> nested_reyield(int depth, int n) {
+  using promise_type = heap_generator<int>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    int depth_;
+    int n_;
+    int i_ = 0;
+
+    coro_storage<heap_generator<int>&, true> inner_;
+    coro_storage<heap_generator<int>::iterator&, true> it_;
+
+    CoroFrame(int depth, int n) : depth_(depth), n_(n) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      if (this->depth_ == 0) {
+        for (this->i_ = 0; this->i_ < this->n_; ++this->i_) {
+          CO_YIELD(1, initial_awaiter_, this->i_);
+        }
+      } else {
+        CO_INIT(inner_, (nested_reyield(this->depth_ - 1, this->n_)));
+        CO_INIT(it_, (CO_GET(inner_).begin()));
+        for (; CO_GET(it_) != CO_GET(inner_).end(); ++CO_GET(it_)) {
+          CO_YIELD(2, initial_awaiter_, *CO_GET(it_));
+        }
+        this->it_.destroy();
+        this->inner_.destroy();
+      }
+      CO_RETURN_VOID(3, final_awaiter_);
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+        case 1:
+          this->initial_awaiter_.destroy();
+          return;
+        case 2:
+          this->initial_awaiter_.destroy();
+          this->it_.destroy();
+          this->inner_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(depth, n);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_TREE_WALK_H
@@ -27,15 +27,20 @@ SOFTWARE.
 */
 
 
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <iterator>
+#include <new>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
 #include "util/coro_storage.h"
 #include "util/coroutine_handle.h"
 #include "util/suspend.h"
+#include "util/type_traits.h"
 
 // Forward declarations
 template <typename T, typename Policy>
@@ -44,13 +49,159 @@ template <typename T>
 struct HeapGeneratorPolicy;
 template <typename T, typename CoroFrame>
 struct InlineGeneratorPolicy;
+template <typename T, size_t BufferSize>
+struct SmallBufferGeneratorPolicy;
+
+// A contiguous, non-owning batch of values that is produced by a single step of a generator, see
+// `unified_generator_promise::yield_batch` and `unified_generator::next_chunk`. An empty chunk
+// signals the end of the generator.
+template <typename V>
+struct generator_chunk {
+  const V* data_ = nullptr;
+  size_t size_ = 0;
+
+  const V* data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  const V* begin() const noexcept { return data_; }
+  const V* end() const noexcept { return data_ + size_; }
+  const V& operator[](size_t i) const noexcept { return data_[i]; }
+};
+
+// The argument of `co_yield emplace_yield(args...)`, which constructs the yielded value directly
+// inside the promise (see `unified_generator_promise::yield_value(emplace_yield_t)`).
+template <typename... Args>
+struct emplace_yield_t {
+  std::tuple<Args&&...> args_;
+};
+
+template <typename... Args>
+emplace_yield_t<Args...> emplace_yield(Args&&... args) noexcept {
+  return {std::forward_as_tuple(std::forward<Args>(args)...)};
+}
 
 namespace detail {
+template <typename V, typename... Args>
+using assign_result_t = decltype(std::declval<V&>().assign(std::declval<Args>()...));
+
+template <typename V, typename Void, typename... Args>
+struct has_assign_impl : std::false_type {};
+
+template <typename V, typename... Args>
+struct has_assign_impl<V, std::void_t<assign_result_t<V, Args...>>, Args...> : std::true_type {};
+
+// True iff `v.assign(args...)` is valid for an lvalue `v` of type `V`.
+template <typename V, typename... Args>
+using has_assign = has_assign_impl<V, void, Args...>;
+
+// True iff `v = arg` is valid for an lvalue `v` of type `V` and a single argument.
+template <typename V, typename... Args>
+struct is_assignable_from : std::false_type {};
+
+template <typename V, typename Arg>
+struct is_assignable_from<V, Arg> : std::is_assignable<V&, Arg&&> {};
+
+// Storage for a single value of type `V` inside a promise that is reused for the values of
+// subsequent yields. Unlike `coro_storage` it tracks whether it holds a value, s.t. the promise
+// (and thus the frame) stays movable.
+template <typename V>
+class yield_slot {
+ public:
+  yield_slot() = default;
+
+  yield_slot(yield_slot&& other) noexcept(std::is_nothrow_move_constructible_v<V>) {
+    if (other.m_engaged) {
+      new (m_storage) V(std::move(*other.get()));
+      m_engaged = true;
+    }
+  }
+
+  // Only used when a frame is cloned (see `stackful_coro_crtp::rebaseCopy`).
+  yield_slot(const yield_slot& other) {
+    if (other.m_engaged) {
+      new (m_storage) V(*other.get());
+      m_engaged = true;
+    }
+  }
+
+  yield_slot& operator=(yield_slot&& other) noexcept(std::is_nothrow_move_constructible_v<V>) {
+    if (this != &other) {
+      reset();
+      if (other.m_engaged) {
+        new (m_storage) V(std::move(*other.get()));
+        m_engaged = true;
+      }
+    }
+    return *this;
+  }
+
+  ~yield_slot() { reset(); }
+
+  // Store a value constructed from `args`. If the slot already holds a value, it is reassigned via
+  // `value.assign(args...)` (e.g. for strings and vectors) or `value = arg` if possible, which
+  // reuses the resources (e.g. the capacity) of the previous value.
+  template <typename... Args>
+  V& emplace(Args&&... args) {
+    if constexpr (has_assign<V, Args...>::value) {
+      if (m_engaged) {
+        get()->assign(std::forward<Args>(args)...);
+        return *get();
+      }
+    } else if constexpr (is_assignable_from<V, Args...>::value) {
+      if (m_engaged) {
+        ((*get() = std::forward<Args>(args)), ...);  // `Args` has a single element.
+        return *get();
+      }
+    }
+    reset();
+    new (m_storage) V(std::forward<Args>(args)...);
+    m_engaged = true;
+    return *get();
+  }
+
+  // The stored value, which is default-constructed on first use.
+  V& get_or_default() {
+    if (!m_engaged) {
+      emplace();
+    }
+    return *get();
+  }
+
+  bool holds(const V* ptr) const noexcept {
+    return m_engaged && ptr == std::launder(reinterpret_cast<const V*>(m_storage));
+  }
+
+  V* get() noexcept { return std::launder(reinterpret_cast<V*>(m_storage)); }
+  const V* get() const noexcept { return std::launder(reinterpret_cast<const V*>(m_storage)); }
+
+  void reset() noexcept {
+    if (m_engaged) {
+      get()->~V();
+      m_engaged = false;
+    }
+  }
+
+ private:
+  alignas(V) unsigned char m_storage[sizeof(V)];
+  bool m_engaged = false;
+};
+
+struct no_yield_slot {
+  template <typename V>
+  bool holds(const V*) const noexcept {
+    return false;
+  }
+};
+
 // ---------------------------------------------------------------------------
 // Unified promise type for both heap and inline generators.
 // Value storage is selected at compile time based on type traits:
 //   - By-value if T is trivially copyable, sizeof <= 16, and not a reference
 //   - By-pointer otherwise
+// In the by-pointer mode, values can also be constructed in a slot inside the promise via
+// `co_yield emplace_yield(args...)` or `yield_buffer()`, which is reused across yields.
+// Heap frames can be placed into a `std::pmr::memory_resource` by wrapping the promise in
+// `resource_allocated` (see `util/memory_resource_allocation.h`).
 // ---------------------------------------------------------------------------
 template <typename T>
 class unified_generator_promise {
@@ -71,6 +222,8 @@ class unified_generator_promise {
   //   - by const ref (or T& for reference T) when stored as pointer
   using return_type = std::conditional_t<store_by_value, value_type, reference_type>;
 
+  static constexpr bool has_yield_slot = !store_by_value && !std::is_reference_v<T>;
+
   unified_generator_promise() = default;
 
   // get_return_object: used by heap stackless_coro_crtp::ramp(), not called in inline path.
@@ -85,6 +238,9 @@ class unified_generator_promise {
       m_value = value;
     } else {
       m_value = std::addressof(value);
+      // Lvalues can be referred to by the generator after the next resume, unless they are the
+      // promise's own `yield_buffer()`.
+      m_movable = m_slot.holds(m_value);
     }
     return {};
   }
@@ -94,10 +250,70 @@ class unified_generator_promise {
       m_value = std::move(value);
     } else {
       m_value = std::addressof(value);
+      m_movable = true;
+    }
+    return {};
+  }
+
+  // `co_yield emplace_yield(args...)`: construct the value from `args` inside the promise. In the
+  // by-pointer mode the value is stored in the `yield_buffer()`, and a single argument is assigned
+  // to the previous value, s.t. e.g. its capacity is reused.
+  template <typename... Args>
+  SuspendAlways yield_value(emplace_yield_t<Args...> emplace) {
+    if constexpr (store_by_value) {
+      m_value = std::make_from_tuple<value_type>(std::move(emplace.args_));
+    } else {
+      static_assert(has_yield_slot, "`emplace_yield` requires a non-reference value type");
+      m_value = std::apply(
+          [this](auto&&... args) -> value_type* {
+            return std::addressof(m_slot.emplace(std::forward<decltype(args)>(args)...));
+          },
+          std::move(emplace.args_));
+      m_movable = true;
     }
     return {};
   }
 
+  // A value inside the promise that the generator can modify in place and then `co_yield`. It is
+  // default-constructed on first use and keeps its state (e.g. the capacity of a string) across
+  // yields, unless the consumer moves it out via `take_value()`.
+  value_type& yield_buffer() {
+    static_assert(has_yield_slot, "`yield_buffer` requires a by-pointer, non-reference value type");
+    return m_slot.get_or_default();
+  }
+
+  // Yield `count` values at once, s.t. the consumer pays for a single resume per batch. The values
+  // have to stay valid until the generator is resumed again. Batches are best consumed via
+  // `unified_generator::next_chunk()` or `unified_generator::chunks()`. The element-wise iterator
+  // (and `for_each`) visits the values of a batch one by one, see `next_batch_value()`.
+  SuspendAlways yield_batch(const value_type* data, size_t count) noexcept {
+    m_batch = generator_chunk<value_type>{data, count};
+    m_batched = true;
+    if (count > 0) {
+      setBatchValue();
+    }
+    return {};
+  }
+
+  // `co_yield generator_chunk<value_type>{...}` is the same as calling `yield_batch`.
+  SuspendAlways yield_value(generator_chunk<value_type> chunk) noexcept {
+    return yield_batch(chunk.data(), chunk.size());
+  }
+
+  // Return the values of the last step, which are either the last batch, or the last single
+  // value.
+  generator_chunk<value_type> take_chunk() noexcept {
+    if (m_batched) {
+      m_batched = false;
+      return std::exchange(m_batch, generator_chunk<value_type>{});
+    }
+    if constexpr (store_by_value) {
+      return {&m_value, 1};
+    } else {
+      return {m_value, 1};
+    }
+  }
+
   void unhandled_exception() {
     CO_STORAGE_CONSTRUCT(m_exception, (std::current_exception()));
     m_has_exception = true;
@@ -105,6 +321,36 @@ class unified_generator_promise {
 
   void return_void() {}
 
+  // Element-wise consumption of batches: the current value is the first value of the remaining
+  // batch. Makes the next value of the batch the current one, returns false (and drops the batch)
+  // if there is none, or if the last step didn't yield a batch.
+  bool next_batch_value() noexcept {
+    if (!m_batched) {
+      return false;
+    }
+    if (m_batch.size() <= 1) {
+      m_batch = generator_chunk<value_type>{};
+      m_batched = false;
+      return false;
+    }
+    m_batch = generator_chunk<value_type>{m_batch.data() + 1, m_batch.size() - 1};
+    setBatchValue();
+    return true;
+  }
+
+  // True iff the last step yielded a batch, whose values have not all been consumed.
+  bool in_batch() const noexcept { return m_batched; }
+
+  // Returns true (and drops the batch) if the last step yielded an empty batch, which has no
+  // current value.
+  bool drop_empty_batch() noexcept {
+    if (m_batched && m_batch.empty()) {
+      m_batched = false;
+      return true;
+    }
+    return false;
+  }
+
   return_type value() const noexcept {
     if constexpr (store_by_value) {
       return m_value;
@@ -113,6 +359,21 @@ class unified_generator_promise {
     }
   }
 
+  // Move the current value out of the generator if it is owned by the generator and not used
+  // after the next resume (the `yield_buffer()` or a yielded rvalue), and copy it otherwise.
+  value_type take_value() {
+    if constexpr (store_by_value) {
+      return m_value;
+    } else if constexpr (std::is_const_v<std::remove_reference_t<T>>) {
+      return *m_value;
+    } else {
+      if (m_movable) {
+        return std::move(*m_value);
+      }
+      return *m_value;
+    }
+  }
+
   // Don't allow any use of 'co_await' inside the generator coroutine.
   template <typename U>
   void await_transform(U&& value) = delete;
@@ -127,14 +388,170 @@ class unified_generator_promise {
   }
 
  private:
-  storage_type m_value;
+  // The current value of a batch is copied (or pointed to), and thus never moved out.
+  void setBatchValue() noexcept {
+    if constexpr (store_by_value) {
+      m_value = *m_batch.data();
+    } else {
+      m_value = const_cast<pointer_type>(m_batch.data());
+      m_movable = false;
+    }
+  }
+
+  storage_type m_value{};
+  // The remaining values of the last batch, only valid if `m_batched`.
+  generator_chunk<value_type> m_batch;
   coro_storage<std::exception_ptr&, true> m_exception;
   bool m_has_exception = false;
+  bool m_movable = false;
+  bool m_batched = false;
+  [[no_unique_address]] std::conditional_t<has_yield_slot, yield_slot<value_type>, no_yield_slot>
+      m_slot;
+
+ public:
+  // When the frame is relocated (see `SmallBufferGeneratorPolicy`), a pointer to the value in the
+  // `yield_buffer()` has to follow the value.
+  unified_generator_promise(unified_generator_promise&& other) noexcept(
+      std::is_nothrow_move_constructible_v<decltype(m_slot)>)
+      : m_value(other.m_value),
+        m_batch(other.m_batch),
+        m_has_exception(other.m_has_exception),
+        m_movable(other.m_movable),
+        m_batched(other.m_batched),
+        m_slot(std::move(other.m_slot)) {
+    if (m_has_exception) {
+      CO_STORAGE_CONSTRUCT(m_exception, (std::move(other.m_exception.get().ref_)));
+    }
+    rebaseValue(other);
+  }
+
+  // Copy the state of a suspended generator when its (inline) frame is cloned. The value and the
+  // batch may still point into the frame of `other`, which is fixed by `rebase()`.
+  unified_generator_promise(const unified_generator_promise& other)
+      : m_value(other.m_value),
+        m_batch(other.m_batch),
+        m_has_exception(other.m_has_exception),
+        m_movable(other.m_movable),
+        m_batched(other.m_batched),
+        m_slot(other.m_slot) {
+    if (m_has_exception) {
+      CO_STORAGE_CONSTRUCT(m_exception, (const_cast<unified_generator_promise&>(other)
+                                             .m_exception.get()
+                                             .ref_));
+    }
+    rebaseValue(other);
+  }
+
+  // If the value or the batch point into the memory `[from, from + size)` (the frame of a generator
+  // that this promise was copied from), then make them point to the same offset in `to`.
+  void rebase(const void* from, const void* to, size_t size) noexcept {
+    auto move = [&](auto* ptr) {
+      auto address = reinterpret_cast<std::uintptr_t>(ptr);
+      auto begin = reinterpret_cast<std::uintptr_t>(from);
+      if (address < begin || address >= begin + size) {
+        return ptr;
+      }
+      return reinterpret_cast<decltype(ptr)>(reinterpret_cast<std::uintptr_t>(to) +
+                                             (address - begin));
+    };
+    if constexpr (!store_by_value) {
+      if (m_value) {
+        m_value = move(m_value);
+      }
+    }
+    if (m_batch.data()) {
+      m_batch.data_ = move(m_batch.data_);
+    }
+  }
+
+  unified_generator_promise& operator=(unified_generator_promise&& other) noexcept(
+      std::is_nothrow_move_assignable_v<decltype(m_slot)>) {
+    m_value = other.m_value;
+    m_batch = other.m_batch;
+    if (m_has_exception) {
+      m_exception.destroy();
+    }
+    m_has_exception = other.m_has_exception;
+    if (m_has_exception) {
+      CO_STORAGE_CONSTRUCT(m_exception, (std::move(other.m_exception.get().ref_)));
+    }
+    m_movable = other.m_movable;
+    m_batched = other.m_batched;
+    m_slot = std::move(other.m_slot);
+    rebaseValue(other);
+    return *this;
+  }
+
+ private:
+  void rebaseValue(const unified_generator_promise& other) noexcept {
+    if constexpr (has_yield_slot) {
+      if (other.m_slot.holds(m_value)) {
+        m_value = m_slot.get();
+      }
+    }
+  }
 };
 
 // Sentinel type for unified generators.
 struct unified_generator_sentinel {};
 
+// Slow path of `advance_generator` below, for generators whose last step yielded a batch. If
+// `resumed`, the generator has just been resumed and the batch is new.
+template <typename Handle>
+__attribute__((noinline)) bool advance_batched_generator(Handle& h, bool resumed) {
+  auto& promise = h.promise();
+  if (!resumed) {
+    if (promise.next_batch_value()) {
+      return true;
+    }
+    h.resume();
+  }
+  for (; !h.done(); h.resume()) {
+    if (!promise.drop_empty_batch()) {
+      return true;
+    }
+  }
+  promise.rethrow_if_exception();
+  return false;
+}
+
+// True iff. `Handle` is the handle of an inline frame that opted in via `is_unbatched`.
+template <typename Handle, typename = void>
+constexpr bool is_unbatched_handle = false;
+
+template <typename Handle>
+constexpr bool is_unbatched_handle<Handle, std::void_t<typename Handle::frame_type>> =
+    coro_detail::is_unbatched_frame<typename Handle::frame_type>::value;
+
+// Advance the generator of the handle `h` to its next value: the next value of the current batch
+// (see `yield_batch`), or the value of the next step, where empty batches are skipped. Returns
+// false (and rethrows a stored exception) once the generator is exhausted.
+template <typename Handle>
+inline bool advance_generator(Handle& h) {
+  auto& promise = h.promise();
+  if constexpr (is_unbatched_handle<Handle>) {
+    h.resume();
+    if (h.done()) {
+      promise.rethrow_if_exception();
+      return false;
+    }
+    assert(!promise.in_batch() && "frame is marked as `is_unbatched`, but yielded a batch");
+    return true;
+  }
+  if (__builtin_expect(promise.in_batch(), false)) {
+    return advance_batched_generator(h, false);
+  }
+  h.resume();
+  if (__builtin_expect(promise.in_batch(), false)) {
+    return advance_batched_generator(h, true);
+  }
+  if (h.done()) {
+    promise.rethrow_if_exception();
+    return false;
+  }
+  return true;
+}
+
 // ---------------------------------------------------------------------------
 // Unified iterator — works with both heap handles and inline handles via a
 // pointer-to-handle indirection.
@@ -175,10 +592,7 @@ class unified_generator_iterator {
   }
 
   unified_generator_iterator& operator++() {
-    m_handle->resume();
-    if (m_handle->done()) {
-      m_handle->promise().rethrow_if_exception();
-    }
+    advance_generator(*m_handle);
     return *this;
   }
 
@@ -186,9 +600,60 @@ class unified_generator_iterator {
 
   reference operator*() const noexcept { return m_handle->promise().value(); }
 
+  // The current value, moved out of the generator if possible, see
+  // `unified_generator_promise::take_value()`.
+  value_type take_value() const { return m_handle->promise().take_value(); }
+
  private:
   handle_type* m_handle;
 };
+
+// ---------------------------------------------------------------------------
+// Range over the chunks of a generator, see `unified_generator::chunks()`.
+// ---------------------------------------------------------------------------
+template <typename Generator>
+class unified_generator_chunk_range {
+  using chunk_type = generator_chunk<typename Generator::value_type>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = chunk_type;
+    using reference = const chunk_type&;
+
+    explicit iterator(Generator* gen) : m_gen(gen), m_chunk(gen->next_chunk()) {}
+
+    friend bool operator==(const iterator& it, unified_generator_sentinel) noexcept {
+      return it.m_chunk.empty();
+    }
+
+    friend bool operator!=(const iterator& it, unified_generator_sentinel s) noexcept {
+      return !(it == s);
+    }
+
+    iterator& operator++() {
+      m_chunk = m_gen->next_chunk();
+      return *this;
+    }
+
+    reference operator*() const noexcept { return m_chunk; }
+
+   private:
+    Generator* m_gen;
+    chunk_type m_chunk;
+  };
+
+  explicit unified_generator_chunk_range(Generator& gen) noexcept : m_gen(&gen) {}
+
+  iterator begin() { return iterator{m_gen}; }
+
+  unified_generator_sentinel end() noexcept { return {}; }
+
+ private:
+  Generator* m_gen;
+};
 }  // namespace detail
 
 // ---------------------------------------------------------------------------
@@ -211,17 +676,68 @@ struct InlineGeneratorPolicy {
   static constexpr bool nullable = false;
 };
 
+// Policy for generators that store their frame in a buffer of `BufferSize` bytes inside the
+// generator object if it fits, and on the heap otherwise. The handle is the same type-erased
+// handle as for the `HeapGeneratorPolicy`. Only frames that opt in via `is_relocatable` are stored
+// in the buffer, and they are relocated when the generator is moved, see
+// `stackless_coro_crtp::ramp_in_buffer`. Moving the generator thus invalidates references to its
+// current value or chunk.
+template <typename T, size_t BufferSize>
+struct SmallBufferGeneratorPolicy {
+  using promise_type = detail::unified_generator_promise<T>;
+  using handle_type = stackless_coroutine_handle<promise_type>;
+  static constexpr bool nullable = true;
+  static constexpr size_t buffer_size = BufferSize;
+};
+
+namespace detail {
+// The size of the inline frame buffer of a policy, 0 if the policy has none.
+template <typename Policy, typename = void>
+struct frame_buffer_size : std::integral_constant<size_t, 0> {};
+
+template <typename Policy>
+struct frame_buffer_size<Policy, std::void_t<decltype(Policy::buffer_size)>>
+    : std::integral_constant<size_t, Policy::buffer_size> {};
+
+// The buffer for the frames of a `SmallBufferGeneratorPolicy`. `relocate_` is only set if the
+// frame currently lives inside the `data_`.
+template <size_t BufferSize>
+struct generator_frame_buffer {
+  alignas(std::max_align_t) char data_[BufferSize];
+  RelocateFrameFunc relocate_ = nullptr;
+
+  bool holdsFrame() const noexcept { return relocate_ != nullptr; }
+
+  // Move the frame (if any) of `other` into this buffer and return the handle frame at its new
+  // location. `otherFrame` is the handle frame of `other`.
+  HandleFrame* takeFrom(generator_frame_buffer& other, HandleFrame* otherFrame) noexcept {
+    relocate_ = other.relocate_;
+    other.relocate_ = nullptr;
+    return holdsFrame() ? relocate_(otherFrame, data_) : otherFrame;
+  }
+};
+
+template <>
+struct generator_frame_buffer<0> {};
+}  // namespace detail
+
 // ---------------------------------------------------------------------------
 // Unified generator
 // ---------------------------------------------------------------------------
 template <typename T, typename Policy>
 class [[nodiscard]] unified_generator {
  public:
+  using policy_type = Policy;
   using handle_type = typename Policy::handle_type;
   using promise_type = typename Policy::promise_type;
   using iterator = detail::unified_generator_iterator<T, Policy>;
   using value_type = typename iterator::value_type;
 
+ private:
+  static constexpr size_t buffer_size = detail::frame_buffer_size<Policy>::value;
+
+ public:
+
   // Default constructor — only available for nullable policies (heap).
   template <bool Nullable = Policy::nullable, std::enable_if_t<Nullable, int> = 0>
   unified_generator() noexcept : m_handle(nullptr) {}
@@ -229,11 +745,19 @@ class [[nodiscard]] unified_generator {
   // Construct from a handle.
   explicit unified_generator(handle_type h) noexcept : m_handle(std::move(h)) {}
 
+  // Construct the handle in place from the `args`, e.g. the frame of a stackful handle.
+  template <typename... Args>
+  explicit unified_generator(std::in_place_t, Args&&... args)
+      : m_handle(std::in_place, std::forward<Args>(args)...) {}
+
   // Move-only.
   unified_generator(unified_generator&& other) noexcept : m_handle(std::move(other.m_handle)) {
     if constexpr (Policy::nullable) {
       other.m_handle = nullptr;
     }
+    if constexpr (buffer_size > 0) {
+      m_handle.ptr = m_buffer.takeFrom(other.m_buffer, m_handle.ptr);
+    }
   }
 
   unified_generator& operator=(unified_generator&& other) noexcept {
@@ -245,6 +769,9 @@ class [[nodiscard]] unified_generator {
       } else {
         m_handle = std::move(other.m_handle);
       }
+      if constexpr (buffer_size > 0) {
+        m_handle.ptr = m_buffer.takeFrom(other.m_buffer, m_handle.ptr);
+      }
     }
     return *this;
   }
@@ -265,19 +792,137 @@ class [[nodiscard]] unified_generator {
     if constexpr (Policy::nullable) {
       if (!m_handle) return iterator{nullptr};
     }
-    m_handle.resume();
-    if (m_handle.done()) {
-      m_handle.promise().rethrow_if_exception();
-    }
+    detail::advance_generator(m_handle);
     return iterator{&m_handle};
   }
 
   detail::unified_generator_sentinel end() noexcept { return detail::unified_generator_sentinel{}; }
 
-  void swap(unified_generator& other) noexcept { std::swap(m_handle, other.m_handle); }
+  // Resume the generator once and return all the values that this step produced (a batch from
+  // `yield_batch`, or a single value). Returns an empty chunk once the generator is exhausted.
+  // Empty batches are skipped. This is an alternative to the iterators, the two must not be mixed.
+  generator_chunk<value_type> next_chunk() {
+    if constexpr (Policy::nullable) {
+      if (!m_handle) return {};
+    }
+    if (m_handle.done()) {
+      return {};
+    }
+    while (true) {
+      m_handle.resume();
+      if (m_handle.done()) {
+        m_handle.promise().rethrow_if_exception();
+        return {};
+      }
+      auto chunk = m_handle.promise().take_chunk();
+      if (!chunk.empty()) {
+        return chunk;
+      }
+    }
+  }
+
+  // Internal iteration: resume the generator until it is exhausted and call `f` on each value.
+  // Compared to the iterators, there is only a single `done()` check per element, and the check for
+  // an exception is only done once at the end. For the `InlineGeneratorPolicy`, `resume()` is a
+  // direct call to `frame.doStep()`, so the frame's state machine and `f` can be inlined into one
+  // loop. If the generator has already been started, only the remaining values are visited.
+  template <typename F>
+  void for_each(F&& f) {
+    if constexpr (Policy::nullable) {
+      if (!m_handle) return;
+    }
+    if (m_handle.done()) {
+      return;
+    }
+    auto& promise = m_handle.promise();
+    if constexpr (detail::is_unbatched_handle<handle_type>) {
+      for (m_handle.resume(); !m_handle.done(); m_handle.resume()) {
+        f(promise.value());
+      }
+    } else {
+      // The rest of the current batch, if the generator was started by an iterator.
+      while (promise.next_batch_value()) {
+        f(promise.value());
+      }
+      for (m_handle.resume(); !m_handle.done(); m_handle.resume()) {
+        if (promise.in_batch()) {
+          for (const auto& value : promise.take_chunk()) {
+            f(value);
+          }
+        } else {
+          f(promise.value());
+        }
+      }
+    }
+    promise.rethrow_if_exception();
+  }
+
+  // Left fold over all the (remaining) values via `for_each`: `init = f(std::move(init), value)`.
+  template <typename Acc, typename F>
+  Acc fold(Acc init, F&& f) {
+    for_each([&](auto&& value) { init = f(std::move(init), std::forward<decltype(value)>(value)); });
+    return init;
+  }
+
+  // A range over all the chunks, consecutively obtained via `next_chunk()`.
+  detail::unified_generator_chunk_range<unified_generator> chunks() noexcept {
+    return detail::unified_generator_chunk_range<unified_generator>{*this};
+  }
+
+  // Fork a suspended inline generator, whose frame opts in via `is_cloneable` (see
+  // `stackful_coro_crtp::rebaseCopy`). The clone resumes from the same suspension point with a
+  // copy of the locals, so e.g. a parser can checkpoint its input, try one alternative on the
+  // original, and continue from the checkpoint with the clone. Both generators continue with the
+  // element after the current one (the next `begin()` resumes).
+  template <typename H = handle_type,
+            std::enable_if_t<coro_detail::is_cloneable_frame<typename H::frame_type>::value, int> =
+                0>
+  unified_generator clone() const {
+    return unified_generator{clone_frame, *this};
+  }
+
+  // Direct access to the handle, used by adaptors that drive the generator step by step (see
+  // `generator/combinators.h`).
+  handle_type& handle() noexcept { return m_handle; }
+  const handle_type& handle() const noexcept { return m_handle; }
+
+  void swap(unified_generator& other) noexcept {
+    if constexpr (buffer_size > 0) {
+      unified_generator tmp{std::move(other)};
+      other = std::move(*this);
+      *this = std::move(tmp);
+    } else {
+      std::swap(m_handle, other.m_handle);
+    }
+  }
+
+  // Interface for `stackless_coro_crtp::ramp_in_buffer`, only available for policies with a frame
+  // buffer.
+  template <size_t N = buffer_size, std::enable_if_t<(N > 0), int> = 0>
+  void* frame_buffer(size_t size, size_t alignment) noexcept {
+    return size <= N && alignment <= alignof(std::max_align_t) ? m_buffer.data_ : nullptr;
+  }
+
+  template <size_t N = buffer_size, std::enable_if_t<(N > 0), int> = 0>
+  void adopt(handle_type h, RelocateFrameFunc relocate) noexcept {
+    m_handle = h;
+    m_buffer.relocate_ = relocate;
+  }
+
+  // True iff the frame lives inside the buffer of this generator.
+  template <size_t N = buffer_size, std::enable_if_t<(N > 0), int> = 0>
+  bool frame_is_inline() const noexcept {
+    return m_buffer.holdsFrame();
+  }
 
  private:
+  // The frame of the clone is copied in place, as the frame of an inline generator must not be
+  // moved after it has been started.
+  unified_generator(clone_frame_t, const unified_generator& other)
+      : m_handle(clone_frame, other.m_handle) {}
+
   handle_type m_handle;
+  [[no_unique_address]] detail::generator_frame_buffer<buffer_size> m_buffer;
 };
 
 template <typename T, typename Policy>
@@ -304,4 +949,7 @@ using heap_generator = unified_generator<T, HeapGeneratorPolicy<T>>;
 template <typename T, typename CoroFrame>
 using inline_gen = unified_generator<T, InlineGeneratorPolicy<T, CoroFrame>>;
 
+template <typename T, size_t BufferSize = 128>
+using small_generator = unified_generator<T, SmallBufferGeneratorPolicy<T, BufferSize>>;
+
 #endif  // GENERATOR_REWRITE_EXAMPLES_UNIFIED_GENERATOR_H
\ No newline at end of file
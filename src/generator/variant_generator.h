@@ -0,0 +1,132 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_VARIANT_GENERATOR_H
+#define GENERATOR_REWRITE_EXAMPLES_VARIANT_GENERATOR_H
+
+// A generator that stores any one of a closed set of inline (stackful) coroutine frames by value.
+// This is the alternative to returning a `heap_generator` from a function that chooses between
+// several generator implementations at runtime: there is no heap allocation, and `resume()`,
+// `done()` and `promise()` dispatch via a switch on the index of the active frame instead of the
+// `resumeFunc` pointer in the `HandleFrame`. As the set of frames is known, the compiler can inline
+// all the alternatives into the consumer's loop.
+//
+// Example:
+//   using Iota = inline_frame_t<decltype(iota_unified<false>(0, 0))>;
+//   using Evens = inline_frame_t<decltype(iota_unified<false>(0, 0) | combinators::map(twice))>;
+//   variant_generator<Iota, Evens> numbers(bool evens, int n) {
+//     auto iota = iota_unified<false>(0, n);
+//     if (evens) return make_variant_generator<Iota, Evens>(std::move(iota) | map(twice));
+//     return make_variant_generator<Iota, Evens>(std::move(iota));
+//   }
+//
+// All the frames must have the same promise type. As with all inline generators, a
+// `variant_generator` must not be moved after it has been started.
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "generator/unified_generator.h"
+#include "util/coroutine_handle.h"
+
+// The frame type of an inline generator.
+template <typename InlineGenerator>
+using inline_frame_t = std::decay_t<decltype(std::declval<InlineGenerator&>().handle().frame)>;
+
+namespace detail {
+template <typename Promise>
+struct generator_promise_traits;
+
+template <typename T>
+struct generator_promise_traits<unified_generator_promise<T>> {
+  using yield_type = T;
+};
+
+// Holds exactly one of the `Frames` and provides the interface of a stackful frame that
+// `stackful_coroutine_handle` needs.
+template <typename... Frames>
+class variant_frame {
+  static_assert(sizeof...(Frames) > 0);
+  using First = std::tuple_element_t<0, std::tuple<Frames...>>;
+
+ public:
+  using promise_type = std::decay_t<decltype(std::declval<First&>().promise())>;
+  static_assert((std::is_same_v<promise_type,
+                                std::decay_t<decltype(std::declval<Frames&>().promise())>> &&
+                 ...),
+                "All the frames of a `variant_generator` must have the same promise type");
+
+  template <typename Frame, typename = std::enable_if_t<(std::is_same_v<Frame, Frames> || ...)>>
+  variant_frame(Frame&& frame) noexcept(std::is_nothrow_move_constructible_v<Frame>)
+      : frames_(std::in_place_type<Frame>, std::move(frame)) {}
+
+  size_t index() const noexcept { return frames_.index(); }
+
+  void doStep() {
+    visit([](auto& frame) { frame.doStep(); });
+  }
+  void destroy() {
+    visit([](auto& frame) { frame.destroy(); });
+  }
+  bool done() const {
+    return visit([](const auto& frame) { return frame.done(); });
+  }
+  promise_type& promise() {
+    return visit([](auto& frame) -> promise_type& { return frame.promise(); });
+  }
+  const promise_type& promise() const {
+    return visit([](const auto& frame) -> const promise_type& { return frame.promise(); });
+  }
+
+ private:
+  // A chain of index comparisons, which the compiler turns into a switch (or a single branch for
+  // two frames). Unlike `std::visit`, this never throws `std::bad_variant_access`, as frames can't
+  // throw during a move (a `valueless_by_exception` variant is not considered).
+  template <size_t I = 0, typename Self, typename F>
+  static decltype(auto) visitImpl(Self& self, F&& f) {
+    if constexpr (I + 1 == sizeof...(Frames)) {
+      return f(*std::get_if<I>(&self.frames_));
+    } else {
+      if (self.frames_.index() == I) {
+        return f(*std::get_if<I>(&self.frames_));
+      }
+      return visitImpl<I + 1>(self, std::forward<F>(f));
+    }
+  }
+
+  template <typename F>
+  decltype(auto) visit(F&& f) {
+    return visitImpl(*this, std::forward<F>(f));
+  }
+  template <typename F>
+  decltype(auto) visit(F&& f) const {
+    return visitImpl(*this, std::forward<F>(f));
+  }
+
+  std::variant<Frames...> frames_;
+};
+}  // namespace detail
+
+template <typename... Frames>
+struct VariantGeneratorPolicy {
+  using frame_type = detail::variant_frame<Frames...>;
+  using promise_type = typename frame_type::promise_type;
+  using handle_type = stackful_coroutine_handle<frame_type>;
+  static constexpr bool nullable = false;
+};
+
+template <typename... Frames>
+using variant_generator = unified_generator<
+    typename detail::generator_promise_traits<
+        typename VariantGeneratorPolicy<Frames...>::promise_type>::yield_type,
+    VariantGeneratorPolicy<Frames...>>;
+
+// Move the frame of the inline generator `gen` into a `variant_generator<Frames...>`. `gen` must
+// not have been started yet. The frame is moved directly into its alternative inside the returned
+// generator, the `std::variant` itself is never moved.
+template <typename... Frames, typename T, typename Frame>
+variant_generator<Frames...> make_variant_generator(inline_gen<T, Frame>&& gen) {
+  return variant_generator<Frames...>{std::in_place, std::move(gen.handle().frame)};
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_VARIANT_GENERATOR_H
@@ -0,0 +1,529 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_EVENT_LOOP_H
+#define GENERATOR_REWRITE_EXAMPLES_EVENT_LOOP_H
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "task/when_all.h"
+#include "util/coroutine_handle.h"
+#include "util/timer_wheel.h"
+
+// A single-threaded event loop on top of `epoll` that drives stackless coroutines (e.g.
+// `task<T, stackless_coroutine_handle>`). The thread that calls `run()` or `run_once()` resumes
+// all the coroutines. A coroutine waits for a file descriptor (pipe, socket, eventfd, ...) via
+//   fd_watch watch{loop, fd};
+//   co_await watch.readable();  // or `watch.writable()`
+// moves itself onto the loop (from any thread) via
+//   co_await loop.schedule();
+// and, on the loop thread, waits for some time or bounds the time it waits for another task via
+//   co_await loop.sleep_for(10ms);
+//   std::optional<T> result = co_await loop.with_deadline(someTask(), 10ms);
+//
+// The file descriptors are registered once, edge-triggered, for both directions. An edge without a
+// waiting coroutine is remembered in the `fd_watch`, and the next await of that direction then
+// doesn't suspend. The usual pattern is therefore to read/write until `EAGAIN`, then await the
+// readiness and retry. At most one coroutine may wait for each direction of an `fd_watch`.
+//
+// Each iteration first collects all the coroutines that became ready (from `epoll_wait`, from
+// `schedule()` on the loop thread, and from other threads), then resumes them as a batch. As no
+// `epoll_event` is looked at after the first coroutine was resumed, a coroutine may destroy any
+// `fd_watch` (including its own) without leaving stale events behind. A coroutine that waits for an
+// `fd_watch` or in `sleep_for()` may also be destroyed after it was collected for the batch, its
+// awaiter then removes it from the batch (see `event_loop::forget()`). This doesn't hold for
+// `schedule()` and for the parent of `with_deadline()` after the deadline has passed: these
+// coroutines must not be destroyed before they were resumed.
+//
+// Other threads hand over coroutines through a mutex-protected queue and wake the loop via an
+// eventfd, which is only written if the loop hasn't been woken up since it last drained the queue.
+//
+// The timers live in a hierarchical timing wheel with a resolution of 1 ms (see
+// `util/timer_wheel.h`). Their nodes are members of the awaiters, so arming, cancelling and
+// expiring a timer doesn't allocate. The expired timers of an iteration are resumed together with
+// the other ready coroutines, and `epoll_wait` sleeps at most until the next expiry.
+//
+// Coroutines that are still suspended when the loop is destroyed are not resumed.
+class event_loop;
+
+// The registration of a file descriptor with an `event_loop`. Neither copyable nor movable, as
+// the loop refers to it by its address. The file descriptor has to be non-blocking, and must stay
+// open until the `fd_watch` is destroyed.
+class fd_watch {
+ public:
+  fd_watch(event_loop& loop, int fd);
+  ~fd_watch();
+
+  fd_watch(const fd_watch&) = delete;
+  fd_watch& operator=(const fd_watch&) = delete;
+
+  int fd() const noexcept { return fd_; }
+
+ private:
+  // The state of one direction (readable or writable).
+  struct direction {
+    stackless_coroutine_handle<void> waiter_;
+    bool ready_ = false;
+  };
+
+ public:
+  class awaiter {
+   public:
+    awaiter(event_loop& loop, direction& dir) noexcept : loop_(loop), dir_(dir) {}
+    awaiter(const awaiter& other) noexcept : loop_(other.loop_), dir_(other.dir_) {}
+
+    // Consumes a readiness edge that arrived while nobody was waiting.
+    bool await_ready() noexcept { return std::exchange(dir_.ready_, false); }
+
+    template <typename Promise>
+    void await_suspend(stackless_coroutine_handle<Promise> h) noexcept {
+      frame_ = h.ptr;
+      dir_.waiter_ = stackless_coroutine_handle<void>{frame_};
+      suspended_ = true;
+    }
+
+    void await_resume() noexcept { suspended_ = false; }
+
+    // The awaiting coroutine is destroyed while it is suspended, either still waiting, or already
+    // collected to be resumed by the loop.
+    ~awaiter();
+
+   private:
+    event_loop& loop_;
+    direction& dir_;
+    HandleFrame* frame_ = nullptr;
+    bool suspended_ = false;
+  };
+
+  awaiter readable() noexcept { return awaiter{loop_, in_}; }
+  awaiter writable() noexcept { return awaiter{loop_, out_}; }
+
+ private:
+  friend class event_loop;
+
+  // Called by the loop for an `epoll_event`, collects the waiters that have to be resumed.
+  void notify(uint32_t events, std::vector<HandleFrame*>& ready) {
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+      signal(in_, ready);
+    }
+    if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+      signal(out_, ready);
+    }
+  }
+
+  static void signal(direction& dir, std::vector<HandleFrame*>& ready) {
+    if (dir.waiter_) {
+      ready.push_back(dir.waiter_.ptr);
+      dir.waiter_ = nullptr;
+    } else {
+      dir.ready_ = true;
+    }
+  }
+
+  event_loop& loop_;
+  int fd_;
+  direction in_;
+  direction out_;
+};
+
+class event_loop {
+ public:
+  // `maxEvents` is the maximum number of `epoll_event`s per iteration.
+  explicit event_loop(size_t maxEvents = 256) : events_(maxEvents) {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      throw std::system_error{errno, std::system_category(), "epoll_create1"};
+    }
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+      int error = errno;
+      ::close(epoll_fd_);
+      throw std::system_error{error, std::system_category(), "eventfd"};
+    }
+    // The wakeup eventfd is the only registration with a null pointer.
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = nullptr;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) < 0) {
+      int error = errno;
+      ::close(wake_fd_);
+      ::close(epoll_fd_);
+      throw std::system_error{error, std::system_category(), "epoll_ctl"};
+    }
+  }
+
+  event_loop(const event_loop&) = delete;
+  event_loop& operator=(const event_loop&) = delete;
+
+  ~event_loop() {
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+  }
+
+  // Awaiter for `co_await loop.schedule()`.
+  struct schedule_awaiter {
+    event_loop& loop_;
+
+    static constexpr bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    void await_suspend(stackless_coroutine_handle<Promise> h) {
+      loop_.enqueue(stackless_coroutine_handle<void>{h.ptr});
+    }
+
+    static constexpr void await_resume() noexcept {}
+  };
+
+  schedule_awaiter schedule() noexcept { return schedule_awaiter{*this}; }
+
+  // Awaiter for `co_await loop.sleep_for(duration)`, which has to be awaited on the loop thread.
+  // The timer is disarmed if the sleeping coroutine is destroyed, or the coroutine is removed from
+  // the batch if the timer has already expired.
+  class sleep_awaiter {
+   public:
+    sleep_awaiter(event_loop& loop, uint64_t ticks) noexcept : loop_(&loop), ticks_(ticks) {}
+
+    ~sleep_awaiter() {
+      if (node_.armed()) {
+        loop_->timers_.cancel(node_);
+      } else if (node_.waiter_) {
+        loop_->forget(node_.waiter_.ptr);
+      }
+    }
+
+    bool await_ready() const noexcept { return ticks_ == 0; }
+
+    template <typename Promise>
+    void await_suspend(stackless_coroutine_handle<Promise> h) noexcept {
+      node_.waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      loop_->arm(node_, ticks_);
+    }
+
+    void await_resume() noexcept { node_.waiter_ = nullptr; }
+
+   private:
+    struct node : coro_detail::timer_node {
+      node() noexcept : timer_node(&node::expire) {}
+
+      static stackless_coroutine_handle<void> expire(timer_node& n) noexcept {
+        return static_cast<node&>(n).waiter_;
+      }
+
+      stackless_coroutine_handle<void> waiter_;
+    };
+
+    event_loop* loop_;
+    uint64_t ticks_;
+    node node_;
+  };
+
+  template <typename Rep, typename Period>
+  sleep_awaiter sleep_for(std::chrono::duration<Rep, Period> duration) noexcept {
+    return sleep_awaiter{*this, to_ticks(duration)};
+  }
+
+  // Awaiter for `co_await loop.with_deadline(task, duration)`, which has to be awaited on the loop
+  // thread. Starts the `task` and resumes the awaiting coroutine when the task has finished, or
+  // when the `duration` has elapsed, whatever comes first. The result is the result of the task
+  // (`true` for `task<void>`), or empty if the deadline has passed. The task has to finish on the
+  // loop thread.
+  //
+  // If the deadline passes, the task is detached: it keeps running until it is done (its result
+  // is discarded), so that it can't be resumed after it was destroyed. Only this case allocates.
+  template <typename Task>
+  class deadline_awaiter {
+   public:
+    using value_type = detail::task_value_t<Task>;
+    using result_type =
+        std::conditional_t<std::is_void_v<value_type>, bool, std::optional<value_type>>;
+
+    deadline_awaiter(event_loop& loop, Task&& task, uint64_t ticks)
+        : loop_(&loop), task_(std::move(task)), ticks_(ticks) {}
+
+    // Only valid before the awaiter was awaited.
+    deadline_awaiter(deadline_awaiter&& other) noexcept
+        : loop_(other.loop_), task_(std::move(other.task_)), ticks_(other.ticks_) {}
+
+    ~deadline_awaiter() {
+      loop_->timers_.cancel(timer_);
+      if (started_ && !done_) {
+        new detached<Task>(std::move(task_));
+      }
+    }
+
+    static constexpr bool await_ready() noexcept { return false; }
+
+    // Returns false (don't suspend) if the task completed synchronously.
+    template <typename Promise>
+    bool await_suspend(stackless_coroutine_handle<Promise> parent) {
+      parent_ = stackless_coroutine_handle<void>{parent.ptr};
+      timer_.owner_ = this;
+      completion_.owner_ = this;
+      loop_->arm(timer_, ticks_);
+      auto h = task_.handle();
+      h.promise().continuation_ = completion_.handle();
+      h.resume();
+      started_ = true;
+      return !done_;
+    }
+
+    // The task may have finished after the deadline, but before the parent was resumed.
+    result_type await_resume() {
+      if (!done_) {
+        return result_type{};
+      }
+      if constexpr (std::is_void_v<value_type>) {
+        task_.result();
+        return true;
+      } else {
+        return std::move(task_.result());
+      }
+    }
+
+    // The task has finished. The parent has already been scheduled if the timer expired first.
+    stackless_coroutine_handle<void> on_child_done(size_t) noexcept {
+      loop_->timers_.cancel(timer_);
+      done_ = true;
+      return started_ && !timedOut_ ? parent_ : stackless_coroutine_handle<void>{};
+    }
+
+   private:
+    struct node : coro_detail::timer_node {
+      node() noexcept : timer_node(&node::expire) {}
+
+      static stackless_coroutine_handle<void> expire(timer_node& n) noexcept {
+        deadline_awaiter* owner = static_cast<node&>(n).owner_;
+        owner->timedOut_ = true;
+        return owner->parent_;
+      }
+
+      deadline_awaiter* owner_ = nullptr;
+    };
+
+    // Owns a task whose deadline has passed, and deletes itself (and the task) when it is done.
+    template <typename T>
+    struct detached {
+      explicit detached(T&& task) : task_(std::move(task)) {
+        completion_.owner_ = this;
+        task_.handle().promise().continuation_ = completion_.handle();
+      }
+
+      stackless_coroutine_handle<void> on_child_done(size_t) noexcept {
+        delete this;
+        return {};
+      }
+
+      T task_;
+      detail::completion_frame<detached> completion_;
+    };
+
+    event_loop* loop_;
+    Task task_;
+    uint64_t ticks_;
+    stackless_coroutine_handle<void> parent_;
+    node timer_;
+    detail::completion_frame<deadline_awaiter> completion_;
+    bool started_ = false;
+    bool done_ = false;
+    bool timedOut_ = false;
+  };
+
+  // The task is taken by value, so a task in a variable has to be moved in explicitly.
+  template <typename Task, typename Rep, typename Period,
+            std::enable_if_t<detail::is_task<Task>::value, int> = 0>
+  deadline_awaiter<Task> with_deadline(Task task, std::chrono::duration<Rep, Period> duration) {
+    return deadline_awaiter<Task>{*this, std::move(task), to_ticks(duration)};
+  }
+
+  // The number of armed timers.
+  size_t num_timers() const noexcept { return timers_.size(); }
+
+  // Resume `h` on the loop thread in one of the next iterations. Can be called from any thread.
+  void enqueue(stackless_coroutine_handle<void> h) {
+    if (current_loop_ == this) {
+      ready_.push_back(h.ptr);
+      return;
+    }
+    {
+      std::lock_guard lock{remote_mutex_};
+      remote_.push_back(h.ptr);
+    }
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+      wake();
+    }
+  }
+
+  // Run a single iteration: wait for at most `timeoutMs` milliseconds (-1 means no timeout, and
+  // there is no waiting if coroutines are already ready), then resume all the ready coroutines.
+  // Returns the number of resumed coroutines.
+  size_t run_once(int timeoutMs = -1) {
+    event_loop* previous = std::exchange(current_loop_, this);
+    int timeout = ready_.empty() ? timeoutMs : 0;
+    if (timeout != 0 && timers_.size() > 0) {
+      const uint64_t next = timers_.next_expiry();
+      const uint64_t now = now_ticks();
+      const int untilNext =
+          next <= now ? 0 : static_cast<int>(std::min<uint64_t>(next - now, INT_MAX));
+      timeout = timeout < 0 ? untilNext : std::min(timeout, untilNext);
+    }
+    const int n = ::epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()),
+                               timeout);
+    if (n < 0 && errno != EINTR) {
+      current_loop_ = previous;
+      throw std::system_error{errno, std::system_category(), "epoll_wait"};
+    }
+    bool woken = false;
+    for (int i = 0; i < n; ++i) {
+      if (auto* watch = static_cast<fd_watch*>(events_[i].data.ptr)) {
+        watch->notify(events_[i].events, ready_);
+      } else {
+        woken = true;
+      }
+    }
+    if (woken) {
+      uint64_t value;
+      [[maybe_unused]] auto res = ::read(wake_fd_, &value, sizeof(value));
+      // Synchronizes with the `exchange` in `enqueue`, the queue is drained afterwards.
+      wake_pending_.exchange(false, std::memory_order_acq_rel);
+      std::lock_guard lock{remote_mutex_};
+      ready_.insert(ready_.end(), remote_.begin(), remote_.end());
+      remote_.clear();
+    }
+    if (timers_.size() > 0) {
+      timers_.advance(now_ticks(), ready_);
+    }
+
+    batch_.swap(ready_);
+    size_t numResumed = 0;
+    // Entries that were removed by `forget()` are null.
+    for (HandleFrame* h : batch_) {
+      if (h) {
+        stackless_coroutine_handle<void>{h}.resume();
+        ++numResumed;
+      }
+    }
+    batch_.clear();
+    current_loop_ = previous;
+    return numResumed;
+  }
+
+  // Run iterations until `stop()` is called. The stop request is consumed, so `run()` can be
+  // called again afterwards.
+  void run() {
+    while (!stopped_.exchange(false, std::memory_order_acquire)) {
+      run_once();
+    }
+  }
+
+  // Make `run()` return after the current iteration. Can be called from any thread.
+  void stop() {
+    stopped_.store(true, std::memory_order_release);
+    if (current_loop_ != this && !wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+      wake();
+    }
+  }
+
+  // True if the calling thread is inside `run_once()` of this loop.
+  bool on_loop_thread() const noexcept { return current_loop_ == this; }
+
+ private:
+  friend class fd_watch;
+
+  void add(fd_watch& watch) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = &watch;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, watch.fd(), &ev) < 0) {
+      throw std::system_error{errno, std::system_category(), "epoll_ctl"};
+    }
+  }
+
+  void remove(fd_watch& watch) noexcept {
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, watch.fd(), nullptr);
+  }
+
+  // Don't resume the coroutine `frame`, which is about to be destroyed, although it was already
+  // collected to be resumed in this or the next batch. Only called on the loop thread, and only on
+  // the rare path where a suspended coroutine is destroyed, so the linear search is fine.
+  void forget(HandleFrame* frame) noexcept {
+    std::replace(ready_.begin(), ready_.end(), frame, static_cast<HandleFrame*>(nullptr));
+    std::replace(batch_.begin(), batch_.end(), frame, static_cast<HandleFrame*>(nullptr));
+  }
+
+  template <typename Rep, typename Period>
+  static uint64_t to_ticks(std::chrono::duration<Rep, Period> duration) noexcept {
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(duration).count();
+    return ms > 0 ? static_cast<uint64_t>(ms) : 0;
+  }
+
+  // The milliseconds since the construction of the loop.
+  uint64_t now_ticks() const noexcept {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_).count());
+  }
+
+  // Arm the `node` to expire after `ticks`. The current tick has already partially elapsed, so
+  // the expiry is one tick later to never expire early.
+  void arm(coro_detail::timer_node& node, uint64_t ticks) noexcept {
+    timers_.insert(node, now_ticks() + ticks + 1);
+  }
+
+  void wake() noexcept {
+    uint64_t one = 1;
+    [[maybe_unused]] auto res = ::write(wake_fd_, &one, sizeof(one));
+  }
+
+  using clock = std::chrono::steady_clock;
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::vector<epoll_event> events_;
+
+  // Only accessed by the loop thread. `batch_` is the current batch, kept as a member to reuse its
+  // allocation.
+  std::vector<HandleFrame*> ready_;
+  std::vector<HandleFrame*> batch_;
+
+  // Coroutines that were enqueued by other threads.
+  std::mutex remote_mutex_;
+  std::vector<HandleFrame*> remote_;
+  // True if the eventfd was written and the loop has not yet drained `remote_`.
+  std::atomic<bool> wake_pending_{false};
+  std::atomic<bool> stopped_{false};
+
+  // Only accessed by the loop thread.
+  clock::time_point start_ = clock::now();
+  coro_detail::timer_wheel timers_;
+
+  static inline thread_local event_loop* current_loop_ = nullptr;
+};
+
+inline fd_watch::fd_watch(event_loop& loop, int fd) : loop_(loop), fd_(fd) { loop_.add(*this); }
+
+inline fd_watch::~fd_watch() { loop_.remove(*this); }
+
+inline fd_watch::awaiter::~awaiter() {
+  if (!suspended_) {
+    return;
+  }
+  if (dir_.waiter_.ptr == frame_) {
+    dir_.waiter_ = nullptr;
+  } else {
+    loop_.forget(frame_);
+  }
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_EVENT_LOOP_H
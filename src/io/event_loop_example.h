@@ -0,0 +1,361 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_EVENT_LOOP_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_EVENT_LOOP_EXAMPLE_H
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+#include "io/event_loop.h"
+#include "task/task.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> loop_compute_value(event_loop& loop, size_t x) {
+ *     co_await loop.schedule();
+ *     co_return x * 2;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> loop_compute_value(event_loop& loop, size_t x) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    event_loop& loop_;
+    size_t x_;
+
+    coro_storage<event_loop::schedule_awaiter&, true> schedule_awaiter_;
+
+    CoroFrame(event_loop& loop, size_t x) : loop_(loop), x_(x) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, schedule_awaiter_, this->loop_.schedule());
+      CO_RETURN_VALUE(2, final_awaiter_, (this->x_ * 2));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->schedule_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(loop, x);
+}
+
+/**
+ * Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> sleepy_compute_value(
+ *       event_loop& loop, size_t x, std::chrono::milliseconds delay) {
+ *     co_await loop.sleep_for(delay);
+ *     co_return x * 2;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> sleepy_compute_value(
+    event_loop& loop, size_t x, std::chrono::milliseconds delay) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    event_loop& loop_;
+    size_t x_;
+    std::chrono::milliseconds delay_;
+
+    // Contains the intrusive timer node, so sleeping doesn't allocate.
+    coro_storage<event_loop::sleep_awaiter&, true> sleep_awaiter_;
+
+    CoroFrame(event_loop& loop, size_t x, std::chrono::milliseconds delay)
+        : loop_(loop), x_(x), delay_(delay) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, sleep_awaiter_, this->loop_.sleep_for(this->delay_));
+      CO_RETURN_VALUE(2, final_awaiter_, (this->x_ * 2));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->sleep_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(loop, x, delay);
+}
+
+/**
+ * Reads `size` bytes from the non-blocking fd of the `watch`, or less if the end of the file is
+ * reached first. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> read_exactly(fd_watch& watch, char* buffer,
+ *                                                         size_t size) {
+ *     size_t done = 0;
+ *     while (done < size) {
+ *       ssize_t n = ::read(watch.fd(), buffer + done, size - done);
+ *       if (n > 0) {
+ *         done += n;
+ *       } else if (n == 0) {
+ *         break;
+ *       } else if (errno == EAGAIN) {
+ *         co_await watch.readable();
+ *       } else if (errno != EINTR) {
+ *         throw std::system_error{errno, std::system_category(), "read"};
+ *       }
+ *     }
+ *     co_return done;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> read_exactly(fd_watch& watch, char* buffer,
+                                                             size_t size) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    fd_watch& watch_;
+    char* buffer_;
+    size_t size_;
+    size_t done_ = 0;
+
+    coro_storage<fd_watch::awaiter&, true> readable_awaiter_;
+
+    CoroFrame(fd_watch& watch, char* buffer, size_t size)
+        : watch_(watch), buffer_(buffer), size_(size) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (this->done_ < this->size_) {
+        {
+          ssize_t n = ::read(this->watch_.fd(), this->buffer_ + this->done_,
+                             this->size_ - this->done_);
+          if (n > 0) {
+            this->done_ += static_cast<size_t>(n);
+            continue;
+          }
+          if (n == 0) {
+            break;
+          }
+          if (errno == EINTR) {
+            continue;
+          }
+          if (errno != EAGAIN) {
+            throw std::system_error{errno, std::system_category(), "read"};
+          }
+        }
+        CO_AWAIT(1, readable_awaiter_, this->watch_.readable());
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->done_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->readable_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    // The exception is thrown outside of the `co_await`, where no awaiter is alive.
+    ExceptionResult dispatchExceptionHandling() { return this->unhandled_exception(); }
+  };
+  return CoroFrame::ramp(watch, buffer, size);
+}
+
+/**
+ * Writes all the `size` bytes to the non-blocking fd of the `watch`. Manually lowered equivalent
+ * of `read_exactly` above, with `::write` and `co_await watch.writable()`.
+ */
+inline task<size_t, stackless_coroutine_handle> write_all(fd_watch& watch, const char* data,
+                                                          size_t size) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    fd_watch& watch_;
+    const char* data_;
+    size_t size_;
+    size_t done_ = 0;
+
+    coro_storage<fd_watch::awaiter&, true> writable_awaiter_;
+
+    CoroFrame(fd_watch& watch, const char* data, size_t size)
+        : watch_(watch), data_(data), size_(size) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (this->done_ < this->size_) {
+        {
+          ssize_t n = ::write(this->watch_.fd(), this->data_ + this->done_,
+                              this->size_ - this->done_);
+          if (n >= 0) {
+            this->done_ += static_cast<size_t>(n);
+            continue;
+          }
+          if (errno == EINTR) {
+            continue;
+          }
+          if (errno != EAGAIN) {
+            throw std::system_error{errno, std::system_category(), "write"};
+          }
+        }
+        CO_AWAIT(1, writable_awaiter_, this->watch_.writable());
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->done_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->writable_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    ExceptionResult dispatchExceptionHandling() { return this->unhandled_exception(); }
+  };
+  return CoroFrame::ramp(watch, data, size);
+}
+
+/**
+ * Serves one connection: reads messages of `messageSize` bytes and writes them back, until the
+ * peer closes the connection. Returns the number of echoed messages. Manually lowered equivalent
+ * of:
+ *   task<size_t, stackless_coroutine_handle> echo_connection(event_loop& loop, int fd,
+ *                                                            size_t messageSize) {
+ *     fd_watch watch{loop, fd};
+ *     std::string buffer(messageSize, '\0');
+ *     size_t numMessages = 0;
+ *     while (co_await read_exactly(watch, buffer.data(), messageSize) == messageSize) {
+ *       co_await write_all(watch, buffer.data(), messageSize);
+ *       ++numMessages;
+ *     }
+ *     co_return numMessages;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> echo_connection(event_loop& loop, int fd,
+                                                                size_t messageSize) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  using inner_task = task<size_t, stackless_coroutine_handle>;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    fd_watch watch_;
+    std::string buffer_;
+    size_t messageSize_;
+    size_t numMessages_ = 0;
+    size_t numRead_ = 0;
+
+    coro_storage<inner_task&, true> task_storage_;
+    coro_storage<detail::task_awaiter<size_t, stackless_coroutine_handle>&, true> awaiter_storage_;
+
+    CoroFrame(event_loop& loop, int fd, size_t messageSize)
+        : watch_(loop, fd), buffer_(messageSize, '\0'), messageSize_(messageSize) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (true) {
+        CO_INIT(task_storage_,
+                (read_exactly(this->watch_, this->buffer_.data(), this->messageSize_)));
+        CO_AWAIT(1, awaiter_storage_, CO_GET(task_storage_), this->numRead_ =);
+        this->task_storage_.destroy();
+        if (this->numRead_ != this->messageSize_) {
+          break;
+        }
+        CO_INIT(task_storage_,
+                (write_all(this->watch_, this->buffer_.data(), this->messageSize_)));
+        CO_AWAIT(2, awaiter_storage_, CO_GET(task_storage_));
+        this->task_storage_.destroy();
+        ++this->numMessages_;
+      }
+      CO_RETURN_VALUE(3, final_awaiter_, (this->numMessages_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+        case 2:
+          this->awaiter_storage_.destroy();
+          this->task_storage_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+
+    // I/O errors are rethrown by `await_resume()` of the inner tasks.
+    ExceptionResult dispatchExceptionHandling() {
+      this->awaiter_storage_.destroy();
+      this->task_storage_.destroy();
+      return this->unhandled_exception();
+    }
+  };
+  return CoroFrame::ramp(loop, fd, messageSize);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_EVENT_LOOP_EXAMPLE_H
@@ -0,0 +1,439 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_FILE_IO_H
+#define GENERATOR_REWRITE_EXAMPLES_FILE_IO_H
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "task/thread_pool.h"
+#include "util/coroutine_handle.h"
+
+// Asynchronous reads and writes of regular files for stackless coroutines (e.g.
+// `task<T, stackless_coroutine_handle>`):
+//   file_io io;
+//   size_t n = co_await io.async_read(fd, buffer, size, offset);
+// The awaiting coroutine is suspended until the request has completed, and is then resumed by the
+// thread that calls `io.run_once()`. Errors are thrown as `std::system_error` by `co_await`.
+//
+// The default backend is io_uring, driven directly by the raw syscalls (no liburing):
+// - Submissions are batched: `async_read` / `async_write` only fill a submission queue entry, and
+//   the next `run_once()` submits all of them with a single `io_uring_enter`, which also waits for
+//   and reaps the completions. Only a full submission queue causes an early submit.
+// - `register_buffers()` pins buffers in the kernel. Requests whose buffer lies inside one of them
+//   automatically use `IORING_OP_READ_FIXED` / `IORING_OP_WRITE_FIXED`, which saves the page
+//   mapping for each request.
+//
+// If io_uring is unavailable (old kernel, or forbidden by seccomp) or the `thread_pool` backend is
+// requested, each request instead runs `pread`/`pwrite` on a `thread_pool` (see
+// `task/thread_pool.h`). The coroutines are still resumed by `run_once()`, so the code that uses
+// `file_io` doesn't depend on the backend.
+//
+// A `file_io` is not thread-safe: the requests have to be issued from, and `run_once()` has to be
+// called by, a single thread.
+enum class file_io_backend { io_uring, thread_pool };
+
+namespace coro_detail {
+inline int io_uring_setup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+inline int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned numArgs) {
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, numArgs));
+}
+
+// The ring indices are shared with the kernel.
+inline unsigned load_acquire(const unsigned* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+inline void store_release(unsigned* p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+// The mapped submission and completion queues of an io_uring instance.
+class io_uring_queues {
+ public:
+  // Throws `std::system_error` if io_uring is not available.
+  explicit io_uring_queues(unsigned entries) {
+    io_uring_params params{};
+    fd_ = io_uring_setup(entries, &params);
+    if (fd_ < 0) {
+      throw std::system_error{errno, std::system_category(), "io_uring_setup"};
+    }
+    try {
+      sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+      }
+      sq_ring_ = map(sq_size_, IORING_OFF_SQ_RING);
+      cq_ring_ = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq_ring_
+                                                               : map(cq_size_, IORING_OFF_CQ_RING);
+      sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+      sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+
+      auto* sq = static_cast<char*>(sq_ring_);
+      sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+      sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+      sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+      sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+      sq_entries_ = params.sq_entries;
+      auto* cq = static_cast<char*>(cq_ring_);
+      cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+      cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+      cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+      cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  io_uring_queues(const io_uring_queues&) = delete;
+  io_uring_queues& operator=(const io_uring_queues&) = delete;
+
+  ~io_uring_queues() { release(); }
+
+  int fd() const noexcept { return fd_; }
+
+  // The next free submission queue entry (zeroed), or `nullptr` if the queue is full. The entry is
+  // visible to the kernel after the next `enter()`.
+  io_uring_sqe* next_sqe() noexcept {
+    const unsigned tail = sq_local_tail_;
+    if (tail - load_acquire(sq_head_) >= sq_entries_) {
+      return nullptr;
+    }
+    const unsigned index = tail & sq_mask_;
+    sq_array_[index] = index;
+    sq_local_tail_ = tail + 1;
+    sqes_[index] = io_uring_sqe{};
+    return &sqes_[index];
+  }
+
+  // Submit all the new entries, and wait until at least `minComplete` requests have completed. The
+  // kernel may consume fewer entries than requested, so this loops until all are submitted. If it
+  // is busy (`EAGAIN` / `EBUSY`, e.g. because the completion queue overflowed), the completions
+  // are reaped via `onComplete` (see `reap()`) to make room, and the submission is retried.
+  template <typename F>
+  void enter(unsigned minComplete, F&& onComplete) {
+    store_release(sq_tail_, sq_local_tail_);
+    // Includes the entries of an earlier partial submission.
+    unsigned toSubmit = sq_local_tail_ - load_acquire(sq_head_);
+    if (toSubmit == 0 && minComplete == 0) {
+      return;
+    }
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+      const int res = io_uring_enter(fd_, toSubmit, minComplete, flags);
+      if (res >= 0) {
+        toSubmit -= std::min(static_cast<unsigned>(res), toSubmit);
+        if (toSubmit == 0) {
+          return;
+        }
+      } else if (errno == EAGAIN || errno == EBUSY) {
+        if (reap(onComplete) == 0) {
+          std::this_thread::yield();
+        }
+        // Also flushes the completions that overflowed into the freed space.
+        flags |= IORING_ENTER_GETEVENTS;
+      } else if (errno != EINTR) {
+        throw std::system_error{errno, std::system_category(), "io_uring_enter"};
+      }
+    }
+  }
+
+  // Call `f(cqe)` for all the completions that are available.
+  template <typename F>
+  size_t reap(F&& f) {
+    unsigned head = *cq_head_;
+    const unsigned tail = load_acquire(cq_tail_);
+    for (; head != tail; ++head) {
+      f(cqes_[head & cq_mask_]);
+    }
+    const size_t numReaped = tail - *cq_head_;
+    store_release(cq_head_, head);
+    return numReaped;
+  }
+
+ private:
+  void release() noexcept {
+    if (sqes_) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_size_);
+    }
+    if (sq_ring_) {
+      ::munmap(sq_ring_, sq_size_);
+    }
+    ::close(fd_);
+  }
+
+  void* map(size_t size, off_t offset) {
+    void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                       offset);
+    if (ptr == MAP_FAILED) {
+      throw std::system_error{errno, std::system_category(), "mmap io_uring"};
+    }
+    return ptr;
+  }
+
+  int fd_ = -1;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  size_t sq_size_ = 0;
+  size_t cq_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_array_;
+  unsigned sq_mask_;
+  unsigned sq_entries_;
+  // The tail including the entries that were not yet published to the kernel.
+  unsigned sq_local_tail_ = 0;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+};
+}  // namespace coro_detail
+
+class file_io {
+ public:
+  // Falls back to the `thread_pool` backend (with `numThreads` threads) if io_uring can't be set
+  // up. `entries` is the size of the io_uring submission queue.
+  explicit file_io(file_io_backend preferred = file_io_backend::io_uring, unsigned entries = 256,
+                   size_t numThreads = 4) {
+    if (preferred == file_io_backend::io_uring) {
+      try {
+        ring_ = std::make_unique<coro_detail::io_uring_queues>(entries);
+        return;
+      } catch (const std::system_error&) {
+      }
+    }
+    pool_ = std::make_unique<thread_pool>(numThreads);
+  }
+
+  file_io(const file_io&) = delete;
+  file_io& operator=(const file_io&) = delete;
+
+  // All the requests have to be completed before the destruction.
+  ~file_io() = default;
+
+  file_io_backend backend() const noexcept {
+    return ring_ ? file_io_backend::io_uring : file_io_backend::thread_pool;
+  }
+
+  // The awaiter of `async_read` and `async_write`. Must not be moved after it was awaited.
+  class io_awaiter {
+   public:
+    static constexpr bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    void await_suspend(stackless_coroutine_handle<Promise> h) {
+      waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      io_->submit(*this);
+    }
+
+    // The number of bytes that were transferred.
+    size_t await_resume() const {
+      if (result_ < 0) {
+        throw std::system_error{static_cast<int>(-result_), std::system_category(),
+                                isWrite_ ? "async_write" : "async_read"};
+      }
+      return static_cast<size_t>(result_);
+    }
+
+   private:
+    friend class file_io;
+
+    io_awaiter(file_io& io, bool isWrite, int fd, void* buffer, size_t size, off_t offset)
+        : io_(&io), isWrite_(isWrite), fd_(fd), buffer_(buffer), size_(size), offset_(offset) {}
+
+    // The job that runs the request on the thread pool (`thread_pool` backend only).
+    struct job_frame {
+      HandleFrame frame_{&job_frame::resume, &job_frame::destroy};
+      io_awaiter* owner_;
+
+      static stackless_coroutine_handle<void> resume(void* frame) {
+        auto* self = reinterpret_cast<job_frame*>(frame)->owner_;
+        self->io_->run_blocking(*self);
+        return {};
+      }
+      static void destroy(void*) {}
+    };
+
+    file_io* io_;
+    bool isWrite_;
+    int fd_;
+    void* buffer_;
+    size_t size_;
+    off_t offset_;
+    // The `res` of the completion, a negative errno on failure.
+    int64_t result_ = 0;
+    stackless_coroutine_handle<void> waiter_;
+    job_frame job_{};
+  };
+
+  // Read up to `size` bytes at `offset` of the file `fd` into `buffer`.
+  io_awaiter async_read(int fd, void* buffer, size_t size, off_t offset) noexcept {
+    return io_awaiter{*this, false, fd, buffer, size, offset};
+  }
+
+  // Write up to `size` bytes of `data` at `offset` of the file `fd`.
+  io_awaiter async_write(int fd, const void* data, size_t size, off_t offset) noexcept {
+    return io_awaiter{*this, true, fd, const_cast<void*>(data), size, offset};
+  }
+
+  // Register the `buffers` with the kernel, requests that use (parts of) them are faster. Replaces
+  // an earlier registration, must not be called while requests are in flight. No-op for the
+  // `thread_pool` backend.
+  void register_buffers(std::vector<iovec> buffers) {
+    if (!ring_) {
+      return;
+    }
+    unregister_buffers();
+    if (coro_detail::io_uring_register(ring_->fd(), IORING_REGISTER_BUFFERS, buffers.data(),
+                                       static_cast<unsigned>(buffers.size())) < 0) {
+      throw std::system_error{errno, std::system_category(), "IORING_REGISTER_BUFFERS"};
+    }
+    buffers_ = std::move(buffers);
+  }
+
+  void unregister_buffers() {
+    if (ring_ && !buffers_.empty()) {
+      coro_detail::io_uring_register(ring_->fd(), IORING_UNREGISTER_BUFFERS, nullptr, 0);
+      buffers_.clear();
+    }
+  }
+
+  // The number of requests that have been issued and whose coroutines were not yet resumed.
+  size_t pending() const noexcept { return pending_; }
+
+  // Submit the new requests, then resume the coroutines of all the completed requests as a batch.
+  // If `wait` is true and requests are pending, block until at least one of them has completed.
+  // Returns the number of resumed coroutines.
+  size_t run_once(bool wait = true) {
+    batch_.clear();
+    if (ring_) {
+      // Completions may already have been reaped by a submission.
+      ring_->enter(wait && pending_ > 0 && completed_.empty() ? 1 : 0, on_completion{this});
+      ring_->reap(on_completion{this});
+      batch_.swap(completed_);
+    } else {
+      std::unique_lock lock{completed_mutex_};
+      if (wait && pending_ > 0) {
+        completed_cv_.wait(lock, [this] { return !completed_.empty(); });
+      }
+      batch_.swap(completed_);
+    }
+    pending_ -= batch_.size();
+    for (HandleFrame* h : batch_) {
+      stackless_coroutine_handle<void>{h}.resume();
+    }
+    return batch_.size();
+  }
+
+ private:
+  void submit(io_awaiter& awaiter) {
+    ++pending_;
+    if (!ring_) {
+      awaiter.job_.owner_ = &awaiter;
+      pool_->enqueue(stackless_coroutine_handle<void>{&awaiter.job_.frame_});
+      return;
+    }
+    io_uring_sqe* sqe = ring_->next_sqe();
+    if (!sqe) {
+      // The submission queue is full, hand it over to the kernel.
+      ring_->enter(0, on_completion{this});
+      sqe = ring_->next_sqe();
+    }
+    sqe->fd = awaiter.fd_;
+    sqe->off = static_cast<uint64_t>(awaiter.offset_);
+    sqe->addr = reinterpret_cast<uintptr_t>(awaiter.buffer_);
+    sqe->len = static_cast<uint32_t>(awaiter.size_);
+    sqe->user_data = reinterpret_cast<uintptr_t>(&awaiter);
+    const int bufferIndex = registered_buffer(awaiter.buffer_, awaiter.size_);
+    if (bufferIndex >= 0) {
+      sqe->opcode = awaiter.isWrite_ ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+      sqe->buf_index = static_cast<uint16_t>(bufferIndex);
+    } else {
+      sqe->opcode = awaiter.isWrite_ ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+  }
+
+  // Records the result of a completion of the io_uring backend, its coroutine is resumed by the
+  // next `run_once()`.
+  struct on_completion {
+    file_io* io_;
+
+    void operator()(const io_uring_cqe& cqe) const {
+      auto* awaiter = reinterpret_cast<io_awaiter*>(static_cast<uintptr_t>(cqe.user_data));
+      awaiter->result_ = cqe.res;
+      io_->completed_.push_back(awaiter->waiter_.ptr);
+    }
+  };
+
+  // The index of the registered buffer that contains `[buffer, buffer + size)`, or -1.
+  int registered_buffer(const void* buffer, size_t size) const noexcept {
+    auto* begin = static_cast<const char*>(buffer);
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      auto* base = static_cast<const char*>(buffers_[i].iov_base);
+      if (begin >= base && begin + size <= base + buffers_[i].iov_len) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  // Runs on a thread of the pool (`thread_pool` backend only).
+  void run_blocking(io_awaiter& awaiter) {
+    ssize_t res;
+    do {
+      res = awaiter.isWrite_ ? ::pwrite(awaiter.fd_, awaiter.buffer_, awaiter.size_,
+                                        awaiter.offset_)
+                             : ::pread(awaiter.fd_, awaiter.buffer_, awaiter.size_,
+                                       awaiter.offset_);
+    } while (res < 0 && errno == EINTR);
+    awaiter.result_ = res < 0 ? -errno : res;
+    {
+      std::lock_guard lock{completed_mutex_};
+      completed_.push_back(awaiter.waiter_.ptr);
+    }
+    completed_cv_.notify_one();
+  }
+
+  std::unique_ptr<coro_detail::io_uring_queues> ring_;
+  std::vector<iovec> buffers_;
+
+  // The completed requests whose coroutines were not yet resumed. Only the `thread_pool` backend
+  // needs the mutex and the condition variable.
+  std::mutex completed_mutex_;
+  std::condition_variable completed_cv_;
+  std::vector<HandleFrame*> completed_;
+
+  size_t pending_ = 0;
+  // The coroutines that are resumed by the current `run_once()`.
+  std::vector<HandleFrame*> batch_;
+
+  // Declared last, so that the workers are joined before the completion queue is destroyed.
+  std::unique_ptr<thread_pool> pool_;
+};
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_FILE_IO_H
@@ -0,0 +1,167 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_FILE_IO_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_FILE_IO_EXAMPLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "io/file_io.h"
+#include "task/task.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * Reads the file `fd` sequentially in chunks of `chunkSize` bytes into `buffer`, and returns the
+ * sum of all its bytes. Manually lowered equivalent of:
+ *   task<uint64_t, stackless_coroutine_handle> checksum_file(file_io& io, int fd, char* buffer,
+ *                                                            size_t chunkSize) {
+ *     uint64_t sum = 0;
+ *     off_t offset = 0;
+ *     while (size_t n = co_await io.async_read(fd, buffer, chunkSize, offset)) {
+ *       for (size_t i = 0; i < n; ++i) sum += static_cast<unsigned char>(buffer[i]);
+ *       offset += n;
+ *     }
+ *     co_return sum;
+ *   }
+ */
+inline task<uint64_t, stackless_coroutine_handle> checksum_file(file_io& io, int fd, char* buffer,
+                                                                size_t chunkSize) {
+  using promise_type = task<uint64_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    file_io& io_;
+    int fd_;
+    char* buffer_;
+    size_t chunkSize_;
+    uint64_t sum_ = 0;
+    off_t offset_ = 0;
+    size_t n_ = 0;
+
+    coro_storage<file_io::io_awaiter&, true> read_awaiter_;
+
+    CoroFrame(file_io& io, int fd, char* buffer, size_t chunkSize)
+        : io_(io), fd_(fd), buffer_(buffer), chunkSize_(chunkSize) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (true) {
+        CO_AWAIT(1, read_awaiter_,
+                 this->io_.async_read(this->fd_, this->buffer_, this->chunkSize_, this->offset_),
+                 this->n_ =);
+        if (this->n_ == 0) {
+          break;
+        }
+        {
+          // A local accumulator, as `buffer_` could alias the frame, which prevents vectorization.
+          uint64_t sum = this->sum_;
+          for (size_t i = 0; i < this->n_; ++i) {
+            sum += static_cast<unsigned char>(this->buffer_[i]);
+          }
+          this->sum_ = sum;
+        }
+        this->offset_ += static_cast<off_t>(this->n_);
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->sum_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->read_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    // I/O errors are thrown by `await_resume()`, before the awaiter is destroyed.
+    ExceptionResult dispatchExceptionHandling() {
+      this->read_awaiter_.destroy();
+      return this->unhandled_exception();
+    }
+  };
+  return CoroFrame::ramp(io, fd, buffer, chunkSize);
+}
+
+/**
+ * Writes `size` bytes of `data` to the file `fd`, starting at offset 0, in chunks of at most
+ * `chunkSize` bytes. Returns the number of written bytes. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> write_file(file_io& io, int fd, const char* data,
+ *                                                       size_t size, size_t chunkSize) {
+ *     size_t done = 0;
+ *     while (done < size) {
+ *       done += co_await io.async_write(fd, data + done, std::min(chunkSize, size - done), done);
+ *     }
+ *     co_return done;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> write_file(file_io& io, int fd, const char* data,
+                                                           size_t size, size_t chunkSize) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    file_io& io_;
+    int fd_;
+    const char* data_;
+    size_t size_;
+    size_t chunkSize_;
+    size_t done_ = 0;
+
+    coro_storage<file_io::io_awaiter&, true> write_awaiter_;
+
+    CoroFrame(file_io& io, int fd, const char* data, size_t size, size_t chunkSize)
+        : io_(io), fd_(fd), data_(data), size_(size), chunkSize_(chunkSize) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (this->done_ < this->size_) {
+        CO_AWAIT(1, write_awaiter_,
+                 this->io_.async_write(this->fd_, this->data_ + this->done_,
+                                       std::min(this->chunkSize_, this->size_ - this->done_),
+                                       static_cast<off_t>(this->done_)),
+                 this->done_ +=);
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->done_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->write_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    ExceptionResult dispatchExceptionHandling() {
+      this->write_awaiter_.destroy();
+      return this->unhandled_exception();
+    }
+  };
+  return CoroFrame::ramp(io, fd, data, size, chunkSize);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_FILE_IO_EXAMPLE_H
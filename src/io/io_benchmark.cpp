@@ -0,0 +1,183 @@
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "./event_loop_example.h"
+#include "./file_io_example.h"
+#include "util/timer_wheel.h"
+
+// One round of messages over `numConnections` local sockets, all served by `echo_connection`s on
+// the same loop. The "clients" are the other ends of the sockets, driven by this thread.
+static void BM_EventLoopEcho(benchmark::State& state) {
+  const size_t numConnections = state.range(0);
+  const std::string message(64, 'x');
+  event_loop loop;
+  std::vector<int> clients;
+  std::vector<task<size_t, stackless_coroutine_handle>> servers;
+  for (size_t i = 0; i < numConnections; ++i) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+      state.SkipWithError("socketpair failed");
+      return;
+    }
+    clients.push_back(fds[1]);
+    servers.push_back(echo_connection(loop, fds[0], message.size()));
+    servers.back().start();
+  }
+  std::string reply(message.size(), '\0');
+  for (auto _ : state) {
+    for (int fd : clients) {
+      [[maybe_unused]] auto res = ::write(fd, message.data(), message.size());
+    }
+    // Each server is resumed once per message, and echoes it without suspending again.
+    size_t numResumed = 0;
+    while (numResumed < numConnections) {
+      numResumed += loop.run_once();
+    }
+    for (int fd : clients) {
+      benchmark::DoNotOptimize(::read(fd, reply.data(), reply.size()));
+    }
+  }
+  for (int fd : clients) {
+    ::shutdown(fd, SHUT_WR);
+  }
+  while (!servers.back().done()) {
+    loop.run_once();
+  }
+  servers.clear();
+  for (int fd : clients) {
+    ::close(fd);
+  }
+  state.SetItemsProcessed(state.iterations() * numConnections);
+}
+
+// Coroutines that are scheduled from outside of the loop, which go through the mutex-protected
+// queue and a single eventfd wakeup per batch.
+static void BM_EventLoopSchedule(benchmark::State& state) {
+  const size_t numTasks = state.range(0);
+  event_loop loop;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  tasks.reserve(numTasks);
+  for (auto _ : state) {
+    tasks.clear();
+    for (size_t i = 0; i < numTasks; ++i) {
+      tasks.push_back(loop_compute_value(loop, i));
+      tasks.back().start();
+    }
+    size_t numResumed = 0;
+    while (numResumed < numTasks) {
+      numResumed += loop.run_once();
+    }
+    benchmark::DoNotOptimize(tasks.back().result());
+  }
+  state.SetItemsProcessed(state.iterations() * numTasks);
+}
+
+// A 4 MiB unlinked temporary file.
+static int makeTestFile() {
+  char name[] = "/tmp/io_benchmark_XXXXXX";
+  int fd = ::mkstemp(name);
+  ::unlink(name);
+  std::string chunk(1 << 20, 'x');
+  for (int i = 0; i < 4; ++i) {
+    [[maybe_unused]] auto res = ::write(fd, chunk.data(), chunk.size());
+  }
+  return fd;
+}
+
+// Sequential reads of the (cached) file in chunks of `state.range(0)` bytes. The third template
+// argument registers the buffer with io_uring.
+template <file_io_backend backend, bool registerBuffer>
+static void BM_FileRead(benchmark::State& state) {
+  const size_t chunkSize = state.range(0);
+  const int fd = makeTestFile();
+  file_io io{backend};
+  std::vector<char> buffer(chunkSize);
+  if (registerBuffer) {
+    io.register_buffers({iovec{buffer.data(), buffer.size()}});
+  }
+  for (auto _ : state) {
+    auto t = checksum_file(io, fd, buffer.data(), chunkSize);
+    t.start();
+    while (!t.done()) {
+      io.run_once();
+    }
+    benchmark::DoNotOptimize(t.result());
+  }
+  ::close(fd);
+  state.SetBytesProcessed(state.iterations() * (4 << 20));
+}
+
+// The baseline: blocking `pread` calls.
+static void BM_FileReadBlocking(benchmark::State& state) {
+  const size_t chunkSize = state.range(0);
+  const int fd = makeTestFile();
+  std::vector<char> buffer(chunkSize);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    off_t offset = 0;
+    while (ssize_t n = ::pread(fd, buffer.data(), chunkSize, offset)) {
+      for (ssize_t i = 0; i < n; ++i) {
+        sum += static_cast<unsigned char>(buffer[i]);
+      }
+      offset += n;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  ::close(fd);
+  state.SetBytesProcessed(state.iterations() * (4 << 20));
+}
+
+// A timer that expires without resuming anything.
+struct bench_timer : coro_detail::timer_node {
+  bench_timer() : timer_node([](timer_node&) { return stackless_coroutine_handle<void>{}; }) {}
+};
+
+// Arming and disarming `state.range(0)` timeouts that never fire, e.g. for requests that finish
+// before their deadline.
+static void BM_TimerWheelInsertCancel(benchmark::State& state) {
+  coro_detail::timer_wheel wheel;
+  std::vector<bench_timer> timers(state.range(0));
+  for (auto _ : state) {
+    uint64_t delay = 1;
+    for (auto& t : timers) {
+      wheel.insert(t, wheel.now() + delay);
+      delay = delay * 7 % 100003;
+    }
+    for (auto& t : timers) {
+      wheel.cancel(t);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Arming `state.range(0)` timers spread over 1000 ticks, and advancing until all have expired.
+static void BM_TimerWheelExpire(benchmark::State& state) {
+  coro_detail::timer_wheel wheel;
+  std::vector<bench_timer> timers(state.range(0));
+  std::vector<HandleFrame*> ready;
+  for (auto _ : state) {
+    uint64_t delay = 1;
+    for (auto& t : timers) {
+      wheel.insert(t, wheel.now() + delay);
+      delay = delay * 7 % 1000 + 1;
+    }
+    wheel.advance(wheel.now() + 1001, ready);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_EventLoopEcho)->Arg(1)->Arg(1000);
+BENCHMARK(BM_EventLoopSchedule)->Arg(1)->Arg(1000);
+BENCHMARK(BM_TimerWheelInsertCancel)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_TimerWheelExpire)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_FileReadBlocking)->Arg(4096)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_FileRead, file_io_backend::io_uring, false)->Arg(4096)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_FileRead, file_io_backend::io_uring, true)->Arg(4096)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_FileRead, file_io_backend::thread_pool, false)->Arg(4096)->Arg(65536);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,640 @@
+// Unit tests for the event loop and the I/O awaitables.
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "io/event_loop_example.h"
+#include "io/file_io_example.h"
+#include "task/task_example.h"
+#include "task/when_all_example.h"
+#include "util/timer_wheel.h"
+
+namespace {
+// A pair of connected, non-blocking local sockets that are closed on destruction.
+struct socket_pair {
+  int fds_[2];
+
+  socket_pair() {
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds_) < 0) {
+      throw std::system_error{errno, std::system_category(), "socketpair"};
+    }
+  }
+  socket_pair(const socket_pair&) = delete;
+  ~socket_pair() {
+    ::close(fds_[0]);
+    ::close(fds_[1]);
+  }
+};
+
+// Blocking read of `size` bytes from a non-blocking fd, for the test thread.
+std::string readBlocking(int fd, size_t size) {
+  std::string result(size, '\0');
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::read(fd, result.data() + done, size - done);
+    if (n > 0) {
+      done += static_cast<size_t>(n);
+    } else if (n == 0) {
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  result.resize(done);
+  return result;
+}
+
+// An unlinked temporary file that is closed on destruction.
+struct temp_file {
+  int fd_;
+
+  temp_file() {
+    char name[] = "/tmp/io_test_XXXXXX";
+    fd_ = ::mkstemp(name);
+    if (fd_ < 0) {
+      throw std::system_error{errno, std::system_category(), "mkstemp"};
+    }
+    ::unlink(name);
+  }
+  temp_file(const temp_file&) = delete;
+  ~temp_file() { ::close(fd_); }
+};
+
+std::string testContent(size_t size) {
+  std::string content(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    content[i] = static_cast<char>((i * 7 + i / 251) & 0xff);
+  }
+  return content;
+}
+
+uint64_t byteSum(const std::string& s) {
+  uint64_t sum = 0;
+  for (char c : s) {
+    sum += static_cast<unsigned char>(c);
+  }
+  return sum;
+}
+
+// A timer that records the tick at which it expired.
+struct test_timer : coro_detail::timer_node {
+  uint64_t expiredAt_ = 0;
+  coro_detail::timer_wheel* wheel_ = nullptr;
+
+  test_timer() : timer_node(&test_timer::expire) {}
+
+  static stackless_coroutine_handle<void> expire(timer_node& node) {
+    auto& self = static_cast<test_timer&>(node);
+    self.expiredAt_ = self.wheel_->now();
+    return {};
+  }
+};
+
+// Resumed by the loop (after `enqueue(frame_.handle())`), destroys `victim_` once `when_()` returns
+// true, and otherwise enqueues itself again.
+struct destroy_in_batch {
+  event_loop& loop_;
+  std::function<bool()> when_;
+  std::optional<task<size_t, stackless_coroutine_handle>> victim_;
+  size_t numResumed_ = 0;
+  detail::completion_frame<destroy_in_batch> frame_;
+
+  destroy_in_batch(event_loop& loop, std::function<bool()> when) : loop_(loop), when_(when) {
+    frame_.owner_ = this;
+  }
+
+  stackless_coroutine_handle<void> on_child_done(size_t) noexcept {
+    ++numResumed_;
+    if (when_()) {
+      victim_.reset();
+    } else {
+      loop_.enqueue(frame_.handle());
+    }
+    return {};
+  }
+};
+
+constexpr file_io_backend allBackends[] = {file_io_backend::io_uring, file_io_backend::thread_pool};
+}  // namespace
+
+// ============================================================================
+// EventLoopTest - fd readiness and scheduling on the epoll loop
+// ============================================================================
+
+TEST(EventLoopTest, ReadResumesWhenDataArrives) {
+  int fds[2];
+  ASSERT_EQ(::pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+  {
+    event_loop loop;
+    fd_watch watch{loop, fds[0]};
+    char buffer[5];
+    auto t = read_exactly(watch, buffer, 5);
+    t.start();
+    EXPECT_FALSE(t.done());
+    loop.run_once(0);
+    EXPECT_FALSE(t.done());
+
+    ASSERT_EQ(::write(fds[1], "abc", 3), 3);
+    loop.run_once(1000);
+    EXPECT_FALSE(t.done());
+    ASSERT_EQ(::write(fds[1], "de", 2), 2);
+    while (!t.done()) {
+      loop.run_once(1000);
+    }
+    EXPECT_EQ(t.result(), 5u);
+    EXPECT_EQ(std::string(buffer, 5), "abcde");
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST(EventLoopTest, EndOfFileStopsTheRead) {
+  int fds[2];
+  ASSERT_EQ(::pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+  event_loop loop;
+  fd_watch watch{loop, fds[0]};
+  char buffer[8];
+  auto t = read_exactly(watch, buffer, 8);
+  t.start();
+  ASSERT_EQ(::write(fds[1], "xy", 2), 2);
+  ::close(fds[1]);
+  while (!t.done()) {
+    loop.run_once(1000);
+  }
+  EXPECT_EQ(t.result(), 2u);
+  ::close(fds[0]);
+}
+
+// The reader is collected for the same batch as the `destroyer`, which is resumed first and
+// destroys it.
+TEST(EventLoopTest, WaiterThatIsDestroyedInTheBatchIsNotResumed) {
+  int fds[2];
+  ASSERT_EQ(::pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+  {
+    event_loop loop;
+    fd_watch watch{loop, fds[0]};
+    bool written = false;
+    destroy_in_batch destroyer{loop, [&] {
+                                 if (!written) {
+                                   written = ::write(fds[1], "x", 1) == 1;
+                                   return false;
+                                 }
+                                 return true;
+                               }};
+    char buffer[1];
+    destroyer.victim_.emplace(read_exactly(watch, buffer, 1));
+    destroyer.victim_->start();
+    loop.enqueue(destroyer.frame_.handle());
+    EXPECT_EQ(loop.run_once(1000), 1u);
+    ASSERT_TRUE(written);
+    EXPECT_EQ(loop.run_once(1000), 1u);
+    EXPECT_FALSE(destroyer.victim_.has_value());
+    EXPECT_EQ(loop.run_once(0), 0u);
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST(EventLoopTest, EventfdWrittenByAnotherThread) {
+  int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  ASSERT_GE(efd, 0);
+  {
+    event_loop loop;
+    fd_watch watch{loop, efd};
+    uint64_t value = 0;
+    auto t = read_exactly(watch, reinterpret_cast<char*>(&value), sizeof(value));
+    t.start();
+    std::thread writer{[efd] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      uint64_t increment = 42;
+      [[maybe_unused]] auto res = ::write(efd, &increment, sizeof(increment));
+    }};
+    while (!t.done()) {
+      loop.run_once();
+    }
+    writer.join();
+    EXPECT_EQ(t.result(), sizeof(value));
+    EXPECT_EQ(value, 42u);
+  }
+  ::close(efd);
+}
+
+TEST(EventLoopTest, ScheduleFromOtherThreads) {
+  event_loop loop;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 100; ++i) {
+    tasks.push_back(loop_compute_value(loop, i));
+  }
+  // The tasks run until `co_await loop.schedule()` on the other threads, the rest on this one.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&tasks, t] {
+      for (size_t i = t; i < tasks.size(); i += 4) {
+        tasks[i].start();
+      }
+    });
+  }
+  size_t numResumed = 0;
+  while (numResumed < tasks.size()) {
+    numResumed += loop.run_once();
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    EXPECT_EQ(tasks[i].result(), 2 * i);
+  }
+}
+
+TEST(EventLoopTest, StopFromAnotherThread) {
+  event_loop loop;
+  std::thread stopper{[&loop] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    loop.stop();
+  }};
+  loop.run();
+  stopper.join();
+  EXPECT_FALSE(loop.on_loop_thread());
+}
+
+TEST(EventLoopTest, OneThreadServesManyConnections) {
+  constexpr size_t numConnections = 500;
+  constexpr size_t numMessages = 3;
+  const std::string message = "ping-pong";
+  event_loop loop;
+  std::vector<std::unique_ptr<socket_pair>> sockets;
+  std::vector<task<size_t, stackless_coroutine_handle>> servers;
+  for (size_t i = 0; i < numConnections; ++i) {
+    sockets.push_back(std::make_unique<socket_pair>());
+    servers.push_back(echo_connection(loop, sockets.back()->fds_[0], message.size()));
+    servers.back().start();
+  }
+  std::thread client{[&] {
+    for (size_t m = 0; m < numMessages; ++m) {
+      for (auto& s : sockets) {
+        ASSERT_EQ(::write(s->fds_[1], message.data(), message.size()),
+                  static_cast<ssize_t>(message.size()));
+      }
+      for (auto& s : sockets) {
+        ASSERT_EQ(readBlocking(s->fds_[1], message.size()), message);
+      }
+    }
+    for (auto& s : sockets) {
+      ::shutdown(s->fds_[1], SHUT_WR);
+    }
+  }};
+  size_t numDone = 0;
+  while (numDone < numConnections) {
+    loop.run_once(1000);
+    numDone = 0;
+    for (auto& server : servers) {
+      numDone += server.done();
+    }
+  }
+  client.join();
+  for (auto& server : servers) {
+    EXPECT_EQ(server.result(), numMessages);
+  }
+}
+
+// ============================================================================
+// TimerWheelTest - the hierarchical timing wheel behind the loop's timers
+// ============================================================================
+
+TEST(TimerWheelTest, TimersExpireExactlyAtTheirTick) {
+  coro_detail::timer_wheel wheel;
+  std::vector<HandleFrame*> ready;
+  // Expiries on all the levels and in the overflow list.
+  const uint64_t expiries[] = {1, 2, 63, 64, 65, 4095, 4096, 4097, 300000, 1u << 24, (1u << 24) + 5,
+                               (1ull << 30) + 12345};
+  std::vector<test_timer> timers(std::size(expiries));
+  for (size_t i = 0; i < timers.size(); ++i) {
+    timers[i].wheel_ = &wheel;
+    wheel.insert(timers[i], expiries[i]);
+  }
+  EXPECT_EQ(wheel.size(), timers.size());
+  EXPECT_EQ(wheel.next_expiry(), 1u);
+  wheel.advance(1ull << 31, ready);
+  EXPECT_EQ(wheel.size(), 0u);
+  EXPECT_EQ(wheel.next_expiry(), coro_detail::timer_wheel::no_expiry);
+  for (size_t i = 0; i < timers.size(); ++i) {
+    EXPECT_FALSE(timers[i].armed());
+    EXPECT_EQ(timers[i].expiredAt_, expiries[i]) << i;
+  }
+  EXPECT_TRUE(ready.empty());
+}
+
+TEST(TimerWheelTest, RandomInsertCancelAdvanceMatchesBruteForce) {
+  std::mt19937_64 rng{42};
+  coro_detail::timer_wheel wheel{1000};
+  std::vector<HandleFrame*> ready;
+  std::vector<test_timer> timers(2000);
+  for (auto& t : timers) {
+    t.wheel_ = &wheel;
+  }
+  std::vector<uint64_t> expected(timers.size(), 0);
+  for (size_t round = 0; round < 200; ++round) {
+    for (size_t i = 0; i < timers.size(); ++i) {
+      auto& t = timers[i];
+      switch (rng() % 8) {
+        case 0:
+          if (!t.armed()) {
+            // Mostly short timeouts, some far beyond the range of the wheel.
+            const uint64_t delay = rng() % 16 == 0 ? rng() % (1ull << 26) : rng() % 5000;
+            wheel.insert(t, wheel.now() + 1 + delay);
+            expected[i] = t.expiry_;
+          }
+          break;
+        case 1:
+          wheel.cancel(t);
+          expected[i] = 0;
+          break;
+      }
+    }
+    // The lower bound never skips an expiry.
+    uint64_t earliest = coro_detail::timer_wheel::no_expiry;
+    for (uint64_t e : expected) {
+      if (e != 0) {
+        earliest = std::min(earliest, e);
+      }
+    }
+    ASSERT_LE(wheel.next_expiry(), earliest);
+
+    const uint64_t target = wheel.now() + (round % 50 == 0 ? (1ull << 25) : rng() % 3000);
+    wheel.advance(target, ready);
+    for (size_t i = 0; i < timers.size(); ++i) {
+      if (expected[i] != 0 && expected[i] <= target) {
+        ASSERT_FALSE(timers[i].armed());
+        ASSERT_EQ(timers[i].expiredAt_, expected[i]);
+        expected[i] = 0;
+      } else {
+        ASSERT_EQ(timers[i].armed(), expected[i] != 0);
+      }
+    }
+  }
+}
+
+TEST(TimerWheelTest, PastExpiriesExpireAtTheNextTick) {
+  coro_detail::timer_wheel wheel{100};
+  std::vector<HandleFrame*> ready;
+  test_timer t;
+  t.wheel_ = &wheel;
+  wheel.insert(t, 50);
+  EXPECT_EQ(t.expiry_, 101u);
+  wheel.advance(101, ready);
+  EXPECT_EQ(t.expiredAt_, 101u);
+}
+
+// ============================================================================
+// EventLoopTimerTest - sleep_for and with_deadline on the epoll loop
+// ============================================================================
+
+TEST(EventLoopTimerTest, SleepForWaitsAtLeastTheDuration) {
+  using namespace std::chrono_literals;
+  event_loop loop;
+  const auto start = std::chrono::steady_clock::now();
+  auto t = sleepy_compute_value(loop, 21, 20ms);
+  t.start();
+  EXPECT_FALSE(t.done());
+  EXPECT_EQ(loop.num_timers(), 1u);
+  while (!t.done()) {
+    loop.run_once();
+  }
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+  EXPECT_EQ(t.result(), 42u);
+  EXPECT_EQ(loop.num_timers(), 0u);
+}
+
+TEST(EventLoopTimerTest, ZeroSleepDoesNotSuspend) {
+  event_loop loop;
+  auto t = sleepy_compute_value(loop, 1, std::chrono::milliseconds{0});
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_EQ(t.result(), 2u);
+}
+
+TEST(EventLoopTimerTest, ManySleepersAreResumedInBulk) {
+  event_loop loop;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 1000; ++i) {
+    tasks.push_back(sleepy_compute_value(loop, i, std::chrono::milliseconds{1 + i % 5}));
+    tasks.back().start();
+  }
+  EXPECT_EQ(loop.num_timers(), tasks.size());
+  size_t numResumed = 0;
+  while (numResumed < tasks.size()) {
+    numResumed += loop.run_once();
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    EXPECT_EQ(tasks[i].result(), 2 * i);
+  }
+}
+
+TEST(EventLoopTimerTest, DestroyingASleeperDisarmsTheTimer) {
+  event_loop loop;
+  {
+    auto t = sleepy_compute_value(loop, 1, std::chrono::hours{1});
+    t.start();
+    EXPECT_EQ(loop.num_timers(), 1u);
+  }
+  EXPECT_EQ(loop.num_timers(), 0u);
+}
+
+// The sleeper expires in the iteration in which the `destroyer` sees no armed timer, and is
+// destroyed before it is resumed.
+TEST(EventLoopTimerTest, SleeperThatIsDestroyedInTheBatchIsNotResumed) {
+  event_loop loop;
+  destroy_in_batch destroyer{loop, [&] { return loop.num_timers() == 0; }};
+  destroyer.victim_.emplace(sleepy_compute_value(loop, 1, std::chrono::milliseconds{2}));
+  destroyer.victim_->start();
+  loop.enqueue(destroyer.frame_.handle());
+  size_t numResumed = 0;
+  while (destroyer.victim_) {
+    numResumed += loop.run_once();
+  }
+  EXPECT_EQ(numResumed, destroyer.numResumed_);
+}
+
+TEST(EventLoopTimerTest, DeadlineReturnsTheResultOfAFastTask) {
+  using namespace std::chrono_literals;
+  event_loop loop;
+  auto t = await_result(loop.with_deadline(sleepy_compute_value(loop, 5, 1ms), 1h));
+  t.start();
+  while (!t.done()) {
+    loop.run_once();
+  }
+  EXPECT_EQ(t.result(), std::optional<size_t>{10});
+  EXPECT_EQ(loop.num_timers(), 0u);
+}
+
+TEST(EventLoopTimerTest, DeadlineOfASynchronousTask) {
+  event_loop loop;
+  auto t = await_result(loop.with_deadline(compute_value(5), std::chrono::hours{1}));
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_EQ(t.result(), std::optional<size_t>{10});
+  EXPECT_EQ(loop.num_timers(), 0u);
+}
+
+TEST(EventLoopTimerTest, DeadlineExpiresAndDetachesTheTask) {
+  using namespace std::chrono_literals;
+  int fds[2];
+  ASSERT_EQ(::pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+  {
+    event_loop loop;
+    fd_watch watch{loop, fds[0]};
+    char buffer[4];
+    auto t = await_result(loop.with_deadline(read_exactly(watch, buffer, 4), 10ms));
+    t.start();
+    while (!t.done()) {
+      loop.run_once();
+    }
+    EXPECT_EQ(t.result(), std::nullopt);
+    EXPECT_EQ(loop.num_timers(), 0u);
+    // The detached read is still waiting, and finishes (and frees itself) once the data arrives.
+    ASSERT_EQ(::write(fds[1], "abcd", 4), 4);
+    loop.run_once(1000);
+    EXPECT_EQ(std::string(buffer, 4), "abcd");
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+// ============================================================================
+// FileIoTest - io_uring and thread-pool backed file reads and writes
+// ============================================================================
+
+TEST(FileIoTest, WriteThenReadBack) {
+  for (auto backend : allBackends) {
+    file_io io{backend};
+    if (backend == file_io_backend::thread_pool) {
+      EXPECT_EQ(io.backend(), file_io_backend::thread_pool);
+    }
+    temp_file file;
+    const std::string content = testContent(100000);
+    auto writer = write_file(io, file.fd_, content.data(), content.size(), 4096);
+    writer.start();
+    while (!writer.done()) {
+      io.run_once();
+    }
+    EXPECT_EQ(writer.result(), content.size());
+
+    std::string buffer(4096, '\0');
+    auto reader = checksum_file(io, file.fd_, buffer.data(), buffer.size());
+    reader.start();
+    while (!reader.done()) {
+      io.run_once();
+    }
+    EXPECT_EQ(reader.result(), byteSum(content));
+    EXPECT_EQ(io.pending(), 0u);
+  }
+}
+
+TEST(FileIoTest, ConcurrentRequestsAreSubmittedAsABatch) {
+  constexpr size_t numChunks = 64;
+  constexpr size_t chunkSize = 512;
+  for (auto backend : allBackends) {
+    file_io io{backend};
+    temp_file file;
+    const std::string content = testContent(numChunks * chunkSize);
+    ASSERT_EQ(::pwrite(file.fd_, content.data(), content.size(), 0),
+              static_cast<ssize_t>(content.size()));
+    std::string buffer(content.size(), '\0');
+    std::vector<task<size_t, stackless_coroutine_handle>> reads;
+    for (size_t i = 0; i < numChunks; ++i) {
+      reads.push_back(await_result(
+          io.async_read(file.fd_, buffer.data() + i * chunkSize, chunkSize, i * chunkSize)));
+      reads.back().start();
+    }
+    EXPECT_EQ(io.pending(), numChunks);
+    size_t numResumed = 0;
+    while (io.pending() > 0) {
+      numResumed += io.run_once();
+    }
+    EXPECT_EQ(numResumed, numChunks);
+    for (auto& r : reads) {
+      ASSERT_TRUE(r.done());
+      EXPECT_EQ(r.result(), chunkSize);
+    }
+    EXPECT_EQ(buffer, content);
+  }
+}
+
+// With a ring of 2 entries, the requests are submitted while they are issued (the submission queue
+// is full), and the completions overflow the completion queue before `run_once()` reaps them.
+TEST(FileIoTest, ManyRequestsOnATinyRing) {
+  constexpr size_t numChunks = 256;
+  constexpr size_t chunkSize = 64;
+  file_io io{file_io_backend::io_uring, 2};
+  temp_file file;
+  const std::string content = testContent(numChunks * chunkSize);
+  ASSERT_EQ(::pwrite(file.fd_, content.data(), content.size(), 0),
+            static_cast<ssize_t>(content.size()));
+  std::string buffer(content.size(), '\0');
+  std::vector<task<size_t, stackless_coroutine_handle>> reads;
+  for (size_t i = 0; i < numChunks; ++i) {
+    reads.push_back(await_result(
+        io.async_read(file.fd_, buffer.data() + i * chunkSize, chunkSize, i * chunkSize)));
+    reads.back().start();
+  }
+  size_t numResumed = 0;
+  while (io.pending() > 0) {
+    numResumed += io.run_once();
+  }
+  EXPECT_EQ(numResumed, numChunks);
+  EXPECT_EQ(buffer, content);
+}
+
+TEST(FileIoTest, RegisteredBuffersAreUsedTransparently) {
+  for (auto backend : allBackends) {
+    file_io io{backend};
+    temp_file file;
+    const std::string content = testContent(8192);
+    ASSERT_EQ(::pwrite(file.fd_, content.data(), content.size(), 0),
+              static_cast<ssize_t>(content.size()));
+    std::vector<char> registered(16384);
+    io.register_buffers({iovec{registered.data(), registered.size()}});
+    // The second half of the registered buffer.
+    auto t = checksum_file(io, file.fd_, registered.data() + 8192, 8192);
+    t.start();
+    while (!t.done()) {
+      io.run_once();
+    }
+    EXPECT_EQ(t.result(), byteSum(content));
+    io.unregister_buffers();
+  }
+}
+
+TEST(FileIoTest, ErrorsAreThrownByTheAwait) {
+  for (auto backend : allBackends) {
+    file_io io{backend};
+    char buffer[16];
+    auto t = await_result(io.async_read(-1, buffer, sizeof(buffer), 0));
+    t.start();
+    while (!t.done()) {
+      io.run_once();
+    }
+    try {
+      t.result();
+      FAIL() << "expected an exception";
+    } catch (const std::system_error& e) {
+      EXPECT_EQ(e.code().value(), EBADF);
+    }
+  }
+}
@@ -0,0 +1,325 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_CHANNEL_H
+#define GENERATOR_REWRITE_EXAMPLES_CHANNEL_H
+
+// A bounded multi-producer multi-consumer channel between coroutines:
+//   if (!co_await channel.send(value)) { /* the channel was closed */ }
+//   while (std::optional<T> value = co_await channel.recv()) { ... }
+//   channel.close();
+//
+// The values are buffered in a lock-free ring (see `util/mpmc_ring.h`). A `send` to a full channel
+// suspends the producer (backpressure) until a consumer makes room, a `recv` from an empty channel
+// suspends the consumer until a value arrives. As long as neither happens, sending and receiving is
+// lock-free: the ring operation, a fence, and a read of the number of suspended waiters on the
+// other side, which is usually 0.
+//
+// The suspended waiters are intrusive nodes in their awaiters (as for the primitives of
+// `task/sync_primitives.h`), so waiting doesn't allocate. The lists of waiters are protected by a
+// mutex. Whoever changes the ring while there are waiters on the other side (or starts waiting)
+// matches the waiters with the values / free slots under that mutex: a waiting consumer gets its
+// value moved directly into its awaiter, a waiting producer gets its value moved into the ring.
+// The matched waiters are then resumed on that thread (via `coro_detail::resume_waiter`).
+//
+// `close()` wakes all the waiters: suspended producers fail, consumers get the remaining values
+// and then an empty optional. Later sends fail, later receives drain the remaining values. Sends
+// that race with `close()` may still succeed. The channel must outlive all its waiters.
+//
+// `recv_blocking()` parks the calling thread (see `util/parker.h`) instead of suspending, for
+// consumers that are not coroutines (e.g. `channel_generator` in `generator/channel_generator.h`).
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "task/sync_primitives.h"
+#include "util/coroutine_handle.h"
+#include "util/mpmc_ring.h"
+#include "util/parker.h"
+
+template <typename T>
+class async_channel {
+ public:
+  // The `capacity` is rounded up to a power of two (at least 2).
+  explicit async_channel(size_t capacity) : ring_(capacity) {}
+
+  async_channel(const async_channel&) = delete;
+  async_channel& operator=(const async_channel&) = delete;
+
+  size_t capacity() const noexcept { return ring_.capacity(); }
+
+  // Awaiter for `co_await channel.send(value)`, returns false if the channel is closed (then the
+  // value is discarded).
+  class send_awaiter : coro_detail::sync_waiter {
+   public:
+    send_awaiter(async_channel& channel, T&& value)
+        : channel_(&channel), value_(std::move(value)) {}
+
+    bool await_ready() {
+      if (channel_->closed()) {
+        return true;
+      }
+      sent_ = channel_->try_send(std::move(value_));
+      return sent_;
+    }
+
+    // Returns false (don't suspend) if the value could be sent in the meantime, or the channel was
+    // closed.
+    template <typename Promise>
+    bool await_suspend(stackless_coroutine_handle<Promise> h) {
+      waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      return channel_->wait(*this);
+    }
+
+    bool await_resume() const noexcept { return sent_; }
+
+   private:
+    friend class async_channel;
+    async_channel* channel_;
+    T value_;
+    bool sent_ = false;
+  };
+
+  // Awaiter for `co_await channel.recv()`, returns an empty optional if the channel is closed and
+  // there are no more values.
+  class recv_awaiter : coro_detail::sync_waiter {
+   public:
+    explicit recv_awaiter(async_channel& channel) noexcept : channel_(&channel) {}
+
+    bool await_ready() {
+      value_ = channel_->try_recv();
+      if (value_ || !channel_->closed()) {
+        return value_.has_value();
+      }
+      // The last values might have been sent right before the channel was closed.
+      value_ = channel_->try_recv();
+      return true;
+    }
+
+    // Returns false (don't suspend) if a value arrived in the meantime, or the channel was closed.
+    template <typename Promise>
+    bool await_suspend(stackless_coroutine_handle<Promise> h) {
+      waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      return channel_->wait(*this);
+    }
+
+    std::optional<T> await_resume() noexcept(std::is_nothrow_move_constructible_v<T>) {
+      return std::move(value_);
+    }
+
+   private:
+    friend class async_channel;
+    async_channel* channel_;
+    std::optional<T> value_;
+  };
+
+  send_awaiter send(T value) { return send_awaiter{*this, std::move(value)}; }
+
+  recv_awaiter recv() noexcept { return recv_awaiter{*this}; }
+
+  // Send without waiting. Returns false (and leaves `value` untouched) if the channel is full or
+  // closed.
+  template <typename U>
+  bool try_send(U&& value) {
+    if (closed() || !ring_.try_emplace(std::forward<U>(value))) {
+      return false;
+    }
+    // Pairs with the fence in `wait`: either the consumer sees the new value, or we see it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numRecvWaiters_.load(std::memory_order_relaxed) > 0) {
+      match_and_resume(nullptr);
+    }
+    return true;
+  }
+
+  // Receive without waiting. Returns an empty optional if the channel is empty.
+  std::optional<T> try_recv() {
+    std::optional<T> result;
+    if (ring_.try_pop([&result](T&& value) { result.emplace(std::move(value)); })) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      // Waiting producers are only matched once the ring is half empty, so that a producer that
+      // keeps the channel full sends half a ring of values per suspension, instead of one. A
+      // consumer that finds the ring empty always matches them (in `wait`).
+      if (numSendWaiters_.load(std::memory_order_relaxed) > 0 &&
+          ring_.size_approx() <= ring_.capacity() / 2) {
+        match_and_resume(nullptr);
+      }
+    }
+    return result;
+  }
+
+  // Block the calling thread until a value arrives, or the channel is closed and empty.
+  std::optional<T> recv_blocking() {
+    recv_awaiter awaiter{*this};
+    if (!awaiter.await_ready()) {
+      blocking_waiter waiter;
+      if (awaiter.await_suspend(stackless_coroutine_handle<void>{&waiter.frame_})) {
+        waiter.wait();
+      }
+    }
+    return awaiter.await_resume();
+  }
+
+  void close() {
+    coro_detail::sync_waiter* woken = nullptr;
+    {
+      std::lock_guard lock{mutex_};
+      closed_.store(true, std::memory_order_release);
+      woken = match();
+      while (coro_detail::sync_waiter* s = sendWaiters_.pop()) {
+        woken = push_front(woken, *s);
+      }
+      while (coro_detail::sync_waiter* r = recvWaiters_.pop()) {
+        woken = push_front(woken, *r);
+      }
+      numSendWaiters_.store(0, std::memory_order_relaxed);
+      numRecvWaiters_.store(0, std::memory_order_relaxed);
+    }
+    resume_all(woken, nullptr);
+  }
+
+  bool closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+ private:
+  // A FIFO list of waiters, linked through `sync_waiter::next_`.
+  struct waiter_list {
+    coro_detail::sync_waiter* head_ = nullptr;
+    coro_detail::sync_waiter* tail_ = nullptr;
+
+    void push(coro_detail::sync_waiter& node) noexcept {
+      node.next_ = nullptr;
+      (tail_ ? tail_->next_ : head_) = &node;
+      tail_ = &node;
+    }
+
+    coro_detail::sync_waiter* pop() noexcept {
+      coro_detail::sync_waiter* head = head_;
+      if (head) {
+        head_ = head->next_;
+        if (!head_) {
+          tail_ = nullptr;
+        }
+      }
+      return head;
+    }
+  };
+
+  // Unparks a thread that is blocked in `recv_blocking`.
+  struct blocking_waiter {
+    HandleFrame frame_{&blocking_waiter::resume, &blocking_waiter::destroy};
+    coro_detail::parker parker_;
+
+    void wait() noexcept { parker_.park(); }
+
+    static stackless_coroutine_handle<void> resume(void* frame) {
+      reinterpret_cast<blocking_waiter*>(frame)->parker_.unpark();
+      return {};
+    }
+
+    static void destroy(void*) {}
+  };
+
+  static coro_detail::sync_waiter* push_front(coro_detail::sync_waiter* list,
+                                              coro_detail::sync_waiter& node) noexcept {
+    node.next_ = list;
+    return &node;
+  }
+
+  // Register the `awaiter` as a waiter, and match the waiters with the ring. Returns false if the
+  // awaiter was matched right away (or the channel is closed), then it must not suspend.
+  template <typename Awaiter>
+  bool wait(Awaiter& awaiter) {
+    coro_detail::sync_waiter* woken = nullptr;
+    {
+      std::lock_guard lock{mutex_};
+      if (closed()) {
+        if constexpr (std::is_same_v<Awaiter, recv_awaiter>) {
+          awaiter.value_ = pop_value();
+        }
+        return false;
+      }
+      if constexpr (std::is_same_v<Awaiter, send_awaiter>) {
+        sendWaiters_.push(awaiter);
+        numSendWaiters_.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        recvWaiters_.push(awaiter);
+        numRecvWaiters_.fetch_add(1, std::memory_order_relaxed);
+      }
+      // Pairs with the fences in `try_send` and `try_recv`.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      woken = match();
+    }
+    return !resume_all(woken, &awaiter);
+  }
+
+  // Move values from the ring to waiting consumers, and values of waiting producers to the ring,
+  // as long as possible. Returns the list of the matched waiters. Requires `mutex_`.
+  coro_detail::sync_waiter* match() {
+    coro_detail::sync_waiter* woken = nullptr;
+    bool progress = true;
+    while (progress) {
+      progress = false;
+      if (recvWaiters_.head_) {
+        if (std::optional<T> value = pop_value()) {
+          auto* r = static_cast<recv_awaiter*>(recvWaiters_.pop());
+          numRecvWaiters_.fetch_sub(1, std::memory_order_relaxed);
+          r->value_ = std::move(value);
+          woken = push_front(woken, *r);
+          progress = true;
+        }
+      }
+      if (sendWaiters_.head_ &&
+          ring_.try_emplace(std::move(static_cast<send_awaiter*>(sendWaiters_.head_)->value_))) {
+        auto* s = static_cast<send_awaiter*>(sendWaiters_.pop());
+        numSendWaiters_.fetch_sub(1, std::memory_order_relaxed);
+        s->sent_ = true;
+        woken = push_front(woken, *s);
+        progress = true;
+      }
+    }
+    return woken;
+  }
+
+  std::optional<T> pop_value() {
+    std::optional<T> result;
+    ring_.try_pop([&result](T&& value) { result.emplace(std::move(value)); });
+    return result;
+  }
+
+  // Match the waiters with the ring, after a change of the ring that they might wait for.
+  void match_and_resume(coro_detail::sync_waiter* self) {
+    coro_detail::sync_waiter* woken;
+    {
+      std::lock_guard lock{mutex_};
+      woken = match();
+    }
+    resume_all(woken, self);
+  }
+
+  // Resume all the waiters of the `list` except for `self`. Returns true if `self` is in the list.
+  static bool resume_all(coro_detail::sync_waiter* list, coro_detail::sync_waiter* self) {
+    bool foundSelf = false;
+    while (list) {
+      coro_detail::sync_waiter* next = list->next_;
+      if (list == self) {
+        foundSelf = true;
+      } else {
+        coro_detail::resume_waiter(*list);
+      }
+      list = next;
+    }
+    return foundSelf;
+  }
+
+  coro_detail::mpmc_ring<T> ring_;
+  std::atomic<bool> closed_{false};
+  // The sizes of the lists of waiters, read without the mutex on the fast paths.
+  std::atomic<size_t> numSendWaiters_{0};
+  std::atomic<size_t> numRecvWaiters_{0};
+  std::mutex mutex_;
+  waiter_list sendWaiters_;
+  waiter_list recvWaiters_;
+};
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_CHANNEL_H
@@ -0,0 +1,140 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_CHANNEL_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_CHANNEL_EXAMPLE_H
+
+#include <cstddef>
+#include <optional>
+
+#include "task/channel.h"
+#include "task/task.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * Sends the values in `[begin, end)` to the `channel`, and closes it afterwards if `closeWhenDone`
+ * is set. Returns the number of sent values, which is smaller if the channel was closed by someone
+ * else. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> produce_values(async_channel<size_t>& channel,
+ *                                                           size_t begin, size_t end,
+ *                                                           bool closeWhenDone) {
+ *     size_t numSent = 0;
+ *     for (size_t i = begin; i < end && co_await channel.send(i); ++i) ++numSent;
+ *     if (closeWhenDone) channel.close();
+ *     co_return numSent;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> produce_values(async_channel<size_t>& channel,
+                                                               size_t begin, size_t end,
+                                                               bool closeWhenDone) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    async_channel<size_t>& channel_;
+    size_t i_;
+    size_t end_;
+    bool closeWhenDone_;
+    size_t numSent_ = 0;
+    bool sent_ = false;
+
+    // Contains the intrusive waiter node and the value, so a full channel doesn't allocate.
+    coro_storage<async_channel<size_t>::send_awaiter&, true> send_awaiter_;
+
+    CoroFrame(async_channel<size_t>& channel, size_t begin, size_t end, bool closeWhenDone)
+        : channel_(channel), i_(begin), end_(end), closeWhenDone_(closeWhenDone) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      for (; this->i_ < this->end_; ++this->i_) {
+        CO_AWAIT(1, send_awaiter_, this->channel_.send(this->i_), this->sent_ =);
+        if (!this->sent_) {
+          break;
+        }
+        ++this->numSent_;
+      }
+      if (this->closeWhenDone_) {
+        this->channel_.close();
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->numSent_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->send_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(channel, begin, end, closeWhenDone);
+}
+
+/**
+ * Receives values from the `channel` until it is closed, and returns their sum. Manually lowered
+ * equivalent of:
+ *   task<size_t, stackless_coroutine_handle> sum_values(async_channel<size_t>& channel) {
+ *     size_t sum = 0;
+ *     while (std::optional<size_t> value = co_await channel.recv()) sum += *value;
+ *     co_return sum;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> sum_values(async_channel<size_t>& channel) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    async_channel<size_t>& channel_;
+    size_t sum_ = 0;
+    std::optional<size_t> value_;
+
+    coro_storage<async_channel<size_t>::recv_awaiter&, true> recv_awaiter_;
+
+    explicit CoroFrame(async_channel<size_t>& channel) : channel_(channel) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      while (true) {
+        CO_AWAIT(1, recv_awaiter_, this->channel_.recv(), this->value_ =);
+        if (!this->value_) {
+          break;
+        }
+        this->sum_ += *this->value_;
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->sum_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->recv_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(channel);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_CHANNEL_EXAMPLE_H
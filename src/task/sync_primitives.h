@@ -0,0 +1,407 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_SYNC_PRIMITIVES_H
+#define GENERATOR_REWRITE_EXAMPLES_SYNC_PRIMITIVES_H
+
+// Synchronization primitives for stackless coroutines, which suspend the awaiting coroutine
+// instead of blocking the thread:
+//   co_await mutex.lock();           ...  mutex.unlock();
+//   async_mutex_lock lock = co_await mutex.scoped_lock();
+//   co_await semaphore.acquire();    ...  semaphore.release();
+//   co_await latch.wait();           // elsewhere: latch.count_down();
+//
+// The waiters are intrusive lists of the awaiters, which live in the `coro_storage` of the
+// suspended frame, so waiting never allocates. The uncontended paths (locking a free mutex,
+// acquiring an available permit, waiting for a latch that is already released) are a single atomic
+// read-modify-write, and don't suspend.
+//
+// Releasing hands the ownership (the mutex or the permit) directly to the first waiter, which is
+// resumed on the releasing thread. `unlock()` and `release()` resume it inline, unless they are
+// called by a coroutine that was itself resumed that way: then it is queued and resumed as soon as
+// that coroutine suspends, so a chain of handoffs (A unlocks for B, which unlocks for C, ...) runs
+// in a loop instead of growing the stack. `unlock_handoff()` and `release_handoff()` instead
+// return its handle, to be returned from an `await_suspend` or `resumeFunc` for symmetric
+// transfer, or to be handed to a scheduler.
+//
+// The primitives can be used from any thread, and a waiter may be resumed on another thread than
+// the one it suspended on. Everything that the previous owner wrote happens-before the next owner
+// is resumed. The awaiters must not be moved after they were awaited.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "util/coroutine_handle.h"
+
+namespace coro_detail {
+// The intrusive list node of a suspended waiter, a base class of the awaiters.
+struct sync_waiter {
+  stackless_coroutine_handle<void> waiter_;
+  sync_waiter* next_ = nullptr;
+};
+
+// Resume the coroutine of the (dequeued) `node` on this thread, or queue it if this thread is
+// already resuming waiters further up the stack.
+inline void resume_waiter(sync_waiter& node) {
+  struct pending_list {
+    sync_waiter* head_ = nullptr;
+    sync_waiter* tail_ = nullptr;
+    bool draining_ = false;
+  };
+  static thread_local pending_list pending;
+  node.next_ = nullptr;
+  if (pending.draining_) {
+    (pending.tail_ ? pending.tail_->next_ : pending.head_) = &node;
+    pending.tail_ = &node;
+    return;
+  }
+  pending.draining_ = true;
+  // The node is destroyed when its coroutine is resumed.
+  node.waiter_.resume();
+  while (sync_waiter* next = pending.head_) {
+    pending.head_ = next->next_;
+    if (!pending.head_) {
+      pending.tail_ = nullptr;
+    }
+    next->waiter_.resume();
+  }
+  pending.draining_ = false;
+}
+}  // namespace coro_detail
+
+class async_mutex_lock;
+
+// A mutex whose waiters are resumed in FIFO order.
+//
+// Implementation (after Lewis Baker's cppcoro): `state_` is `not_locked`, `locked_no_waiters`, or
+// the head of a LIFO stack of newly suspended awaiters, onto which they are pushed with a CAS. The
+// owner moves that stack (in reverse) to the FIFO list `waiters_` when it runs out of waiters, so
+// `waiters_` is only accessed by the owner.
+class async_mutex {
+ public:
+  async_mutex() noexcept = default;
+  async_mutex(const async_mutex&) = delete;
+  async_mutex& operator=(const async_mutex&) = delete;
+
+  // Awaiter for `co_await mutex.lock()`.
+  class lock_awaiter : coro_detail::sync_waiter {
+   public:
+    explicit lock_awaiter(async_mutex& mutex) noexcept : mutex_(&mutex) {}
+
+    bool await_ready() noexcept { return mutex_->try_lock(); }
+
+    // Returns false (don't suspend) if the mutex was unlocked in the meantime.
+    template <typename Promise>
+    bool await_suspend(stackless_coroutine_handle<Promise> h) noexcept {
+      waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      return mutex_->enqueue(*this);
+    }
+
+    static constexpr void await_resume() noexcept {}
+
+   protected:
+    async_mutex* mutex_;
+
+   private:
+    friend class async_mutex;
+  };
+
+  // Awaiter for `co_await mutex.scoped_lock()`, returns an `async_mutex_lock`.
+  class scoped_lock_awaiter : public lock_awaiter {
+   public:
+    using lock_awaiter::lock_awaiter;
+
+    async_mutex_lock await_resume() noexcept;
+  };
+
+  lock_awaiter lock() noexcept { return lock_awaiter{*this}; }
+
+  scoped_lock_awaiter scoped_lock() noexcept { return scoped_lock_awaiter{*this}; }
+
+  bool try_lock() noexcept {
+    uintptr_t expected = not_locked;
+    return state_.compare_exchange_strong(expected, locked_no_waiters, std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  // Unlock the mutex (which must be locked by the caller), and resume the next owner, if any.
+  void unlock() {
+    if (lock_awaiter* next = next_owner()) {
+      coro_detail::resume_waiter(*next);
+    }
+  }
+
+  // Unlock the mutex, or transfer it to the first waiter, whose handle is returned and has to be
+  // resumed by the caller. Returns a null handle if there are no waiters.
+  [[nodiscard]] stackless_coroutine_handle<void> unlock_handoff() noexcept {
+    lock_awaiter* next = next_owner();
+    return next ? next->waiter_ : stackless_coroutine_handle<void>{};
+  }
+
+ private:
+  static constexpr uintptr_t not_locked = 1;
+  static constexpr uintptr_t locked_no_waiters = 0;
+
+  // Unlock the mutex and return null, or dequeue and return the first waiter, which now owns it.
+  lock_awaiter* next_owner() noexcept {
+    lock_awaiter* head = waiters_;
+    if (!head) {
+      uintptr_t expected = locked_no_waiters;
+      if (state_.compare_exchange_strong(expected, not_locked, std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      // Take all the new waiters, and reverse them into FIFO order.
+      auto* node = reinterpret_cast<lock_awaiter*>(
+          state_.exchange(locked_no_waiters, std::memory_order_acquire));
+      do {
+        auto* next = static_cast<lock_awaiter*>(node->next_);
+        node->next_ = head;
+        head = node;
+        node = next;
+      } while (node);
+    }
+    waiters_ = static_cast<lock_awaiter*>(head->next_);
+    return head;
+  }
+
+  // Push the `awaiter` onto the stack of waiters, or lock the mutex if it is not locked. Returns
+  // true if the awaiter has to wait.
+  bool enqueue(lock_awaiter& awaiter) noexcept {
+    uintptr_t old = state_.load(std::memory_order_relaxed);
+    while (true) {
+      if (old == not_locked) {
+        if (state_.compare_exchange_weak(old, locked_no_waiters, std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+          return false;
+        }
+      } else {
+        // `locked_no_waiters` is the empty stack.
+        awaiter.next_ = reinterpret_cast<lock_awaiter*>(old);
+        if (state_.compare_exchange_weak(old, reinterpret_cast<uintptr_t>(&awaiter),
+                                         std::memory_order_release, std::memory_order_relaxed)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  std::atomic<uintptr_t> state_{not_locked};
+  lock_awaiter* waiters_ = nullptr;
+};
+
+// Owns the lock of an `async_mutex`, and unlocks it on destruction.
+class async_mutex_lock {
+ public:
+  explicit async_mutex_lock(async_mutex& mutex) noexcept : mutex_(&mutex) {}
+
+  async_mutex_lock(async_mutex_lock&& other) noexcept
+      : mutex_(std::exchange(other.mutex_, nullptr)) {}
+  async_mutex_lock& operator=(async_mutex_lock&& other) noexcept {
+    if (this != &other) {
+      if (mutex_) {
+        mutex_->unlock();
+      }
+      mutex_ = std::exchange(other.mutex_, nullptr);
+    }
+    return *this;
+  }
+
+  ~async_mutex_lock() {
+    if (mutex_) {
+      mutex_->unlock();
+    }
+  }
+
+ private:
+  async_mutex* mutex_;
+};
+
+inline async_mutex_lock async_mutex::scoped_lock_awaiter::await_resume() noexcept {
+  return async_mutex_lock{*mutex_};
+}
+
+// A counting semaphore whose waiters are resumed in FIFO order.
+//
+// `count_` is the number of available permits, or minus the number of coroutines that are waiting
+// (or about to wait) for one. Only the contended paths take `mutex_`, which protects the list of
+// waiters. A `release` that finds a waiter that has decremented `count_` but is not in the list
+// yet leaves a permit in `handoffs_`, which the waiter takes instead of suspending.
+class async_semaphore {
+ public:
+  explicit async_semaphore(int64_t permits) noexcept : count_(permits) {}
+  async_semaphore(const async_semaphore&) = delete;
+  async_semaphore& operator=(const async_semaphore&) = delete;
+
+  // Awaiter for `co_await semaphore.acquire()`.
+  class acquire_awaiter : coro_detail::sync_waiter {
+   public:
+    explicit acquire_awaiter(async_semaphore& semaphore) noexcept : semaphore_(&semaphore) {}
+
+    bool await_ready() noexcept { return semaphore_->try_acquire(); }
+
+    // Returns false (don't suspend) if a permit became available in the meantime.
+    template <typename Promise>
+    bool await_suspend(stackless_coroutine_handle<Promise> h) {
+      waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      return semaphore_->enqueue(*this);
+    }
+
+    static constexpr void await_resume() noexcept {}
+
+   private:
+    friend class async_semaphore;
+    async_semaphore* semaphore_;
+  };
+
+  acquire_awaiter acquire() noexcept { return acquire_awaiter{*this}; }
+
+  bool try_acquire() noexcept {
+    int64_t count = count_.load(std::memory_order_relaxed);
+    while (count > 0) {
+      if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Return a permit, and resume the waiter that receives it, if any.
+  void release() {
+    if (acquire_awaiter* next = next_owner()) {
+      coro_detail::resume_waiter(*next);
+    }
+  }
+
+  // Return a permit, or transfer it to the first waiter, whose handle is returned and has to be
+  // resumed by the caller. Returns a null handle if there are no suspended waiters.
+  [[nodiscard]] stackless_coroutine_handle<void> release_handoff() {
+    acquire_awaiter* next = next_owner();
+    return next ? next->waiter_ : stackless_coroutine_handle<void>{};
+  }
+
+ private:
+  // Return a permit and return null, or dequeue and return the first waiter, which now owns it.
+  acquire_awaiter* next_owner() {
+    if (count_.fetch_add(1, std::memory_order_release) >= 0) {
+      return nullptr;
+    }
+    std::lock_guard lock{mutex_};
+    acquire_awaiter* head = head_;
+    if (!head) {
+      ++handoffs_;
+      return nullptr;
+    }
+    head_ = static_cast<acquire_awaiter*>(head->next_);
+    if (!head_) {
+      tail_ = nullptr;
+    }
+    return head;
+  }
+
+  // Take a permit, or append the `awaiter` to the waiters. Returns true if the awaiter has to wait.
+  bool enqueue(acquire_awaiter& awaiter) {
+    if (count_.fetch_sub(1, std::memory_order_acquire) > 0) {
+      return false;
+    }
+    std::lock_guard lock{mutex_};
+    if (handoffs_ > 0) {
+      --handoffs_;
+      return false;
+    }
+    if (tail_) {
+      tail_->next_ = &awaiter;
+    } else {
+      head_ = &awaiter;
+    }
+    tail_ = &awaiter;
+    return true;
+  }
+
+  std::atomic<int64_t> count_;
+  std::mutex mutex_;
+  acquire_awaiter* head_ = nullptr;
+  acquire_awaiter* tail_ = nullptr;
+  size_t handoffs_ = 0;
+};
+
+// A single-use barrier: `co_await latch.wait()` suspends until `count_down()` has been called
+// `count` times. All the waiters are then resumed (in FIFO order) by the last `count_down()`.
+//
+// `state_` is `released` or the head of a lock-free stack of the suspended awaiters.
+class async_latch {
+ public:
+  explicit async_latch(ptrdiff_t count) noexcept
+      : count_(count), state_(count > 0 ? 0 : released) {}
+  async_latch(const async_latch&) = delete;
+  async_latch& operator=(const async_latch&) = delete;
+
+  // Awaiter for `co_await latch.wait()`.
+  class wait_awaiter : coro_detail::sync_waiter {
+   public:
+    explicit wait_awaiter(async_latch& latch) noexcept : latch_(&latch) {}
+
+    bool await_ready() const noexcept { return latch_->try_wait(); }
+
+    // Returns false (don't suspend) if the latch was released in the meantime.
+    template <typename Promise>
+    bool await_suspend(stackless_coroutine_handle<Promise> h) noexcept {
+      waiter_ = stackless_coroutine_handle<void>{h.ptr};
+      return latch_->enqueue(*this);
+    }
+
+    static constexpr void await_resume() noexcept {}
+
+   private:
+    friend class async_latch;
+    async_latch* latch_;
+  };
+
+  wait_awaiter wait() noexcept { return wait_awaiter{*this}; }
+
+  bool try_wait() const noexcept { return state_.load(std::memory_order_acquire) == released; }
+
+  // Decrement the counter by `n`, and resume all the waiters if it reaches zero.
+  void count_down(ptrdiff_t n = 1) {
+    if (count_.fetch_sub(n, std::memory_order_acq_rel) != n) {
+      return;
+    }
+    auto* node =
+        reinterpret_cast<wait_awaiter*>(state_.exchange(released, std::memory_order_acq_rel));
+    wait_awaiter* head = nullptr;
+    while (node) {
+      auto* next = static_cast<wait_awaiter*>(node->next_);
+      node->next_ = head;
+      head = node;
+      node = next;
+    }
+    while (head) {
+      // The awaiter is destroyed when its coroutine is resumed.
+      auto* next = static_cast<wait_awaiter*>(head->next_);
+      coro_detail::resume_waiter(*head);
+      head = next;
+    }
+  }
+
+ private:
+  // Not a valid awaiter address, the empty stack is 0.
+  static constexpr uintptr_t released = 1;
+
+  bool enqueue(wait_awaiter& awaiter) noexcept {
+    uintptr_t old = state_.load(std::memory_order_acquire);
+    while (old != released) {
+      awaiter.next_ = reinterpret_cast<wait_awaiter*>(old);
+      if (state_.compare_exchange_weak(old, reinterpret_cast<uintptr_t>(&awaiter),
+                                       std::memory_order_release, std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::atomic<ptrdiff_t> count_;
+  std::atomic<uintptr_t> state_;
+};
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_SYNC_PRIMITIVES_H
@@ -0,0 +1,214 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_SYNC_PRIMITIVES_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_SYNC_PRIMITIVES_EXAMPLE_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "task/sync_primitives.h"
+#include "task/task.h"
+#include "task/thread_pool.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * Increments the (non-atomic) `counter`, which is shared with other tasks, `n` times. Manually
+ * lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> locked_increment(async_mutex& mutex, size_t& counter,
+ *                                                             size_t n) {
+ *     for (size_t i = 0; i < n; ++i) {
+ *       co_await mutex.lock();
+ *       ++counter;
+ *       mutex.unlock();
+ *     }
+ *     co_return n;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> locked_increment(async_mutex& mutex,
+                                                                 size_t& counter, size_t n) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    async_mutex& mutex_;
+    size_t& counter_;
+    size_t n_;
+    size_t i_ = 0;
+
+    // Contains the intrusive waiter node, so waiting for the mutex doesn't allocate.
+    coro_storage<async_mutex::lock_awaiter&, true> lock_awaiter_;
+
+    CoroFrame(async_mutex& mutex, size_t& counter, size_t n)
+        : mutex_(mutex), counter_(counter), n_(n) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      for (; this->i_ < this->n_; ++this->i_) {
+        CO_AWAIT(1, lock_awaiter_, this->mutex_.lock());
+        ++this->counter_;
+        this->mutex_.unlock();
+      }
+      CO_RETURN_VALUE(2, final_awaiter_, (this->n_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->lock_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(mutex, counter, n);
+}
+
+/**
+ * Hops onto the `pool` and holds one of the permits of the `semaphore` for one more hop, which
+ * limits the number of such tasks that run concurrently. `inFlight` counts the holders of a permit,
+ * `maxInFlight` records its maximum. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> bounded_compute_value(
+ *       thread_pool& pool, async_semaphore& semaphore, std::atomic<size_t>& inFlight,
+ *       std::atomic<size_t>& maxInFlight, size_t x) {
+ *     co_await pool.schedule();
+ *     co_await semaphore.acquire();
+ *     size_t n = inFlight.fetch_add(1) + 1;
+ *     size_t max = maxInFlight.load();
+ *     while (max < n && !maxInFlight.compare_exchange_weak(max, n)) {}
+ *     co_await pool.schedule();
+ *     inFlight.fetch_sub(1);
+ *     semaphore.release();
+ *     co_return x * 2;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> bounded_compute_value(
+    thread_pool& pool, async_semaphore& semaphore, std::atomic<size_t>& inFlight,
+    std::atomic<size_t>& maxInFlight, size_t x) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    thread_pool& pool_;
+    async_semaphore& semaphore_;
+    std::atomic<size_t>& inFlight_;
+    std::atomic<size_t>& maxInFlight_;
+    size_t x_;
+
+    coro_storage<thread_pool::schedule_awaiter&, true> schedule_awaiter_;
+    coro_storage<async_semaphore::acquire_awaiter&, true> acquire_awaiter_;
+
+    CoroFrame(thread_pool& pool, async_semaphore& semaphore, std::atomic<size_t>& inFlight,
+              std::atomic<size_t>& maxInFlight, size_t x)
+        : pool_(pool),
+          semaphore_(semaphore),
+          inFlight_(inFlight),
+          maxInFlight_(maxInFlight),
+          x_(x) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+        case 3:
+          goto label_3;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, schedule_awaiter_, this->pool_.schedule());
+      CO_AWAIT(2, acquire_awaiter_, this->semaphore_.acquire());
+      {
+        const size_t n = this->inFlight_.fetch_add(1) + 1;
+        size_t max = this->maxInFlight_.load();
+        while (max < n && !this->maxInFlight_.compare_exchange_weak(max, n)) {
+        }
+      }
+      CO_AWAIT(3, schedule_awaiter_, this->pool_.schedule());
+      this->inFlight_.fetch_sub(1);
+      this->semaphore_.release();
+      CO_RETURN_VALUE(4, final_awaiter_, (this->x_ * 2));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+        case 3:
+          this->schedule_awaiter_.destroy();
+          return;
+        case 2:
+          this->acquire_awaiter_.destroy();
+          return;
+        case 4:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(pool, semaphore, inFlight, maxInFlight, x);
+}
+
+/**
+ * Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> latched_compute_value(async_latch& latch, size_t x) {
+ *     co_await latch.wait();
+ *     co_return x * 2;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> latched_compute_value(async_latch& latch,
+                                                                      size_t x) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    async_latch& latch_;
+    size_t x_;
+
+    coro_storage<async_latch::wait_awaiter&, true> wait_awaiter_;
+
+    CoroFrame(async_latch& latch, size_t x) : latch_(latch), x_(x) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, wait_awaiter_, this->latch_.wait());
+      CO_RETURN_VALUE(2, final_awaiter_, (this->x_ * 2));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->wait_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(latch, x);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_SYNC_PRIMITIVES_EXAMPLE_H
@@ -0,0 +1,56 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_SYNC_WAIT_H
+#define GENERATOR_REWRITE_EXAMPLES_SYNC_WAIT_H
+
+// `sync_wait(task)` starts an (unstarted) task on the calling thread, blocks until it is done, and
+// returns its result (or rethrows its exception):
+//   size_t value = sync_wait(scheduled_compute_value(pool, 21));
+//
+// Unlike `task::start()`, this also works when the task hops onto other threads (e.g. via
+// `co_await pool.schedule()`) and completes there. The continuation of the task is a
+// `completion_frame` on the stack of the caller, which unparks the calling thread (see
+// `util/parker.h`), so waiting doesn't allocate. A task that completes synchronously never makes
+// the thread sleep.
+//
+// Must not be called from a thread that the task needs in order to make progress, e.g. from the
+// only worker of the pool that the task is scheduled on, or from the thread of an `event_loop`
+// that the task waits on.
+
+#include <type_traits>
+#include <utility>
+
+#include "task/task.h"
+#include "task/when_all.h"
+#include "util/coroutine_handle.h"
+#include "util/parker.h"
+
+namespace detail {
+// The owner of the continuation of the task in `sync_wait`.
+struct sync_wait_state {
+  coro_detail::parker parker_;
+
+  // Called on the thread that completes the task. The caller of `sync_wait` might return (and
+  // destroy this state) as soon as it is unparked, so nothing is accessed afterwards.
+  stackless_coroutine_handle<void> on_child_done(size_t) noexcept {
+    parker_.unpark();
+    return {};
+  }
+};
+}  // namespace detail
+
+template <typename T>
+T sync_wait(task<T, stackless_coroutine_handle> t) {
+  detail::sync_wait_state state;
+  detail::completion_frame<detail::sync_wait_state> continuation;
+  continuation.owner_ = &state;
+  auto h = t.handle();
+  h.promise().continuation_ = continuation.handle();
+  h.resume();
+  state.parker_.park();
+  if constexpr (std::is_void_v<T>) {
+    h.promise().result();
+  } else {
+    return std::move(h.promise()).result();
+  }
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_SYNC_WAIT_H
@@ -30,7 +30,8 @@ struct task_final_awaiter {
   static constexpr void await_resume() noexcept {}
 };
 
-// Value-returning promise.
+// Value-returning promise. Wrap it in `resource_allocated` (see `util/memory_resource_allocation.h`)
+// to allocate the frame from a `std::pmr::memory_resource`.
 template <typename T, template <typename...> typename TaskHandle>
 class task_promise {
  public:
@@ -164,6 +165,10 @@ class [[nodiscard]] task {
 
   decltype(auto) result() { return coro_.promise().result(); }
 
+  // Direct access to the handle, used by combinators that start tasks and set their continuation
+  // themselves (see `task/when_all.h`).
+  handle_type handle() const noexcept { return coro_; }
+
   // C++17 equivalent of operator co_await.
   friend auto get_awaiter(const task& t) { return detail::task_awaiter<T, TaskHandle>{t.coro_}; }
 
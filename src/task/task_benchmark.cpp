@@ -0,0 +1,281 @@
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./channel_example.h"
+#include "./sync_primitives_example.h"
+#include "./sync_wait.h"
+#include "./task_example.h"
+#include "./thread_pool_example.h"
+#include "./when_all_example.h"
+#include "generator/async_generator_example.h"
+#include "generator/channel_generator.h"
+#include "util/allocation_counter.h"
+#include "util/frame_pool.h"
+
+using default_promise = task<size_t, stackless_coroutine_handle>::promise_type;
+using pooled_promise = pool_allocated<default_promise>;
+
+// `add_values(0, range)` runs `(range + 1) / 2` loop iterations, each of which starts two inner
+// tasks (two resumes), and resumes the outer task twice via symmetric transfer. The additional
+// resume is the initial `start()`.
+static double numResumes(size_t range) { return 4.0 * static_cast<double>((range + 1) / 2) + 1; }
+
+template <typename Promise>
+static void BM_AddValues(benchmark::State& state) {
+  const size_t range = state.range(0);
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    auto t = add_values<Promise>(0, range);
+    t.start();
+    benchmark::DoNotOptimize(t.result());
+    allocations += numAllocations() - before;
+  }
+  state.counters["allocs_per_resume"] =
+      static_cast<double>(allocations) / (numResumes(range) * state.iterations());
+}
+
+// All the frames of one `add_values` call are placed into a monotonic arena, which is released in
+// bulk at the end of each iteration.
+static void BM_AddValuesArena(benchmark::State& state) {
+  const size_t range = state.range(0);
+  alignas(std::max_align_t) static char buffer[1 << 22];
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    std::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer)};
+    auto t = add_values(std::allocator_arg, &arena, 0, range);
+    t.start();
+    benchmark::DoNotOptimize(t.result());
+    allocations += numAllocations() - before;
+  }
+  state.counters["allocs_per_resume"] =
+      static_cast<double>(allocations) / (numResumes(range) * state.iterations());
+}
+
+// A task that consumes `range` values from an async generator, which awaits one inner task per
+// value. Each value takes three symmetric transfers (consumer -> producer -> inner task -> producer
+// -> consumer).
+static void BM_AsyncGeneratorSum(benchmark::State& state) {
+  const size_t range = state.range(0);
+  for (auto _ : state) {
+    auto gen = async_compute_values(0, range);
+    auto t = sum_async(gen);
+    t.start();
+    benchmark::DoNotOptimize(t.result());
+  }
+  state.SetItemsProcessed(state.iterations() * range);
+}
+
+// `state.range(0)` independent chains of 20 tasks each, which all hop onto a work-stealing pool
+// with one worker per core.
+static void BM_ThreadPoolChains(benchmark::State& state) {
+  const size_t numChains = state.range(0);
+  thread_pool pool;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  tasks.reserve(numChains);
+  for (auto _ : state) {
+    tasks.clear();
+    for (size_t i = 0; i < numChains; ++i) {
+      tasks.push_back(scheduled_sum(pool, 0, 20));
+      tasks.back().start();
+    }
+    pool.wait_idle();
+    benchmark::DoNotOptimize(tasks.back().result());
+  }
+  state.SetItemsProcessed(state.iterations() * numChains * 21);
+  state.counters["workers"] = static_cast<double>(pool.size());
+}
+
+// Overhead of the `when_all` join, children that complete synchronously.
+static void BM_WhenAllInline(benchmark::State& state) {
+  const size_t numChildren = state.range(0);
+  for (auto _ : state) {
+    std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+    tasks.reserve(numChildren);
+    for (size_t i = 0; i < numChildren; ++i) {
+      tasks.push_back(compute_value(i));
+    }
+    auto t = await_result(when_all(std::move(tasks)));
+    t.start();
+    benchmark::DoNotOptimize(t.result().back());
+  }
+  state.SetItemsProcessed(state.iterations() * numChildren);
+}
+
+// The same work as `BM_ThreadPoolChains`, but the chains are the children of a single `when_all`.
+static void BM_WhenAllFanOut(benchmark::State& state) {
+  const size_t numChains = state.range(0);
+  thread_pool pool;
+  for (auto _ : state) {
+    std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+    tasks.reserve(numChains);
+    for (size_t i = 0; i < numChains; ++i) {
+      tasks.push_back(scheduled_sum(pool, 0, 20));
+    }
+    auto t = await_result(when_all_on(pool, std::move(tasks)));
+    t.start();
+    pool.wait_idle();
+    benchmark::DoNotOptimize(t.result().back());
+  }
+  state.SetItemsProcessed(state.iterations() * numChains * 21);
+  state.counters["workers"] = static_cast<double>(pool.size());
+}
+
+// `locked_increment` on a mutex that is never contended.
+static void BM_AsyncMutexUncontended(benchmark::State& state) {
+  const size_t numIncrements = state.range(0);
+  async_mutex mutex;
+  size_t counter = 0;
+  for (auto _ : state) {
+    auto t = locked_increment(mutex, counter, numIncrements);
+    t.start();
+    benchmark::DoNotOptimize(t.result());
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * numIncrements);
+}
+
+// `state.range(0)` tasks suspend on a locked mutex, which is then handed from one to the next. The
+// only allocations are the frames of the tasks.
+static void BM_AsyncMutexHandoff(benchmark::State& state) {
+  const size_t numWaiters = state.range(0);
+  async_mutex mutex;
+  size_t counter = 0;
+  size_t allocations = 0;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  tasks.reserve(numWaiters);
+  for (auto _ : state) {
+    mutex.try_lock();
+    size_t before = numAllocations();
+    for (size_t i = 0; i < numWaiters; ++i) {
+      tasks.push_back(locked_increment(mutex, counter, 1));
+      tasks.back().start();
+    }
+    allocations += numAllocations() - before - numWaiters;
+    mutex.unlock();
+    tasks.clear();
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * numWaiters);
+  state.counters["waitAllocations"] =
+      benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+// A producer and a consumer task on the same thread. The producer fills the channel of capacity
+// `state.range(0)` and suspends, then the consumer alternates with it.
+static void BM_ChannelTasks(benchmark::State& state) {
+  constexpr size_t numValues = 10000;
+  for (auto _ : state) {
+    async_channel<size_t> channel{static_cast<size_t>(state.range(0))};
+    auto producer = produce_values(channel, 0, numValues, true);
+    auto consumer = sum_values(channel);
+    producer.start();
+    consumer.start();
+    benchmark::DoNotOptimize(consumer.result());
+  }
+  state.SetItemsProcessed(state.iterations() * numValues);
+}
+
+// A producer task on another thread, and a synchronous consumer via `channel_generator`.
+static void BM_ChannelToGenerator(benchmark::State& state) {
+  constexpr size_t numValues = 100000;
+  for (auto _ : state) {
+    async_channel<size_t> channel{static_cast<size_t>(state.range(0))};
+    auto producer = produce_values(channel, 0, numValues, true);
+    std::thread thread{[&producer] { producer.start(); }};
+    size_t sum = 0;
+    for (size_t value : channel_generator(channel)) {
+      sum += value;
+    }
+    thread.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * numValues);
+}
+
+// The baseline for `BM_ChannelToGenerator`: a bounded queue with a mutex and condition variables,
+// and a producer thread.
+static void BM_MutexCondvarQueue(benchmark::State& state) {
+  constexpr size_t numValues = 100000;
+  const size_t capacity = state.range(0);
+  for (auto _ : state) {
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<size_t> queue;
+    bool closed = false;
+    std::thread thread{[&] {
+      for (size_t i = 0; i < numValues; ++i) {
+        std::unique_lock lock{mutex};
+        notFull.wait(lock, [&] { return queue.size() < capacity; });
+        queue.push_back(i);
+        notEmpty.notify_one();
+      }
+      std::lock_guard lock{mutex};
+      closed = true;
+      notEmpty.notify_one();
+    }};
+    size_t sum = 0;
+    while (true) {
+      std::unique_lock lock{mutex};
+      notEmpty.wait(lock, [&] { return !queue.empty() || closed; });
+      if (queue.empty()) {
+        break;
+      }
+      sum += queue.front();
+      queue.pop_front();
+      notFull.notify_one();
+    }
+    thread.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * numValues);
+}
+
+// `sync_wait` of a task that completes synchronously: the thread never sleeps, and waiting doesn't
+// allocate (the frame of the task is the only allocation).
+static void BM_SyncWaitInline(benchmark::State& state) {
+  size_t allocations = 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    size_t before = numAllocations();
+    benchmark::DoNotOptimize(sync_wait(compute_value(i++)));
+    allocations += numAllocations() - before - 1;
+  }
+  state.counters["waitAllocations"] =
+      benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+// `sync_wait` of a task that hops onto a pool and completes there, which measures the latency of
+// waking up the blocked thread.
+static void BM_SyncWaitPool(benchmark::State& state) {
+  thread_pool pool{1};
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sync_wait(scheduled_compute_value(pool, i++)));
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_AddValues, default_promise)->Arg(10)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_AddValues, pooled_promise)->Arg(10)->Arg(10000);
+BENCHMARK(BM_AddValuesArena)->Arg(10)->Arg(10000);
+BENCHMARK(BM_AsyncGeneratorSum)->Arg(10)->Arg(10000);
+BENCHMARK(BM_ThreadPoolChains)->Arg(1000)->UseRealTime();
+BENCHMARK(BM_WhenAllInline)->Arg(10)->Arg(10000);
+BENCHMARK(BM_WhenAllFanOut)->Arg(1000)->UseRealTime();
+BENCHMARK(BM_AsyncMutexUncontended)->Arg(1000);
+BENCHMARK(BM_AsyncMutexHandoff)->Arg(10)->Arg(10000);
+BENCHMARK(BM_ChannelTasks)->Arg(2)->Arg(1024);
+BENCHMARK(BM_ChannelToGenerator)->Arg(1024)->UseRealTime();
+BENCHMARK(BM_MutexCondvarQueue)->Arg(1024)->UseRealTime();
+BENCHMARK(BM_SyncWaitInline);
+BENCHMARK(BM_SyncWaitPool)->UseRealTime();
+
+BENCHMARK_MAIN();
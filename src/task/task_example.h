@@ -2,23 +2,30 @@
 #define GENERATOR_REWRITE_EXAMPLES_TASK_EXAMPLE_H
 
 #include <iostream>
+#include <memory>
+#include <memory_resource>
 
 #include "task/task.h"
 #include "util/coroutine_frame.h"
+#include "util/frame_pool.h"
 #include "util/macros.h"
-
-/**
- * Manually lowered equivalent of:
- *   task<size_t, stackless_coroutine_handle> compute_value(size_t x) { co_return x * 2; }
- */
-inline task<size_t, stackless_coroutine_handle> compute_value(size_t x) {
-  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+#include "util/memory_resource_allocation.h"
+
+namespace detail {
+// Implementation of the `compute_value` overloads below. The `args` are either `(x)` or
+// `(std::allocator_arg, resource, x)`.
+template <typename Promise, typename... Args>
+task<size_t, stackless_coroutine_handle> compute_value_impl(Args&&... args) {
+  using promise_type = Promise;
   struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
     using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
     size_t x_;
 
     CoroFrame(size_t x) : x_(x) {}
 
+    // The allocator arguments are consumed by the promise's `operator new`.
+    CoroFrame(std::allocator_arg_t, std::pmr::memory_resource*, size_t x) : x_(x) {}
+
     stackless_coroutine_handle<void> doStepImpl() {
       switch (this->suspendIdx_) {
         case 0:
@@ -42,19 +49,41 @@ inline task<size_t, stackless_coroutine_handle> compute_value(size_t x) {
       }
     }
   };
-  return CoroFrame::ramp(x);
+  return CoroFrame::ramp(std::forward<Args>(args)...);
 }
+}  // namespace detail
 
 /**
  * Manually lowered equivalent of:
- *   task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
- *       size_t va = co_await compute_value(a);
- *       size_t vb = co_await compute_value(b);
- *       co_return va + vb;
- *   }
+ *   task<size_t, stackless_coroutine_handle> compute_value(size_t x) { co_return x * 2; }
+ *
+ * The `Promise` can be replaced by `pool_allocated<...>` (see `util/frame_pool.h`) to allocate the
+ * frame from the thread-local frame pool instead of the global `operator new`.
  */
-inline task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
-  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+template <typename Promise = task<size_t, stackless_coroutine_handle>::promise_type>
+task<size_t, stackless_coroutine_handle> compute_value(size_t x) {
+  return detail::compute_value_impl<Promise>(x);
+}
+
+/**
+ * Same as above, but the frame is allocated from the `resource`, which requires a
+ * `resource_allocated<...>` promise.
+ */
+template <typename Promise =
+              resource_allocated<task<size_t, stackless_coroutine_handle>::promise_type>>
+task<size_t, stackless_coroutine_handle> compute_value(std::allocator_arg_t,
+                                                       std::pmr::memory_resource* resource,
+                                                       size_t x) {
+  return detail::compute_value_impl<Promise>(std::allocator_arg, resource, x);
+}
+
+namespace detail {
+// Implementation of the `add_values` overloads below. The `args` are either `(a, b)` or
+// `(std::allocator_arg, resource, a, b)`.
+template <typename Promise, typename... Args>
+task<size_t, stackless_coroutine_handle> add_values_impl(Args&&... args) {
+  using promise_type = Promise;
+  constexpr bool withResource = sizeof...(Args) == 4;
   struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
     using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
     size_t a_;
@@ -62,6 +91,9 @@ inline task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
     size_t res_;
     size_t va_;
     size_t vb_;
+    // With the allocator arguments, the frames of the inner tasks are also allocated from this
+    // resource.
+    std::pmr::memory_resource* resource_ = nullptr;
 
     // Storage for the inner task and its awaiter.
     coro_storage<task<size_t, stackless_coroutine_handle>&, true> task_storage_;
@@ -69,6 +101,18 @@ inline task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
 
     CoroFrame(size_t a, size_t b) : a_(a), b_(b) {}
 
+    CoroFrame(std::allocator_arg_t, std::pmr::memory_resource* resource, size_t a, size_t b)
+        : a_(a), b_(b), resource_(resource) {}
+
+    task<size_t, stackless_coroutine_handle> computeValue(size_t x) {
+      // Only instantiated if needed, as promises like `pool_allocated` reject the resource.
+      if constexpr (withResource) {
+        return compute_value<Promise>(std::allocator_arg, this->resource_, x);
+      } else {
+        return compute_value<Promise>(x);
+      }
+    }
+
     ExceptionResult dispatchExceptionHandling() {
       // not implemented for now, just checking for the symmetric transfer.
       std::terminate();
@@ -90,11 +134,11 @@ inline task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
       this->res_ = 0;
       while (this->a_ < this->b_) {
         // size_t va = co_await compute_value(a_);
-        CO_INIT(task_storage_, (compute_value(this->a_)));
+        CO_INIT(task_storage_, (this->computeValue(this->a_)));
         CO_AWAIT(1, awaiter_storage_, CO_GET(task_storage_), this->va_ =);
         this->task_storage_.destroy();
 
-        CO_INIT(task_storage_, (compute_value(this->b_)));
+        CO_INIT(task_storage_, (this->computeValue(this->b_)));
         CO_AWAIT(2, awaiter_storage_, CO_GET(task_storage_), this->vb_ =);
         this->task_storage_.destroy();
         this->res_ += this->va_ + this->vb_;
@@ -124,7 +168,35 @@ inline task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
       }
     }
   };
-  return CoroFrame::ramp(a, b);
+  return CoroFrame::ramp(std::forward<Args>(args)...);
+}
+}  // namespace detail
+
+/**
+ * Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
+ *       size_t va = co_await compute_value(a);
+ *       size_t vb = co_await compute_value(b);
+ *       co_return va + vb;
+ *   }
+ *
+ * The `Promise` is also used for the frames of the inner `compute_value` calls.
+ */
+template <typename Promise = task<size_t, stackless_coroutine_handle>::promise_type>
+task<size_t, stackless_coroutine_handle> add_values(size_t a, size_t b) {
+  return detail::add_values_impl<Promise>(a, b);
+}
+
+/**
+ * Same as above, but the frames of `add_values` and of all the inner `compute_value` calls are
+ * allocated from the `resource`, which requires a `resource_allocated<...>` promise.
+ */
+template <typename Promise =
+              resource_allocated<task<size_t, stackless_coroutine_handle>::promise_type>>
+task<size_t, stackless_coroutine_handle> add_values(std::allocator_arg_t,
+                                                    std::pmr::memory_resource* resource, size_t a,
+                                                    size_t b) {
+  return detail::add_values_impl<Promise>(std::allocator_arg, resource, a, b);
 }
 
 #endif  // GENERATOR_REWRITE_EXAMPLES_TASK_EXAMPLE_H
\ No newline at end of file
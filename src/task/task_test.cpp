@@ -0,0 +1,721 @@
+// Unit tests for the `task` coroutine type and its allocation strategies.
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "task/channel_example.h"
+#include "task/sync_primitives_example.h"
+#include "task/sync_wait.h"
+#include "task/task_example.h"
+#include "task/thread_pool_example.h"
+#include "task/when_all_example.h"
+#include "util/chase_lev_deque.h"
+#include "util/mpmc_ring.h"
+#include "util/parker.h"
+#include "util/frame_pool.h"
+
+using default_promise = task<size_t, stackless_coroutine_handle>::promise_type;
+using pooled_promise = pool_allocated<default_promise>;
+
+// ============================================================================
+// FramePoolTest - Tests for the thread-local frame pool
+// ============================================================================
+
+TEST(FramePoolTest, ReusesFreedBlocksOfSameSizeClass) {
+  using coro_detail::frame_pool;
+  frame_pool::release_thread_cache();
+  void* first = frame_pool::allocate(40);
+  frame_pool::deallocate(first, 40);
+  EXPECT_EQ(frame_pool::cached_blocks(40), 1u);
+  // 48 bytes are in the same size class as 40 bytes.
+  void* second = frame_pool::allocate(48);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(frame_pool::cached_blocks(40), 0u);
+  frame_pool::deallocate(second, 48);
+  frame_pool::release_thread_cache();
+  EXPECT_EQ(frame_pool::cached_blocks(40), 0u);
+}
+
+TEST(FramePoolTest, LargeFramesBypassThePool) {
+  using coro_detail::frame_pool;
+  constexpr size_t size = frame_pool::max_pooled_size + 1;
+  void* ptr = frame_pool::allocate(size);
+  frame_pool::deallocate(ptr, size);
+  EXPECT_EQ(frame_pool::cached_blocks(size), 0u);
+}
+
+TEST(FramePoolTest, FramesFreedOnOtherThreadAreAdopted) {
+  using coro_detail::frame_pool;
+  void* ptr = frame_pool::allocate(64);
+  size_t cachedOnOtherThread = 0;
+  std::thread t{[&]() {
+    frame_pool::deallocate(ptr, 64);
+    cachedOnOtherThread = frame_pool::cached_blocks(64);
+  }};
+  t.join();
+  EXPECT_EQ(cachedOnOtherThread, 1u);
+}
+
+// ============================================================================
+// PooledTaskTest - Tasks whose frames are allocated from the frame pool
+// ============================================================================
+
+TEST(PooledTaskTest, SameResultAsDefaultAllocation) {
+  auto expected = add_values<default_promise>(3, 1000);
+  expected.start();
+  auto pooled = add_values<pooled_promise>(3, 1000);
+  pooled.start();
+  EXPECT_EQ(pooled.result(), expected.result());
+}
+
+TEST(PooledTaskTest, InnerFramesAreRecycled) {
+  using coro_detail::frame_pool;
+  frame_pool::release_thread_cache();
+  {
+    auto t = add_values<pooled_promise>(0, 100);
+    t.start();
+    EXPECT_EQ(t.result(), 10000u);
+  }
+  // All the `compute_value` frames share the same block, and the outer frame has been returned
+  // to the pool as well when `t` was destroyed.
+  size_t cached = 0;
+  for (size_t cls = 0; cls < frame_pool::num_size_classes; ++cls) {
+    cached += frame_pool::cached_blocks((cls + 1) * frame_pool::granularity);
+  }
+  EXPECT_EQ(cached, 2u);
+}
+
+// ============================================================================
+// MemoryResourceTaskTest - Tasks whose frames are allocated from a memory resource
+// ============================================================================
+
+namespace {
+// A memory resource that counts the allocations and forwards them to the default resource.
+class counting_resource : public std::pmr::memory_resource {
+ public:
+  size_t numAllocations = 0;
+  size_t numDeallocations = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++numAllocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    ++numDeallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+}  // namespace
+
+TEST(MemoryResourceTaskTest, AllFramesComeFromTheResource) {
+  counting_resource resource;
+  {
+    auto t = add_values(std::allocator_arg, &resource, 0, 100);
+    t.start();
+    EXPECT_EQ(t.result(), 10000u);
+  }
+  // One frame for `add_values`, and two per loop iteration for `compute_value`.
+  EXPECT_EQ(resource.numAllocations, 101u);
+  EXPECT_EQ(resource.numDeallocations, 101u);
+}
+
+TEST(MemoryResourceTaskTest, MonotonicArena) {
+  alignas(std::max_align_t) char buffer[1 << 16];
+  counting_resource upstream;
+  std::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer), &upstream};
+  auto t = add_values(std::allocator_arg, &arena, 0, 100);
+  t.start();
+  EXPECT_EQ(t.result(), 10000u);
+  EXPECT_EQ(upstream.numAllocations, 0u);
+}
+
+// ============================================================================
+// ChaseLevDequeTest - The per-worker deques of the thread pool
+// ============================================================================
+
+TEST(ChaseLevDequeTest, OwnerIsLifoThievesAreFifoAndTheDequeGrows) {
+  coro_detail::chase_lev_deque<int> deque{2};
+  std::vector<int> items(10);
+  for (auto& item : items) {
+    deque.push(&item);
+  }
+  EXPECT_EQ(deque.steal(), &items[0]);
+  EXPECT_EQ(deque.pop(), &items[9]);
+  EXPECT_EQ(deque.steal(), &items[1]);
+  for (int i = 8; i >= 2; --i) {
+    EXPECT_EQ(deque.pop(), &items[i]);
+  }
+  EXPECT_EQ(deque.pop(), nullptr);
+  EXPECT_EQ(deque.steal(), nullptr);
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(ChaseLevDequeTest, EveryItemIsTakenExactlyOnce) {
+  constexpr int numItems = 100000;
+  coro_detail::chase_lev_deque<int> deque{16};
+  std::vector<int> items(numItems);
+  std::vector<std::atomic<int>> taken(numItems);
+  std::atomic<bool> done{false};
+  auto take = [&](int* item) { taken[item - items.data()].fetch_add(1); };
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < 3; ++t) {
+    thieves.emplace_back([&] {
+      while (!done.load()) {
+        if (int* item = deque.steal()) take(item);
+      }
+    });
+  }
+  for (int i = 0; i < numItems; ++i) {
+    deque.push(&items[i]);
+    if (i % 3 == 0) {
+      if (int* item = deque.pop()) take(item);
+    }
+  }
+  while (int* item = deque.pop()) take(item);
+  done = true;
+  for (auto& t : thieves) t.join();
+  for (int i = 0; i < numItems; ++i) {
+    ASSERT_EQ(taken[i].load(), 1) << i;
+  }
+}
+
+// ============================================================================
+// ThreadPoolTest - Tasks that are scheduled onto the work-stealing pool
+// ============================================================================
+
+TEST(ThreadPoolTest, ManyIndependentTaskChains) {
+  thread_pool pool{4};
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 1000; ++i) {
+    tasks.push_back(scheduled_sum(pool, 0, i % 20));
+  }
+  // Each task runs until `co_await pool.schedule()` on this thread, the rest runs on the workers.
+  for (auto& t : tasks) {
+    t.start();
+  }
+  pool.wait_idle();
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    size_t n = i % 20;
+    EXPECT_EQ(tasks[i].result(), n * (n - 1));
+  }
+}
+
+TEST(ThreadPoolTest, TasksRunOnTheWorkers) {
+  thread_pool pool{2};
+  EXPECT_EQ(pool.size(), 2u);
+  EXPECT_EQ(pool.current_worker(), 2u);
+  auto t = scheduled_compute_value(pool, 21);
+  t.start();
+  pool.wait_idle();
+  EXPECT_EQ(t.result(), 42u);
+}
+
+TEST(ThreadPoolTest, DestructorRunsTheScheduledTasks) {
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  {
+    thread_pool pool{3};
+    for (size_t i = 0; i < 100; ++i) {
+      tasks.push_back(scheduled_sum(pool, 0, 5));
+      tasks.back().start();
+    }
+  }
+  for (auto& t : tasks) {
+    ASSERT_TRUE(t.done());
+    EXPECT_EQ(t.result(), 20u);
+  }
+}
+
+// ============================================================================
+// WhenAllTest / WhenAnyTest - Fan-out of tasks and joining them again
+// ============================================================================
+
+TEST(WhenAllTest, FixedArityCollectsTheResultsInOrder) {
+  auto t = await_result(when_all(compute_value(1), compute_value(2), compute_value(3)));
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_EQ(t.result(), std::make_tuple(size_t{2}, size_t{4}, size_t{6}));
+}
+
+namespace {
+// Whether `when_all` accepts an argument of type `Task`.
+template <typename Task, typename = void>
+constexpr bool when_all_accepts = false;
+
+template <typename Task>
+constexpr bool when_all_accepts<Task, std::void_t<decltype(when_all(std::declval<Task>()))>> =
+    true;
+}  // namespace
+
+TEST(WhenAllTest, LvalueTasksAreNotMovedFrom) {
+  using Task = task<size_t, stackless_coroutine_handle>;
+  static_assert(when_all_accepts<Task>);
+  static_assert(!when_all_accepts<Task&>);
+  auto first = compute_value(1);
+  auto t = await_result(when_all(std::move(first), compute_value(2)));
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_EQ(t.result(), std::make_tuple(size_t{2}, size_t{4}));
+}
+
+TEST(WhenAllTest, RangeOfTasks) {
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 10; ++i) {
+    tasks.push_back(compute_value(i));
+  }
+  auto t = await_result(when_all(std::move(tasks)));
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_EQ(t.result(), (std::vector<size_t>{0, 2, 4, 6, 8, 10, 12, 14, 16, 18}));
+
+  auto empty = await_result(when_all(std::vector<task<size_t, stackless_coroutine_handle>>{}));
+  empty.start();
+  ASSERT_TRUE(empty.done());
+  EXPECT_TRUE(empty.result().empty());
+}
+
+TEST(WhenAllTest, ExceptionIsRethrownAfterAllChildrenFinished) {
+  auto t = await_result(when_all(checked_compute_value(1, 2), checked_compute_value(2, 2),
+                                 checked_compute_value(3, 2)));
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_THROW(t.result(), std::runtime_error);
+}
+
+TEST(WhenAllTest, ChildrenRunInParallelOnThePool) {
+  thread_pool pool{4};
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 500; ++i) {
+    tasks.push_back(scheduled_add_values(pool, i, 2 * i));
+    tasks.back().start();
+  }
+  std::vector<task<size_t, stackless_coroutine_handle>> sums;
+  for (size_t i = 0; i < 50; ++i) {
+    sums.push_back(scheduled_sum(pool, 0, i));
+  }
+  auto all = await_result(when_all_on(pool, std::move(sums)));
+  all.start();
+  pool.wait_idle();
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    EXPECT_EQ(tasks[i].result(), 6 * i);
+  }
+  ASSERT_TRUE(all.done());
+  auto& results = all.result();
+  ASSERT_EQ(results.size(), 50u);
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i], i * (i - 1));
+  }
+}
+
+TEST(WhenAnyTest, FirstFinishedChildWins) {
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  tasks.push_back(compute_value(5));
+  tasks.push_back(compute_value(6));
+  auto t = await_result(when_any(std::move(tasks)));
+  t.start();
+  ASSERT_TRUE(t.done());
+  EXPECT_EQ(t.result().index_, 0u);
+  EXPECT_EQ(t.result().value_, 10u);
+}
+
+TEST(WhenAnyTest, RemainingChildrenKeepRunningOnThePool) {
+  thread_pool pool{4};
+  std::vector<task<when_any_result<task<size_t, stackless_coroutine_handle>>,
+                   stackless_coroutine_handle>>
+      races;
+  for (size_t i = 0; i < 200; ++i) {
+    std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+    for (size_t j = 1; j <= 4; ++j) {
+      tasks.push_back(scheduled_sum(pool, 0, j * (i % 7)));
+    }
+    races.push_back(await_result(when_any_on(pool, std::move(tasks))));
+    races.back().start();
+  }
+  pool.wait_idle();
+  for (size_t i = 0; i < races.size(); ++i) {
+    ASSERT_TRUE(races[i].done());
+    auto& [index, value] = races[i].result();
+    ASSERT_LT(index, 4u);
+    size_t n = (index + 1) * (i % 7);
+    EXPECT_EQ(value, n * (n - 1));
+  }
+}
+
+// ============================================================================
+// AsyncMutexTest / AsyncSemaphoreTest / AsyncLatchTest - Suspending synchronization primitives
+// ============================================================================
+
+TEST(AsyncMutexTest, UnlockHandsOffToTheFirstWaiter) {
+  async_mutex mutex;
+  ASSERT_TRUE(mutex.try_lock());
+  EXPECT_FALSE(mutex.try_lock());
+  size_t counter = 0;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 3; ++i) {
+    tasks.push_back(locked_increment(mutex, counter, 1));
+    tasks.back().start();
+    EXPECT_FALSE(tasks.back().done());
+  }
+  auto next = mutex.unlock_handoff();
+  ASSERT_TRUE(next);
+  EXPECT_EQ(next.ptr, tasks[0].handle().ptr);
+  // Each waiter hands the mutex on to the next one when it unlocks.
+  next.resume();
+  for (auto& t : tasks) {
+    ASSERT_TRUE(t.done());
+    EXPECT_EQ(t.result(), 1u);
+  }
+  EXPECT_EQ(counter, 3u);
+  EXPECT_TRUE(mutex.try_lock());
+  EXPECT_FALSE(mutex.unlock_handoff());
+}
+
+TEST(AsyncMutexTest, ScopedLockUnlocksOnDestruction) {
+  async_mutex mutex;
+  {
+    auto t = await_result(mutex.scoped_lock());
+    t.start();
+    ASSERT_TRUE(t.done());
+    EXPECT_FALSE(mutex.try_lock());
+  }
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST(AsyncMutexTest, ContendedFromManyThreads) {
+  constexpr size_t numThreads = 4;
+  constexpr size_t tasksPerThread = 8;
+  constexpr size_t numIncrements = 2000;
+  async_mutex mutex;
+  size_t counter = 0;
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < numThreads * tasksPerThread; ++i) {
+    tasks.push_back(locked_increment(mutex, counter, numIncrements));
+  }
+  // A suspended task is resumed by whichever thread unlocks the mutex, before that thread's call
+  // to `start()` returns.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&tasks, t] {
+      for (size_t i = t; i < tasks.size(); i += numThreads) {
+        tasks[i].start();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& t : tasks) {
+    ASSERT_TRUE(t.done());
+  }
+  EXPECT_EQ(counter, numThreads * tasksPerThread * numIncrements);
+}
+
+TEST(AsyncSemaphoreTest, TryAcquireAndRelease) {
+  async_semaphore semaphore{2};
+  EXPECT_TRUE(semaphore.try_acquire());
+  EXPECT_TRUE(semaphore.try_acquire());
+  EXPECT_FALSE(semaphore.try_acquire());
+  EXPECT_FALSE(semaphore.release_handoff());
+  EXPECT_TRUE(semaphore.try_acquire());
+  semaphore.release();
+  semaphore.release();
+}
+
+TEST(AsyncSemaphoreTest, LimitsTheConcurrencyOnThePool) {
+  constexpr size_t numPermits = 3;
+  thread_pool pool{4};
+  async_semaphore semaphore{numPermits};
+  std::atomic<size_t> inFlight{0};
+  std::atomic<size_t> maxInFlight{0};
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 500; ++i) {
+    tasks.push_back(bounded_compute_value(pool, semaphore, inFlight, maxInFlight, i));
+    tasks.back().start();
+  }
+  pool.wait_idle();
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    EXPECT_EQ(tasks[i].result(), 2 * i);
+  }
+  EXPECT_GE(maxInFlight.load(), 1u);
+  EXPECT_LE(maxInFlight.load(), numPermits);
+  EXPECT_EQ(inFlight.load(), 0u);
+  // All the permits have been returned.
+  for (size_t i = 0; i < numPermits; ++i) {
+    EXPECT_TRUE(semaphore.try_acquire());
+  }
+  EXPECT_FALSE(semaphore.try_acquire());
+}
+
+TEST(AsyncLatchTest, LastCountDownResumesAllWaiters) {
+  async_latch latch{3};
+  EXPECT_FALSE(latch.try_wait());
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  for (size_t i = 0; i < 5; ++i) {
+    tasks.push_back(latched_compute_value(latch, i));
+    tasks.back().start();
+  }
+  latch.count_down();
+  latch.count_down();
+  for (auto& t : tasks) {
+    EXPECT_FALSE(t.done());
+  }
+  latch.count_down();
+  EXPECT_TRUE(latch.try_wait());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    EXPECT_EQ(tasks[i].result(), 2 * i);
+  }
+  // Waiting for a released latch doesn't suspend.
+  auto late = latched_compute_value(latch, 7);
+  late.start();
+  ASSERT_TRUE(late.done());
+  EXPECT_EQ(late.result(), 14u);
+}
+
+TEST(AsyncLatchTest, CountDownFromOtherThreads) {
+  constexpr size_t numThreads = 4;
+  async_latch latch{numThreads};
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&latch] { latch.count_down(); });
+    // Some waiters suspend before, some after the latch is released.
+    tasks.push_back(latched_compute_value(latch, t));
+    tasks.back().start();
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ASSERT_TRUE(tasks[i].done());
+    EXPECT_EQ(tasks[i].result(), 2 * i);
+  }
+}
+
+// ============================================================================
+// MpmcRingTest / ChannelTest - Bounded queues between producers and consumers
+// ============================================================================
+
+TEST(MpmcRingTest, FifoUpToTheCapacity) {
+  coro_detail::mpmc_ring<std::string> ring{3};
+  EXPECT_EQ(ring.capacity(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.try_emplace(std::to_string(i)));
+  }
+  std::string rejected = "rejected";
+  EXPECT_FALSE(ring.try_emplace(std::move(rejected)));
+  EXPECT_EQ(rejected, "rejected");
+  std::vector<std::string> popped;
+  while (ring.try_pop([&popped](std::string&& s) { popped.push_back(std::move(s)); })) {
+  }
+  EXPECT_EQ(popped, (std::vector<std::string>{"0", "1", "2", "3"}));
+  // The ring destroys the remaining elements.
+  EXPECT_TRUE(ring.try_emplace("left over"));
+}
+
+TEST(MpmcRingTest, EveryElementIsPoppedExactlyOnce) {
+  constexpr size_t numThreads = 4;
+  constexpr size_t perThread = 20000;
+  coro_detail::mpmc_ring<size_t> ring{64};
+  std::atomic<size_t> numPopped{0};
+  std::atomic<size_t> sum{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&ring, t] {
+      for (size_t i = t * perThread; i < (t + 1) * perThread; ++i) {
+        while (!ring.try_emplace(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      while (numPopped.load() < numThreads * perThread) {
+        if (!ring.try_pop([&sum](size_t&& v) { sum.fetch_add(v); })) {
+          std::this_thread::yield();
+        } else {
+          numPopped.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  const size_t n = numThreads * perThread;
+  EXPECT_EQ(sum.load(), n * (n - 1) / 2);
+}
+
+TEST(ChannelTest, FullChannelSuspendsTheProducer) {
+  async_channel<size_t> channel{4};
+  auto producer = produce_values(channel, 0, 10, false);
+  producer.start();
+  EXPECT_FALSE(producer.done());
+  auto consumer = sum_values(channel);
+  // Every received value makes room for the suspended producer.
+  consumer.start();
+  ASSERT_TRUE(producer.done());
+  EXPECT_EQ(producer.result(), 10u);
+  EXPECT_FALSE(consumer.done());
+  channel.close();
+  ASSERT_TRUE(consumer.done());
+  EXPECT_EQ(consumer.result(), 45u);
+}
+
+TEST(ChannelTest, CloseFailsTheProducersAndDrainsTheConsumers) {
+  async_channel<size_t> channel{2};
+  auto producer = produce_values(channel, 1, 10, false);
+  producer.start();
+  EXPECT_FALSE(producer.done());
+  channel.close();
+  ASSERT_TRUE(producer.done());
+  EXPECT_EQ(producer.result(), 2u);
+  EXPECT_FALSE(channel.try_send(size_t{42}));
+  // The values that were sent before `close()` are still received.
+  auto consumer = sum_values(channel);
+  consumer.start();
+  ASSERT_TRUE(consumer.done());
+  EXPECT_EQ(consumer.result(), 3u);
+  EXPECT_FALSE(channel.try_recv());
+}
+
+TEST(ChannelTest, ManyProducersAndConsumersOnManyThreads) {
+  constexpr size_t numProducers = 4;
+  constexpr size_t numConsumers = 4;
+  constexpr size_t perProducer = 5000;
+  async_channel<size_t> channel{16};
+  std::vector<task<size_t, stackless_coroutine_handle>> producers;
+  std::vector<task<size_t, stackless_coroutine_handle>> consumers;
+  for (size_t i = 0; i < numProducers; ++i) {
+    producers.push_back(produce_values(channel, i * perProducer, (i + 1) * perProducer, false));
+  }
+  for (size_t i = 0; i < numConsumers; ++i) {
+    consumers.push_back(sum_values(channel));
+  }
+  // The waiters are resumed by whichever thread matches them, before its `start()` returns.
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < numProducers; ++i) {
+    threads.emplace_back([&consumers, &producers, i] {
+      consumers[i].start();
+      producers[i].start();
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& p : producers) {
+    ASSERT_TRUE(p.done());
+    EXPECT_EQ(p.result(), perProducer);
+  }
+  channel.close();
+  size_t sum = 0;
+  for (auto& c : consumers) {
+    ASSERT_TRUE(c.done());
+    sum += c.result();
+  }
+  const size_t n = numProducers * perProducer;
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+}
+
+TEST(ChannelTest, RecvBlockingWaitsForAnotherThread) {
+  async_channel<size_t> channel{2};
+  auto producer = produce_values(channel, 0, 100, true);
+  std::thread thread{[&producer] { producer.start(); }};
+  size_t sum = 0;
+  while (std::optional<size_t> value = channel.recv_blocking()) {
+    sum += *value;
+  }
+  thread.join();
+  ASSERT_TRUE(producer.done());
+  EXPECT_EQ(sum, 4950u);
+}
+
+// ============================================================================
+// ParkerTest / SyncWaitTest - Blocking a thread until a task is done
+// ============================================================================
+
+TEST(ParkerTest, UnparkBeforeParkDoesNotBlock) {
+  coro_detail::parker parker;
+  parker.unpark();
+  parker.park();
+}
+
+TEST(ParkerTest, SleepingThreadIsWokenUp) {
+  coro_detail::parker parker;
+  size_t value = 0;
+  std::thread thread{[&] {
+    // Long enough for the parked thread to stop spinning and sleep on the futex.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    value = 42;
+    parker.unpark();
+  }};
+  parker.park();
+  EXPECT_EQ(value, 42u);
+  thread.join();
+}
+
+TEST(SyncWaitTest, SynchronousTask) {
+  EXPECT_EQ(sync_wait(compute_value(21)), 42u);
+  EXPECT_EQ(sync_wait(add_values(1, 2)), 6u);
+}
+
+TEST(SyncWaitTest, TaskThatCompletesOnThePool) {
+  thread_pool pool{4};
+  EXPECT_EQ(sync_wait(scheduled_compute_value(pool, 21)), 42u);
+  for (size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(sync_wait(scheduled_sum(pool, 0, i % 10)), (i % 10) * (i % 10 - 1));
+  }
+}
+
+TEST(SyncWaitTest, ExceptionsAreRethrown) {
+  EXPECT_THROW(sync_wait(checked_compute_value(3, 3)), std::runtime_error);
+  thread_pool pool{2};
+  std::vector<task<size_t, stackless_coroutine_handle>> tasks;
+  tasks.push_back(checked_compute_value(1, 2));
+  tasks.push_back(checked_compute_value(2, 2));
+  EXPECT_THROW(sync_wait(await_result(when_all_on(pool, std::move(tasks)))), std::runtime_error);
+}
+
+TEST(SyncWaitTest, WaitsForAnotherThread) {
+  async_latch latch{1};
+  std::thread thread{[&latch] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    latch.count_down();
+  }};
+  // The task is resumed (and completed) by `count_down()` on the other thread.
+  EXPECT_EQ(sync_wait(latched_compute_value(latch, 5)), 10u);
+  thread.join();
+}
+
+TEST(SyncWaitTest, ManyWaitingThreads) {
+  thread_pool pool{2};
+  std::vector<std::thread> threads;
+  std::atomic<size_t> sum{0};
+  for (size_t t = 0; t < 8; ++t) {
+    threads.emplace_back([&pool, &sum, t] {
+      for (size_t i = 0; i < 100; ++i) {
+        sum.fetch_add(sync_wait(scheduled_compute_value(pool, t * 100 + i)));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(sum.load(), 799u * 800u);
+}
@@ -0,0 +1,197 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_THREAD_POOL_H
+#define GENERATOR_REWRITE_EXAMPLES_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util/chase_lev_deque.h"
+#include "util/coroutine_handle.h"
+
+// A work-stealing scheduler for stackless coroutines (e.g. `task<T, stackless_coroutine_handle>`).
+// A coroutine moves itself onto the pool via
+//   co_await pool.schedule();
+// and is then resumed by one of the worker threads.
+//
+// Each worker has a Chase-Lev deque (see `util/chase_lev_deque.h`). Coroutines that are scheduled
+// from a worker are pushed to the bottom of its own deque and popped from there (LIFO, which keeps
+// the caches warm), idle workers steal from the top of the other deques. Coroutines that are
+// scheduled from other threads go to a global injection queue. Workers without any work sleep on a
+// condition variable.
+//
+// Handoff of the coroutine state between threads: everything that a coroutine wrote before it was
+// scheduled (its locals, and in particular the `continuation_` of a `task` that an outer task
+// stored in `task_awaiter::await_suspend`) happens-before it is resumed on the worker, as the push
+// is a release and the pop/steal is an acquire operation. A `task` whose inner task hops onto the
+// pool is thus safely continued by the worker that completes the inner task.
+class thread_pool {
+ public:
+  explicit thread_pool(size_t numThreads = std::max(1u, std::thread::hardware_concurrency())) {
+    workers_.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+      workers_.push_back(std::make_unique<worker>());
+    }
+    for (size_t i = 0; i < numThreads; ++i) {
+      workers_[i]->thread_ = std::thread([this, i] { run(i); });
+    }
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  // Runs all the coroutines that are already scheduled, then joins the workers. Coroutines must not
+  // be scheduled after the destruction has started.
+  ~thread_pool() {
+    {
+      std::lock_guard lock{mutex_};
+      stopped_ = true;
+    }
+    wakeup_.notify_all();
+    for (auto& w : workers_) {
+      w->thread_.join();
+    }
+  }
+
+  size_t size() const noexcept { return workers_.size(); }
+
+  // Awaiter for `co_await pool.schedule()`.
+  struct schedule_awaiter {
+    thread_pool& pool_;
+
+    static constexpr bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    void await_suspend(stackless_coroutine_handle<Promise> h) {
+      pool_.enqueue(stackless_coroutine_handle<void>{h.ptr});
+    }
+
+    static constexpr void await_resume() noexcept {}
+  };
+
+  schedule_awaiter schedule() noexcept { return schedule_awaiter{*this}; }
+
+  // Resume `h` on one of the workers. `h` must not be accessed by the calling thread afterwards.
+  void enqueue(stackless_coroutine_handle<void> h) {
+    active_.fetch_add(1, std::memory_order_relaxed);
+    if (current_pool_ == this) {
+      workers_[current_index_]->deque_.push(h.ptr);
+    } else {
+      std::lock_guard lock{injection_mutex_};
+      injection_.push_back(h.ptr);
+    }
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard lock{mutex_};
+      wakeup_.notify_one();
+    }
+  }
+
+  // Block until all the scheduled coroutines have run and suspended (or finished) without
+  // scheduling themselves again.
+  void wait_idle() {
+    std::unique_lock lock{idle_mutex_};
+    idle_.wait(lock, [this] { return active_.load(std::memory_order_acquire) == 0; });
+  }
+
+  // The index of the worker that runs the calling thread, or `size()` if the calling thread is not
+  // a worker of this pool.
+  size_t current_worker() const noexcept {
+    return current_pool_ == this ? current_index_ : workers_.size();
+  }
+
+ private:
+  struct worker {
+    coro_detail::chase_lev_deque<HandleFrame> deque_;
+    std::thread thread_;
+  };
+
+  HandleFrame* findWork(size_t index, uint64_t& rng) {
+    if (HandleFrame* h = workers_[index]->deque_.pop()) {
+      return h;
+    }
+    if (queued_.load(std::memory_order_relaxed) == 0) {
+      return nullptr;
+    }
+    {
+      std::lock_guard lock{injection_mutex_};
+      if (!injection_.empty()) {
+        HandleFrame* h = injection_.front();
+        injection_.pop_front();
+        return h;
+      }
+    }
+    // Steal, starting at a random victim (xorshift).
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    const size_t n = workers_.size();
+    for (size_t i = 0, start = rng % n; i < n; ++i) {
+      size_t victim = (start + i) % n;
+      if (victim == index) {
+        continue;
+      }
+      if (HandleFrame* h = workers_[victim]->deque_.steal()) {
+        return h;
+      }
+    }
+    return nullptr;
+  }
+
+  void run(size_t index) {
+    current_pool_ = this;
+    current_index_ = index;
+    uint64_t rng = 0x9E3779B97F4A7C15ull * (index + 1);
+    while (true) {
+      if (HandleFrame* h = findWork(index, rng)) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        stackless_coroutine_handle<void>{h}.resume();
+        if (active_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          std::lock_guard lock{idle_mutex_};
+          idle_.notify_all();
+        }
+        continue;
+      }
+      std::unique_lock lock{mutex_};
+      sleeping_.fetch_add(1, std::memory_order_seq_cst);
+      // `queued_` can be positive while the last item is being stolen by another worker, then we
+      // retry the `findWork()` right away.
+      wakeup_.wait(lock, [this] {
+        return stopped_ || queued_.load(std::memory_order_seq_cst) > 0;
+      });
+      sleeping_.fetch_sub(1, std::memory_order_relaxed);
+      if (stopped_ && queued_.load(std::memory_order_seq_cst) == 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<worker>> workers_;
+
+  std::mutex injection_mutex_;
+  std::deque<HandleFrame*> injection_;
+
+  // The number of coroutines in all the queues.
+  std::atomic<size_t> queued_{0};
+  // The number of coroutines that are queued or running.
+  std::atomic<size_t> active_{0};
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::atomic<size_t> sleeping_{0};
+  bool stopped_ = false;
+
+  std::mutex idle_mutex_;
+  std::condition_variable idle_;
+
+  static inline thread_local thread_pool* current_pool_ = nullptr;
+  static inline thread_local size_t current_index_ = 0;
+};
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_THREAD_POOL_H
@@ -0,0 +1,130 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_THREAD_POOL_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_THREAD_POOL_EXAMPLE_H
+
+#include <cstddef>
+
+#include "task/task.h"
+#include "task/thread_pool.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> scheduled_compute_value(thread_pool& pool, size_t x) {
+ *     co_await pool.schedule();
+ *     co_return x * 2;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> scheduled_compute_value(thread_pool& pool,
+                                                                        size_t x) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    thread_pool& pool_;
+    size_t x_;
+
+    coro_storage<thread_pool::schedule_awaiter&, true> schedule_awaiter_;
+
+    CoroFrame(thread_pool& pool, size_t x) : pool_(pool), x_(x) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, schedule_awaiter_, this->pool_.schedule());
+      CO_RETURN_VALUE(2, final_awaiter_, (this->x_ * 2));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->schedule_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(pool, x);
+}
+
+/**
+ * A chain of tasks that hops onto the pool at every step. Each inner task can be stolen by another
+ * worker, which then also continues the outer task. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> scheduled_sum(thread_pool& pool, size_t a, size_t b) {
+ *     co_await pool.schedule();
+ *     size_t sum = 0;
+ *     for (size_t i = a; i < b; ++i) sum += co_await scheduled_compute_value(pool, i);
+ *     co_return sum;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> scheduled_sum(thread_pool& pool, size_t a,
+                                                              size_t b) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  using inner_task = task<size_t, stackless_coroutine_handle>;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    thread_pool& pool_;
+    size_t i_;
+    size_t end_;
+    size_t sum_ = 0;
+    size_t value_;
+
+    coro_storage<thread_pool::schedule_awaiter&, true> schedule_awaiter_;
+    coro_storage<inner_task&, true> task_storage_;
+    coro_storage<detail::task_awaiter<size_t, stackless_coroutine_handle>&, true> awaiter_storage_;
+
+    CoroFrame(thread_pool& pool, size_t a, size_t b) : pool_(pool), i_(a), end_(b) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+        case 2:
+          goto label_2;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, schedule_awaiter_, this->pool_.schedule());
+      for (; this->i_ < this->end_; ++this->i_) {
+        CO_INIT(task_storage_, (scheduled_compute_value(this->pool_, this->i_)));
+        CO_AWAIT(2, awaiter_storage_, CO_GET(task_storage_), this->value_ =);
+        this->task_storage_.destroy();
+        this->sum_ += this->value_;
+      }
+      CO_RETURN_VALUE(3, final_awaiter_, (this->sum_));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->schedule_awaiter_.destroy();
+          return;
+        case 2:
+          this->awaiter_storage_.destroy();
+          this->task_storage_.destroy();
+          return;
+        case 3:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(pool, a, b);
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_THREAD_POOL_EXAMPLE_H
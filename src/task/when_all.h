@@ -0,0 +1,363 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_WHEN_ALL_H
+#define GENERATOR_REWRITE_EXAMPLES_WHEN_ALL_H
+
+// `when_all` and `when_any` for `task`s. The returned objects are awaiters, e.g.
+//   auto [a, b] = co_await when_all(compute_value(1), compute_value(2));
+//   std::vector<size_t> values = co_await when_all(std::move(vectorOfTasks));
+//   auto [index, value] = co_await when_any(std::move(vectorOfTasks));
+//
+// All the children are started before the awaiting coroutine (the parent) suspends. `when_all`
+// resumes the parent once all the children are done, `when_any` once the first child is done. The
+// children are started on the thread of the parent, so they run concurrently as soon as they hop
+// onto a scheduler (e.g. via `co_await pool.schedule()`). The `when_all_on(scheduler, ...)` and
+// `when_any_on(scheduler, ...)` variants instead hand every child to `scheduler.enqueue()` (see
+// `task/thread_pool.h`), which is what makes CPU-bound children run in parallel.
+//
+// The continuation of each child is a `completion_frame` inside the awaiter (or the shared state
+// of `when_any`), which is not a coroutine but a `HandleFrame` whose `resumeFunc` counts the
+// completion. The child's final awaiter transfers control to it, and it transfers control to the
+// parent if it completes the count, so the parent is resumed exactly once by whoever finishes last
+// (or first, for `when_any`). The parent holds one extra count while it starts the children, so a
+// child that completes synchronously never resumes the parent before it has suspended.
+//
+// The fixed-arity `when_all` stores the tasks and the results inline (no allocations), the range
+// form returns a `std::vector`. `when_any` allocates its shared state, as the remaining children
+// may still be running after the parent has been resumed and has destroyed the awaiter. They are
+// destroyed by the last one to finish. An exception of a child is rethrown by `await_resume()`.
+//
+// All the tasks have to be unstarted, and the awaiters must not be moved after they were awaited.
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "task/task.h"
+#include "util/coroutine_handle.h"
+
+namespace detail {
+// Resumes the children inline on the thread of the awaiting coroutine.
+struct inline_starter {
+  void operator()(stackless_coroutine_handle<void> child) const { child.resume(); }
+};
+
+// Hands the children to a `Scheduler` with a member function `enqueue(handle)`.
+template <typename Scheduler>
+struct scheduler_starter {
+  Scheduler* scheduler_;
+
+  void operator()(stackless_coroutine_handle<void> child) const { scheduler_->enqueue(child); }
+};
+
+// A `HandleFrame` that is used as the `continuation_` of a child task. Resuming it calls
+// `owner_->on_child_done(index_)`, which returns the handle to transfer control to next.
+template <typename Owner>
+struct completion_frame {
+  HandleFrame frame_{&completion_frame::resume, &completion_frame::destroy};
+  Owner* owner_ = nullptr;
+  size_t index_ = 0;
+
+  stackless_coroutine_handle<void> handle() noexcept {
+    return stackless_coroutine_handle<void>{&frame_};
+  }
+
+  static stackless_coroutine_handle<void> resume(void* frame) {
+    auto* self = reinterpret_cast<completion_frame*>(frame);
+    return self->owner_->on_child_done(self->index_);
+  }
+
+  static void destroy(void*) {}
+};
+
+template <typename T>
+struct is_task : std::false_type {};
+
+template <typename T, template <typename...> typename H>
+struct is_task<task<T, H>> : std::true_type {};
+
+template <typename Task>
+using task_value_t = std::remove_reference_t<decltype(std::declval<Task&>().result())>;
+
+// The result type of a child in `when_all` and `when_any`, `std::monostate` for `task<void>`.
+template <typename Task>
+using when_all_value_t =
+    std::conditional_t<std::is_void_v<task_value_t<Task>>, std::monostate, task_value_t<Task>>;
+
+template <typename Task>
+when_all_value_t<Task> take_result(Task& t) {
+  if constexpr (std::is_void_v<task_value_t<Task>>) {
+    t.result();
+    return {};
+  } else {
+    return std::move(t.result());
+  }
+}
+
+// Set the continuation of the (unstarted) `child` and start it.
+template <typename Starter, typename Task, typename Owner>
+void start_child(const Starter& starter, Task& child, completion_frame<Owner>& completion) {
+  auto h = child.handle();
+  h.promise().continuation_ = completion.handle();
+  starter(stackless_coroutine_handle<void>{h.ptr});
+}
+
+// The counting part of `when_all`, shared by the fixed-arity and the range form.
+class when_all_counter {
+ protected:
+  // Start with one count per child plus one for the parent, which arrives after all the children
+  // were started.
+  void reset(size_t numChildren, stackless_coroutine_handle<void> parent) noexcept {
+    parent_ = parent;
+    count_.store(numChildren + 1, std::memory_order_relaxed);
+  }
+
+  // Returns true for the last arrival. Synchronizes the results of all the children with the last
+  // arrival.
+  bool arrive() noexcept { return count_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+ public:
+  stackless_coroutine_handle<void> on_child_done(size_t) noexcept {
+    return arrive() ? parent_ : stackless_coroutine_handle<void>{};
+  }
+
+ protected:
+  std::atomic<size_t> count_{0};
+  stackless_coroutine_handle<void> parent_;
+};
+
+template <typename Starter, typename... Tasks>
+class when_all_awaiter : public when_all_counter {
+ public:
+  using result_type = std::tuple<when_all_value_t<Tasks>...>;
+
+  when_all_awaiter(Starter starter, Tasks&&... tasks)
+      : starter_(std::move(starter)), tasks_(std::move(tasks)...) {}
+
+  // Only valid before the awaiter was awaited.
+  when_all_awaiter(when_all_awaiter&& other) noexcept
+      : starter_(std::move(other.starter_)), tasks_(std::move(other.tasks_)) {}
+
+  bool await_ready() const noexcept { return sizeof...(Tasks) == 0; }
+
+  // Returns false (don't suspend) if all the children completed synchronously.
+  template <typename Promise>
+  bool await_suspend(stackless_coroutine_handle<Promise> parent) {
+    reset(sizeof...(Tasks), stackless_coroutine_handle<void>{parent.ptr});
+    completion_.owner_ = this;
+    std::apply([this](auto&... child) { (start_child(starter_, child, completion_), ...); },
+               tasks_);
+    return !arrive();
+  }
+
+  result_type await_resume() {
+    return std::apply([](auto&... child) { return result_type{take_result(child)...}; }, tasks_);
+  }
+
+ private:
+  Starter starter_;
+  std::tuple<Tasks...> tasks_;
+  // All the children share the same completion frame.
+  completion_frame<when_all_counter> completion_;
+};
+
+template <typename Starter, typename Task>
+class when_all_range_awaiter : public when_all_counter {
+ public:
+  using value_type = when_all_value_t<Task>;
+
+  when_all_range_awaiter(Starter starter, std::vector<Task> tasks)
+      : starter_(std::move(starter)), tasks_(std::move(tasks)) {}
+
+  // Only valid before the awaiter was awaited.
+  when_all_range_awaiter(when_all_range_awaiter&& other) noexcept
+      : starter_(std::move(other.starter_)), tasks_(std::move(other.tasks_)) {}
+
+  bool await_ready() const noexcept { return tasks_.empty(); }
+
+  template <typename Promise>
+  bool await_suspend(stackless_coroutine_handle<Promise> parent) {
+    reset(tasks_.size(), stackless_coroutine_handle<void>{parent.ptr});
+    completion_.owner_ = this;
+    for (auto& child : tasks_) {
+      start_child(starter_, child, completion_);
+    }
+    return !arrive();
+  }
+
+  // `void` for `task<void>`s, a vector of the results otherwise.
+  auto await_resume() {
+    if constexpr (std::is_void_v<task_value_t<Task>>) {
+      for (auto& child : tasks_) {
+        child.result();
+      }
+    } else {
+      std::vector<value_type> results;
+      results.reserve(tasks_.size());
+      for (auto& child : tasks_) {
+        results.push_back(take_result(child));
+      }
+      return results;
+    }
+  }
+
+ private:
+  Starter starter_;
+  std::vector<Task> tasks_;
+  completion_frame<when_all_counter> completion_;
+};
+
+template <typename Task>
+struct when_any_result {
+  size_t index_;
+  when_all_value_t<Task> value_;
+};
+
+// The state of a `when_any`, which is shared between the parent and the children. Deleted by the
+// last of them.
+template <typename Task>
+class when_any_state {
+ public:
+  static constexpr size_t no_winner = std::numeric_limits<size_t>::max();
+
+  when_any_state(std::vector<Task> tasks, stackless_coroutine_handle<void> parent)
+      : tasks_(std::move(tasks)), completions_(tasks_.size()), parent_(parent) {
+    for (size_t i = 0; i < completions_.size(); ++i) {
+      completions_[i].owner_ = this;
+      completions_[i].index_ = i;
+    }
+  }
+
+  template <typename Starter>
+  void start(const Starter& starter) {
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+      start_child(starter, tasks_[i], completions_[i]);
+    }
+  }
+
+  stackless_coroutine_handle<void> on_child_done(size_t index) noexcept {
+    stackless_coroutine_handle<void> next;
+    size_t expected = no_winner;
+    if (winner_.compare_exchange_strong(expected, index, std::memory_order_acq_rel)) {
+      if (decide()) {
+        next = parent_;
+      }
+    }
+    release();
+    return next;
+  }
+
+  // Both the parent (once all the children were started) and the first child to finish call
+  // `decide()`, the second one resumes the parent.
+  bool decide() noexcept { return pending_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+  void release() noexcept {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  when_any_result<Task> take() {
+    size_t index = winner_.load(std::memory_order_acquire);
+    return {index, take_result(tasks_[index])};
+  }
+
+ private:
+  std::vector<Task> tasks_;
+  std::vector<completion_frame<when_any_state>> completions_;
+  stackless_coroutine_handle<void> parent_;
+  std::atomic<size_t> winner_{no_winner};
+  std::atomic<int> pending_{2};
+  // One reference per child plus one for the awaiter.
+  std::atomic<size_t> refs_{tasks_.size() + 1};
+};
+
+template <typename Starter, typename Task>
+class when_any_awaiter {
+ public:
+  when_any_awaiter(Starter starter, std::vector<Task> tasks)
+      : starter_(std::move(starter)), tasks_(std::move(tasks)) {
+    assert(!tasks_.empty() && "`when_any` needs at least one task");
+  }
+
+  // Only valid before the awaiter was awaited.
+  when_any_awaiter(when_any_awaiter&& other) noexcept
+      : starter_(std::move(other.starter_)), tasks_(std::move(other.tasks_)) {}
+
+  ~when_any_awaiter() {
+    if (state_) {
+      state_->release();
+    }
+  }
+
+  static constexpr bool await_ready() noexcept { return false; }
+
+  template <typename Promise>
+  bool await_suspend(stackless_coroutine_handle<Promise> parent) {
+    state_ = new when_any_state<Task>(std::move(tasks_),
+                                      stackless_coroutine_handle<void>{parent.ptr});
+    state_->start(starter_);
+    return !state_->decide();
+  }
+
+  when_any_result<Task> await_resume() { return state_->take(); }
+
+ private:
+  Starter starter_;
+  std::vector<Task> tasks_;
+  when_any_state<Task>* state_ = nullptr;
+};
+
+template <typename... Tasks>
+constexpr bool are_tasks_v = (is_task<Tasks>::value && ...);
+}  // namespace detail
+
+// The result of `when_any`: the index of the first child to finish, and its result.
+template <typename Task>
+using when_any_result = detail::when_any_result<Task>;
+
+// Await all of the `tasks`, the result is a tuple of their results. The tasks are taken by value,
+// so a task in a variable has to be moved in explicitly.
+template <typename... Tasks, std::enable_if_t<detail::are_tasks_v<Tasks...>, int> = 0>
+auto when_all(Tasks... tasks) {
+  return detail::when_all_awaiter<detail::inline_starter, Tasks...>{{}, std::move(tasks)...};
+}
+
+// Same as `when_all(tasks...)`, but the children are started via `scheduler.enqueue()`.
+template <typename Scheduler, typename... Tasks,
+          std::enable_if_t<detail::are_tasks_v<Tasks...>, int> = 0>
+auto when_all_on(Scheduler& scheduler, Tasks... tasks) {
+  return detail::when_all_awaiter<detail::scheduler_starter<Scheduler>, Tasks...>{
+      {&scheduler}, std::move(tasks)...};
+}
+
+// Await all of the `tasks`, the result is a vector of their results.
+template <typename Task>
+auto when_all(std::vector<Task> tasks) {
+  return detail::when_all_range_awaiter<detail::inline_starter, Task>{{}, std::move(tasks)};
+}
+
+template <typename Scheduler, typename Task>
+auto when_all_on(Scheduler& scheduler, std::vector<Task> tasks) {
+  return detail::when_all_range_awaiter<detail::scheduler_starter<Scheduler>, Task>{
+      {&scheduler}, std::move(tasks)};
+}
+
+// Await the first of the (non-empty) `tasks` to finish, the result contains its index and result.
+template <typename Task>
+auto when_any(std::vector<Task> tasks) {
+  return detail::when_any_awaiter<detail::inline_starter, Task>{{}, std::move(tasks)};
+}
+
+template <typename Scheduler, typename Task>
+auto when_any_on(Scheduler& scheduler, std::vector<Task> tasks) {
+  return detail::when_any_awaiter<detail::scheduler_starter<Scheduler>, Task>{
+      {&scheduler}, std::move(tasks)};
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_WHEN_ALL_H
@@ -0,0 +1,181 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_WHEN_ALL_EXAMPLE_H
+#define GENERATOR_REWRITE_EXAMPLES_WHEN_ALL_EXAMPLE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "task/task.h"
+#include "task/thread_pool.h"
+#include "task/thread_pool_example.h"
+#include "task/when_all.h"
+#include "util/coroutine_frame.h"
+#include "util/macros.h"
+
+/**
+ * Fans out two tasks onto the pool and joins them. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> scheduled_add_values(thread_pool& pool, size_t a,
+ *                                                                 size_t b) {
+ *     auto [x, y] = co_await when_all_on(pool, scheduled_compute_value(pool, a),
+ *                                        scheduled_compute_value(pool, b));
+ *     co_return x + y;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> scheduled_add_values(thread_pool& pool, size_t a,
+                                                                     size_t b) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  using inner_task = task<size_t, stackless_coroutine_handle>;
+  using all_awaiter =
+      detail::when_all_awaiter<detail::scheduler_starter<thread_pool>, inner_task, inner_task>;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, true> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, true>;
+    thread_pool& pool_;
+    size_t a_;
+    size_t b_;
+    std::tuple<size_t, size_t> values_;
+
+    coro_storage<all_awaiter&, true> all_awaiter_;
+
+    CoroFrame(thread_pool& pool, size_t a, size_t b) : pool_(pool), a_(a), b_(b) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, all_awaiter_,
+               when_all_on(this->pool_, scheduled_compute_value(this->pool_, this->a_),
+                           scheduled_compute_value(this->pool_, this->b_)),
+               this->values_ =);
+      CO_RETURN_VALUE(2, final_awaiter_,
+                      (std::get<0>(this->values_) + std::get<1>(this->values_)));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->all_awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+  };
+  return CoroFrame::ramp(pool, a, b);
+}
+
+/**
+ * A task that fails for one of its inputs. Manually lowered equivalent of:
+ *   task<size_t, stackless_coroutine_handle> checked_compute_value(size_t x, size_t failAt) {
+ *     if (x == failAt) throw std::runtime_error{"checked_compute_value failed"};
+ *     co_return x * 2;
+ *   }
+ */
+inline task<size_t, stackless_coroutine_handle> checked_compute_value(size_t x, size_t failAt) {
+  using promise_type = task<size_t, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    size_t x_;
+    size_t failAt_;
+
+    CoroFrame(size_t x, size_t failAt) : x_(x), failAt_(failAt) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      if (this->x_ == this->failAt_) {
+        throw std::runtime_error{"checked_compute_value failed"};
+      }
+      CO_RETURN_VALUE(1, final_awaiter_, (this->x_ * 2));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          return;
+      }
+    }
+
+    // No locals are alive where the exception is thrown.
+    ExceptionResult dispatchExceptionHandling() { return this->unhandled_exception(); }
+  };
+  return CoroFrame::ramp(x, failAt);
+}
+
+/**
+ * Awaits a single awaitable (e.g. the result of `when_all`) and returns its (non-void) result.
+ * Manually lowered equivalent of:
+ *   template <typename Awaitable>
+ *   task<R, stackless_coroutine_handle> await_result(Awaitable awaitable) {
+ *     co_return co_await std::move(awaitable);
+ *   }
+ */
+template <typename Awaitable>
+auto await_result(Awaitable awaitable) {
+  using result_type = decltype(std::declval<Awaitable&>().await_resume());
+  static_assert(!std::is_void_v<result_type>, "`await_result` needs a non-void result");
+  using promise_type = typename task<result_type, stackless_coroutine_handle>::promise_type;
+  struct CoroFrame : stackless_coro_crtp<CoroFrame, promise_type, false> {
+    using CoroFrameBase = stackless_coro_crtp<CoroFrame, promise_type, false>;
+    Awaitable awaitable_;
+
+    coro_storage<Awaitable&, true> awaiter_;
+
+    CoroFrame(Awaitable&& awaitable) : awaitable_(std::move(awaitable)) {}
+
+    stackless_coroutine_handle<void> doStepImpl() {
+      switch (this->suspendIdx_) {
+        case 0:
+          break;
+        case 1:
+          goto label_1;
+      }
+
+      CO_GET(initial_awaiter_).await_resume();
+      this->initial_awaiter_.destroy();
+      CO_AWAIT(1, awaiter_, std::move(this->awaitable_), result_type result =);
+      CO_RETURN_VALUE(2, final_awaiter_, (std::move(result)));
+    }
+
+    void destroySuspendedCoro(size_t suspendIdx_) {
+      switch (suspendIdx_) {
+        case 0:
+          this->initial_awaiter_.destroy();
+          return;
+        case 1:
+          this->awaiter_.destroy();
+          return;
+        case 2:
+          return;
+      }
+    }
+
+    // Exceptions of the children are rethrown by `await_resume()`, before the awaiter is
+    // destroyed.
+    ExceptionResult dispatchExceptionHandling() {
+      this->awaiter_.destroy();
+      return this->unhandled_exception();
+    }
+  };
+  return CoroFrame::ramp(std::move(awaitable));
+}
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_WHEN_ALL_EXAMPLE_H
@@ -0,0 +1,23 @@
+#include "util/allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Atomic, because some benchmarks allocate on a thread pool or on producer threads. No ordering
+// with other memory is needed for a counter, so the increments are relaxed.
+static std::atomic<size_t> allocationCount{0};
+
+size_t numAllocations() { return allocationCount.load(std::memory_order_relaxed); }
+
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
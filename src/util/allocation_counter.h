@@ -0,0 +1,13 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_ALLOCATION_COUNTER_H
+#define GENERATOR_REWRITE_EXAMPLES_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// The number of calls to the global `operator new` so far, s.t. benchmarks can report the number of
+// heap allocations. The counting replacements of the global `operator new` and `operator delete`
+// are defined in `allocation_counter.cpp`, which has to be linked into the benchmark. They live in
+// their own translation unit, so that they are never inlined into the call sites of `new` and
+// `delete`.
+size_t numAllocations();
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_ALLOCATION_COUNTER_H
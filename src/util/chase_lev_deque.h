@@ -0,0 +1,129 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_CHASE_LEV_DEQUE_H
+#define GENERATOR_REWRITE_EXAMPLES_CHASE_LEV_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "util/spsc_ring.h"
+
+namespace coro_detail {
+// The lock-free work-stealing deque of Chase and Lev ("Dynamic Circular Work-Stealing Deque",
+// SPAA 2005), with the memory orderings of Lê et al. ("Correct and Efficient Work-Stealing for Weak
+// Memory Models", PPoPP 2013). Stores pointers to `T`, `nullptr` means "empty".
+//
+// The owner thread pushes and pops at the bottom (LIFO), any other thread may steal from the top
+// (FIFO). The buffer grows when it is full. Old buffers are kept until the deque is destroyed, as
+// thieves might still read from them.
+template <typename T>
+class chase_lev_deque {
+ public:
+  explicit chase_lev_deque(size_t capacity = 256) {
+    size_t cap = 1;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    buffers_.push_back(std::make_unique<buffer>(cap));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  chase_lev_deque(const chase_lev_deque&) = delete;
+  chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+  // Owner only.
+  void push(T* item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    buffer* buf = buffer_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(buf->mask_)) {
+      buf = grow(buf, t, b);
+    }
+    buf->put(b, item);
+    // Publishes the item (and everything that the owner wrote before) to the thieves.
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only: the most recently pushed item, or `nullptr` if the deque is empty.
+  T* pop() {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    buffer* buf = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T* item = buf->get(b);
+    if (t == b) {
+      // The last item, race against the thieves.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread: the least recently pushed item, or `nullptr` if the deque is empty or the steal
+  // lost a race against the owner or another thief.
+  T* steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    T* item = buffer_.load(std::memory_order_acquire)->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  // Only a snapshot if other threads are active.
+  bool empty() const noexcept {
+    return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct buffer {
+    explicit buffer(size_t capacity)
+        : mask_(capacity - 1), slots_(new std::atomic<T*>[capacity]) {}
+
+    T* get(int64_t i) const noexcept {
+      return slots_[static_cast<size_t>(i) & mask_].load(std::memory_order_relaxed);
+    }
+    void put(int64_t i, T* item) noexcept {
+      slots_[static_cast<size_t>(i) & mask_].store(item, std::memory_order_relaxed);
+    }
+
+    const size_t mask_;
+    std::unique_ptr<std::atomic<T*>[]> slots_;
+  };
+
+  buffer* grow(buffer* old, int64_t t, int64_t b) {
+    buffers_.push_back(std::make_unique<buffer>(2 * (old->mask_ + 1)));
+    buffer* bigger = buffers_.back().get();
+    for (int64_t i = t; i < b; ++i) {
+      bigger->put(i, old->get(i));
+    }
+    buffer_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  // Written by the thieves (and by the owner for the last item).
+  alignas(cache_line_size) std::atomic<int64_t> top_{0};
+  // Written by the owner.
+  alignas(cache_line_size) std::atomic<int64_t> bottom_{0};
+  std::atomic<buffer*> buffer_{nullptr};
+  // All the buffers, including the current one. Only modified by the owner.
+  std::vector<std::unique_ptr<buffer>> buffers_;
+};
+}  // namespace coro_detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_CHASE_LEV_DEQUE_H
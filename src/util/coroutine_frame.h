@@ -3,7 +3,10 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <cstddef>
 #include <cstdint>
+#include <new>
+#include <utility>
 
 #include "./coro_storage.h"
 #include "./coroutine_handle.h"
@@ -57,11 +60,12 @@ struct stackless_coro_crtp
     static constexpr size_t CO_NO_TRY_BLOCK = static_cast<size_t>(-1);
     size_t currentTryBlock_ = CO_NO_TRY_BLOCK;
 
-    // Buffers for the `initial_suspend()` and `final_suspend()` awaiters.
+    // Buffers for the `initial_suspend()` and `final_suspend()` awaiters. They are value-initialized,
+    // as they are copied when a frame is relocated (see `relocate()` below), also while they are empty.
     [[no_unique_address]] coro_storage<decltype(std::declval<PromiseType&>().initial_suspend())&,
-                                       true> initial_awaiter_;
+                                       true> initial_awaiter_{};
     [[no_unique_address]] coro_storage<decltype(std::declval<PromiseType&>().final_suspend())&, true>
-    final_awaiter_;
+    final_awaiter_{};
 
     using handle_type = stackless_coroutine_handle<PromiseType>;
 
@@ -138,11 +142,42 @@ struct stackless_coro_crtp
         return {{}, true};
     }
 
+    // Type erased `destroy` function for frames that were constructed inside a buffer that is owned
+    // by somebody else (see `ramp_in_buffer()` below). `deleteFrame()` doesn't free the memory of
+    // such frames.
+    static void destroyInBuffer(void* blubb)
+    {
+        auto* self = fromHandle(blubb);
+        self->destroy();
+    }
+
+    // Type erased relocation for frames inside a buffer. Only used for frames that opt in via
+    // `is_relocatable` (see `ramp_in_buffer()` below). Pointers in the promise that point into the
+    // old frame (e.g. to the current value or batch) are moved to the new frame.
+    static HandleFrame* relocate(HandleFrame* from, void* to)
+    {
+        auto* source = fromHandle(from);
+        auto* target = new(to) Derived(std::move(*source));
+        if constexpr (coro_detail::has_rebase<PromiseType>::value)
+        {
+            target->promise().rebase(source, target, sizeof(Derived));
+        }
+        source->~Derived();
+        return &target->frame_;
+    }
+
+    bool isInBuffer() const { return frame_.destroyFunc == &stackless_coro_crtp::destroyInBuffer; }
+
     void deleteFrame()
     {
         // Destroy and delete the `Derived` object itself (it was allocated on the heap via the `ramp()`
-        // below.
+        // below. Frames inside a buffer are only destroyed, the buffer belongs to somebody else.
+        const bool inBuffer = isInBuffer();
         derived().~Derived();
+        if (inBuffer)
+        {
+            return;
+        }
         if constexpr (coro_detail::has_promise_delete<PromiseType>::value)
         {
             PromiseType::operator delete(static_cast<void*>(this), sizeof(Derived));
@@ -153,7 +188,9 @@ struct stackless_coro_crtp
         }
         else
         {
-            delete this;
+            // The frame was allocated with the global `operator new(sizeof(Derived))` by
+            // `promise_allocate`, and `Derived` was already destroyed above.
+            ::operator delete(static_cast<void*>(this), sizeof(Derived));
         }
     }
 
@@ -223,14 +260,25 @@ struct stackless_coro_crtp
         }
     }
 
+    // Allocate the memory for a frame on the heap. Neither the `operator new` of the promise nor the
+    // global one get the alignment of the frame, so frames that need more than the default alignment
+    // are rejected (members like that have to be allocated separately).
+    template <typename... CoroArgs>
+    static void* allocateFrame(CoroArgs&&... coroArgs)
+    {
+        static_assert(alignof(Derived) <= alignof(std::max_align_t),
+                      "Heap frames can't be over-aligned");
+        return coro_detail::promise_allocate<PromiseType>(sizeof(Derived),
+                                                          std::forward<CoroArgs>(coroArgs)...);
+    }
+
     // The coroutine `ramp` function. Gets the arguments to the coroutine, and returns the coroutine
     // object via `get_return_object`.
     template <typename... CoroArgs>
     static auto ramp(CoroArgs&&... coroArgs)
     {
         // Allocate space for the frame, and placement new into it.
-        void* coroMem = coro_detail::promise_allocate<PromiseType>(sizeof(Derived),
-                                                                   std::forward<CoroArgs>(coroArgs)...);
+        void* coroMem = allocateFrame(std::forward<CoroArgs>(coroArgs)...);
         auto* frame = new(coroMem) Derived{std::forward<CoroArgs>(coroArgs)...};
         // `get_return_object()` result is temporarily stored on the stack.
         auto ret = frame->promise_.get_return_object();
@@ -245,6 +293,50 @@ struct stackless_coro_crtp
         return ret;
     }
 
+    // Alternative `ramp` function, that constructs the frame inside a buffer of the returned object
+    // if it fits, and falls back to the heap allocation of `ramp()` otherwise. As the frame is moved
+    // whenever the return object is moved, only frames that opt in via
+    //   using is_relocatable [[maybe_unused]] = std::true_type;
+    // are placed into the buffer, all others go to the heap. This promises that the move constructor
+    // of `Derived` moves all the locals that are alive at any suspension point. The implicit move
+    // constructor copies the `coro_storage`s bitwise, which is only correct for locals that don't
+    // point into the frame itself (e.g. no strings with a small buffer, no iterators into other
+    // locals), otherwise `Derived` has to define the move constructor. The `ReturnObject` has
+    // to be default-constructible and provide
+    //   `void* frame_buffer(size_t size, size_t alignment)`, which returns the buffer or `nullptr` if
+    //   the frame doesn't fit, and
+    //   `void adopt(handle_type, RelocateFrameFunc)`, where the relocation function is `nullptr` for
+    //   frames on the heap.
+    // Note: The `get_return_object()` of the promise is not used by this function.
+    template <typename ReturnObject, typename... CoroArgs>
+    static ReturnObject ramp_in_buffer(CoroArgs&&... coroArgs)
+    {
+        ReturnObject ret;
+        Derived* frame;
+        void* buffer = nullptr;
+        if constexpr (coro_detail::is_relocatable_frame<Derived>::value)
+        {
+            buffer = ret.frame_buffer(sizeof(Derived), alignof(Derived));
+        }
+        if (buffer)
+        {
+            frame = new(buffer) Derived{std::forward<CoroArgs>(coroArgs)...};
+            frame->frame_.destroyFunc = &stackless_coro_crtp::destroyInBuffer;
+            ret.adopt(frame->getHandle(), &stackless_coro_crtp::relocate);
+        }
+        else
+        {
+            void* coroMem = allocateFrame(std::forward<CoroArgs>(coroArgs)...);
+            frame = new(coroMem) Derived{std::forward<CoroArgs>(coroArgs)...};
+            ret.adopt(frame->getHandle(), nullptr);
+        }
+        CO_STORAGE_CONSTRUCT(frame->initial_awaiter_, (frame->promise_.initial_suspend()));
+        auto handle = frame->getHandle();
+        CO_AWAIT_IMPL_IMPL(frame->initial_awaiter_.get().ref_, handle, ret);
+        handle.resume();
+        return ret;
+    }
+
     // Function that is called when exception is thrown inside the `doStep()/resume()` function.
     // Returns ExceptionResult: the handle for symmetric transfer and whether the frame was destroyed.
     ExceptionResult handleException()
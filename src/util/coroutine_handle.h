@@ -2,6 +2,8 @@
 #define GENERATOR_REWRITE_EXAMPLES_COROUTINE_HANDLE_H
 
 #include <cstddef>
+#include <type_traits>
+#include <utility>
 
 // Forward declarations needed for HandleFrame's resumeFunc return type.
 template <typename Promise>
@@ -19,6 +21,11 @@ struct HandleFrame {
   void (*destroyFunc)(void*);
 };
 
+// Move a suspended frame from the `HandleFrame` at `from` into the (uninitialized) memory at `to`,
+// and return the `HandleFrame` of the new frame. Used for frames that are stored inside the buffer
+// of their owner (see `SmallBufferGeneratorPolicy`), which have to move together with the owner.
+using RelocateFrameFunc = HandleFrame* (*)(HandleFrame* from, void* to);
+
 // Common base class for `stackless_coroutine_handle<void>`  and
 // stackless_coroutine_handle<some_promise_type>` below.
 namespace detail {
@@ -105,6 +112,10 @@ inline stackless_coroutine_handle<void> noop_coroutine() {
   return stackless_coroutine_handle<void>{&noop_frame};
 }
 
+// Tag for copying the frame of a suspended stackful coroutine, see `rebaseCopy()`.
+struct clone_frame_t {};
+inline constexpr clone_frame_t clone_frame{};
+
 // A stackful coroutine handle that is templated on the frame of a certain coroutine and stores this
 // frame by value. Note: It is also possible to template this class on a reference-type, then only a
 // (still strongly typed) reference to the frame will be stored.
@@ -112,6 +123,7 @@ template <typename CoroFrame>
 struct stackful_coroutine_handle {
   CoroFrame frame;
   static constexpr bool isReference = std::is_reference_v<CoroFrame>;
+  using frame_type = std::remove_reference_t<CoroFrame>;
 
   template <bool b = true, std::enable_if_t<b && !isReference, int> = 0>
   explicit stackful_coroutine_handle(CoroFrame&& f) noexcept : frame(std::move(f)) {}
@@ -119,8 +131,20 @@ struct stackful_coroutine_handle {
   template <bool b = true, std::enable_if_t<b && isReference, int> = 0>
   explicit stackful_coroutine_handle(CoroFrame f) noexcept : frame(f) {}
 
+  // Construct the frame in place from the `args`.
+  template <typename... Args, bool b = true, std::enable_if_t<b && !isReference, int> = 0>
+  explicit stackful_coroutine_handle(std::in_place_t, Args&&... args)
+      : frame(std::forward<Args>(args)...) {}
+
   stackful_coroutine_handle(stackful_coroutine_handle&& other) = default;
 
+  // Copy the frame of `other` in place.
+  template <bool b = true, std::enable_if_t<b && !isReference, int> = 0>
+  stackful_coroutine_handle(clone_frame_t, const stackful_coroutine_handle& other)
+      : frame(other.frame) {
+    frame.rebaseCopy(other.frame);
+  }
+
   stackful_coroutine_handle& operator=(stackful_coroutine_handle&& other) noexcept = default;
 
   // Note: The destructor does not call ` frame.destroy()` , this is the responsibility
@@ -137,7 +161,7 @@ struct stackful_coroutine_handle {
   bool done() const { return frame.done(); }
   explicit constexpr operator bool() const { return true; }
   auto& promise() { return frame.promise(); }
-  const auto& promise() const { return frame.promise_; }
+  const auto& promise() const { return frame.promise(); }
 };
 
 #endif  // GENERATOR_REWRITE_EXAMPLES_COROUTINE_HANDLE_H
\ No newline at end of file
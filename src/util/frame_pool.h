@@ -0,0 +1,155 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_FRAME_POOL_H
+#define GENERATOR_REWRITE_EXAMPLES_FRAME_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "./type_traits.h"
+
+// A thread-local pool for coroutine frames. Frames are bucketed into size classes of
+// `granularity` bytes, and every thread keeps one singly linked freelist per size class.
+// Allocating a frame of a size that has recently been freed on the same thread is thus a pop from
+// a freelist instead of a call to `malloc`.
+//
+// The pool relies on the sized deallocation that `stackless_coro_crtp::deleteFrame()` performs
+// (`operator delete(ptr, sizeof(Derived))`), so no per-block header is needed.
+//
+// Frames that are freed on a different thread than the one that allocated them are simply adopted
+// by the freelist of the freeing thread. As every block originally comes from `::operator new`,
+// this is always safe. To bound the memory that piles up on threads that only consume frames (e.g.
+// in producer/consumer setups) each freelist holds at most `max_cached_per_class` blocks, surplus
+// blocks are returned to `::operator delete`.
+namespace coro_detail {
+class frame_pool {
+ public:
+  static constexpr size_t granularity = 16;
+  static constexpr size_t num_size_classes = 64;
+  // Frames that are larger than this are directly passed to the global `operator new`.
+  static constexpr size_t max_pooled_size = granularity * num_size_classes;
+  static constexpr uint32_t max_cached_per_class = 256;
+
+  static void* allocate(size_t size) {
+    if (size > max_pooled_size) {
+      return ::operator new(size);
+    }
+    auto& state = local_state();
+    size_t cls = size_class(size);
+    if (free_block* block = state.heads[cls]) {
+      state.heads[cls] = block->next;
+      --state.counts[cls];
+      return block;
+    }
+    return ::operator new(block_size(cls));
+  }
+
+  static void deallocate(void* ptr, size_t size) noexcept {
+    if (size > max_pooled_size) {
+      ::operator delete(ptr, size);
+      return;
+    }
+    auto& state = local_state();
+    size_t cls = size_class(size);
+    // After the thread-local cleanup has run (frames that are destroyed by other thread-local
+    // destructors), the blocks are directly freed.
+    if (state.counts[cls] >= max_cached_per_class || state.torn_down) {
+      ::operator delete(ptr, block_size(cls));
+      return;
+    }
+    if (!state.registered) {
+      register_cleanup();
+    }
+    auto* block = static_cast<free_block*>(ptr);
+    block->next = state.heads[cls];
+    state.heads[cls] = block;
+    ++state.counts[cls];
+  }
+
+  // The number of blocks that are currently cached for frames of the given `size` on the calling
+  // thread. Mostly useful for tests.
+  static size_t cached_blocks(size_t size) {
+    return size > max_pooled_size ? 0 : local_state().counts[size_class(size)];
+  }
+
+  // Return all the blocks that are cached on the calling thread to `::operator delete`.
+  static void release_thread_cache() noexcept {
+    auto& state = local_state();
+    for (size_t cls = 0; cls < num_size_classes; ++cls) {
+      while (free_block* block = state.heads[cls]) {
+        state.heads[cls] = block->next;
+        ::operator delete(block, block_size(cls));
+      }
+      state.counts[cls] = 0;
+    }
+  }
+
+ private:
+  struct free_block {
+    free_block* next;
+  };
+
+  // The per-thread state is trivially constructible and destructible, s.t. it can be accessed
+  // without any guard variables, and also after the `reaper` below has been destroyed.
+  struct thread_state {
+    free_block* heads[num_size_classes];
+    uint32_t counts[num_size_classes];
+    bool registered;
+    bool torn_down;
+  };
+
+  // Frees the cached blocks when a thread exits. It is only constructed (and registered for
+  // destruction) when the first block is cached on a thread.
+  struct reaper {
+    ~reaper() {
+      release_thread_cache();
+      local_state().torn_down = true;
+    }
+  };
+
+  static size_t size_class(size_t size) { return size == 0 ? 0 : (size - 1) / granularity; }
+
+  static size_t block_size(size_t cls) { return (cls + 1) * granularity; }
+
+  static thread_state& local_state() {
+    static thread_local thread_state state;
+    return state;
+  }
+
+  static void register_cleanup() {
+    static thread_local reaper r;
+    (void)r;
+    local_state().registered = true;
+  }
+};
+}  // namespace coro_detail
+
+// Opt-in wrapper for a promise type: Coroutines that use `pool_allocated<SomePromise>` as their
+// promise type allocate their frames from the `frame_pool` above via the `operator new/delete`
+// hooks that are detected by `coro_detail::promise_allocate` and `stackless_coro_crtp::deleteFrame`.
+// Apart from the allocation, the promise behaves exactly like `Promise`.
+//
+// The pool can't be combined with an explicit `std::allocator_arg, resource` (see
+// `resource_allocated` in `util/memory_resource_allocation.h`): the sized `operator delete` couldn't
+// tell the frames of the resource from the pooled ones. Instead of silently ignoring the resource,
+// passing one to a coroutine with a pooled promise doesn't compile.
+template <typename Promise>
+struct pool_allocated : Promise {
+  using Promise::Promise;
+
+  static void* operator new(size_t size) { return coro_detail::frame_pool::allocate(size); }
+
+  template <typename... Args>
+  static void* operator new(size_t, std::allocator_arg_t, Args&&...) {
+    static_assert(coro_detail::dependent_false<Args...>,
+                  "Frames with a `pool_allocated` promise can't be allocated from an explicit "
+                  "allocator or memory resource");
+    throw std::bad_alloc{};
+  }
+
+  static void operator delete(void* ptr, size_t size) noexcept {
+    coro_detail::frame_pool::deallocate(ptr, size);
+  }
+};
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_FRAME_POOL_H
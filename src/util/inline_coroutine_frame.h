@@ -5,6 +5,7 @@
 #include <stdexcept>
 
 #include "./coro_storage.h"
+#include "./coroutine_frame.h"
 #include "./coroutine_handle.h"
 #include "./macros.h"
 #include "./type_traits.h"
@@ -23,16 +24,18 @@ struct stackful_coro_crtp {
   static constexpr size_t CO_NO_TRY_BLOCK = static_cast<size_t>(-1);
   size_t currentTryBlock_ = CO_NO_TRY_BLOCK;
 
-  // Buffers for the `initial_suspend()` and `final_suspend()` awaiters.
+  // Buffers for the `initial_suspend()` and `final_suspend()` awaiters. Value-initialized, because
+  // `ramp()` moves the frame while they are not constructed.
   [[no_unique_address]] coro_storage<decltype(std::declval<PromiseType&>().initial_suspend())&,
-                                     true> initial_awaiter_;
+                                     true> initial_awaiter_{};
   [[no_unique_address]] coro_storage<decltype(std::declval<PromiseType&>().final_suspend())&, true>
-      final_awaiter_;
+      final_awaiter_{};
 
   using handle_type = stackful_coroutine_handle<Derived&>;
   handle_type getHandle() { return handle_type(derived()); }
 
   PromiseType& promise() { return promise_; }
+  const PromiseType& promise() const { return promise_; }
 
   bool done_ = false;
 
@@ -52,6 +55,22 @@ struct stackful_coro_crtp {
   }
 
   Derived& derived() { return *static_cast<Derived*>(this); }
+  const Derived& derived() const { return *static_cast<const Derived*>(this); }
+
+  // Frames can opt in to being cloned (see `unified_generator::clone()`) via
+  //   using is_cloneable [[maybe_unused]] = std::true_type;
+  // This promises that the copy constructor of `Derived` copies all the locals that are alive at
+  // any suspension point. The implicit copy constructor copies the `coro_storage`s bitwise, which
+  // is only correct if all the locals are trivially copyable, otherwise `Derived` has to define the
+  // copy constructor. Called on the copy right after it was constructed. Pointers in the promise
+  // that point into the frame of `other` (e.g. to the current value) are moved to the copy.
+  void rebaseCopy(const Derived& other) {
+    static_assert(coro_detail::is_cloneable_frame<Derived>::value,
+                  "The frame has to opt in to cloning via `is_cloneable`");
+    if constexpr (coro_detail::has_rebase<PromiseType>::value) {
+      promise_.rebase(&other, &derived(), sizeof(Derived));
+    }
+  }
 
   void doStep() noexcept(isNoexcept) {
     if constexpr (isNoexcept) {
@@ -114,4 +133,10 @@ struct stackful_coro_crtp {
   }
 };
 
+// Select the CRTP base class for a coroutine frame that can be instantiated both as a heap-allocated
+// (stackless) and as an inline (stackful) coroutine.
+template <bool isStackless, typename Frame, typename promise, bool isNoexcept>
+using FrameCRTP = std::conditional_t<isStackless, stackless_coro_crtp<Frame, promise, isNoexcept>,
+                                     stackful_coro_crtp<Frame, promise, isNoexcept>>;
+
 #endif  // GENERATOR_REWRITE_EXAMPLES_INLINE_COROUTINE_FRAME_H
\ No newline at end of file
@@ -24,7 +24,7 @@
         awaiter.await_suspend(handle);                                                             \
         return (stackless_coroutine_handle<void> {} __VA_OPT__(, std::move(__VA_ARGS__)));         \
       } else if constexpr (std::is_same_v<type, bool>) {                                           \
-        if (![&](auto& awaiter) {                                                                  \
+        if ([&](auto& awaiter) {                                                                   \
               if constexpr (std::is_same_v<type, bool>) return awaiter.await_suspend(handle);      \
               return true;                                                                         \
             }(awaiter)) {                                                                          \
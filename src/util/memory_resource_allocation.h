@@ -0,0 +1,62 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_MEMORY_RESOURCE_ALLOCATION_H
+#define GENERATOR_REWRITE_EXAMPLES_MEMORY_RESOURCE_ALLOCATION_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+// Opt-in wrapper for a promise type that implements the `std::allocator_arg` convention for
+// coroutine frames: If the first two arguments of a coroutine with a `resource_allocated<Promise>`
+// promise are `std::allocator_arg` and a `std::pmr::memory_resource*`, then the frame is allocated
+// from that resource (the detection of the `operator new` that takes the coroutine arguments is
+// done in `coro_detail::promise_allocate`). This allows a caller to place all the frames of e.g. a
+// request-scoped pipeline into a single `std::pmr::monotonic_buffer_resource`. Apart from the
+// allocation, the promise behaves exactly like `Promise`.
+//
+// As `operator delete` only gets the frame and its size, the resource is stored in a trailing slot
+// behind the frame. Frames that are allocated without a resource store a `nullptr` there and use
+// the global `operator new/delete`. Promises that are not wrapped don't pay for the slot.
+template <typename Promise>
+struct resource_allocated : Promise {
+  using Promise::Promise;
+
+  template <typename... Args>
+  static void* operator new(size_t size, std::allocator_arg_t,
+                            std::pmr::memory_resource* resource, Args&&...) {
+    void* ptr = resource->allocate(total_size(size), alignof(std::max_align_t));
+    resource_slot(ptr, size) = resource;
+    return ptr;
+  }
+
+  static void* operator new(size_t size) {
+    void* ptr = ::operator new(total_size(size));
+    resource_slot(ptr, size) = nullptr;
+    return ptr;
+  }
+
+  static void operator delete(void* ptr, size_t size) noexcept {
+    if (auto* resource = resource_slot(ptr, size)) {
+      resource->deallocate(ptr, total_size(size), alignof(std::max_align_t));
+    } else {
+      ::operator delete(ptr, total_size(size));
+    }
+  }
+
+ private:
+  static constexpr size_t slot_offset(size_t size) {
+    constexpr size_t align = alignof(std::pmr::memory_resource*);
+    return (size + align - 1) & ~(align - 1);
+  }
+
+  static constexpr size_t total_size(size_t size) {
+    return slot_offset(size) + sizeof(std::pmr::memory_resource*);
+  }
+
+  static std::pmr::memory_resource*& resource_slot(void* ptr, size_t size) {
+    return *reinterpret_cast<std::pmr::memory_resource**>(static_cast<char*>(ptr) +
+                                                          slot_offset(size));
+  }
+};
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_MEMORY_RESOURCE_ALLOCATION_H
@@ -0,0 +1,122 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_MPMC_RING_H
+#define GENERATOR_REWRITE_EXAMPLES_MPMC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "util/spsc_ring.h"
+
+namespace coro_detail {
+// A bounded, lock-free ring buffer for any number of producer and consumer threads (Dmitry Vyukov's
+// bounded MPMC queue). The capacity is rounded up to a power of two, and is at least 2.
+//
+// Each slot has a sequence number, which tells the producers and the consumers whose turn it is:
+// the slot of position `pos` is free for the producer of `pos` if the sequence is `pos`, and full
+// for the consumer of `pos` if it is `pos + 1`. A producer (consumer) claims a position with a CAS
+// on `tail_` (`head_`), so the only shared write per operation is that CAS plus the release store
+// of the slot's sequence.
+template <typename T>
+class mpmc_ring {
+ public:
+  explicit mpmc_ring(size_t capacity)
+      : mask_(round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+        slots_(new slot[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpmc_ring(const mpmc_ring&) = delete;
+  mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+  // Must only be called when no producer or consumer is active anymore.
+  ~mpmc_ring() {
+    while (try_pop([](T&&) {})) {
+    }
+  }
+
+  size_t capacity() const noexcept { return mask_ + 1; }
+
+  // The number of elements, which might already be outdated when it is returned.
+  size_t size_approx() const noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  // Construct an element from `args` at the end of the ring. Returns false (and doesn't touch the
+  // `args`) if the ring is full.
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      slot& s = slots_[pos & mask_];
+      const size_t sequence = s.sequence_.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          new (s.storage_) T(std::forward<Args>(args)...);
+          s.sequence_.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The slot still holds the element of the previous round.
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Pass the oldest element as an rvalue to `consume`, and remove it. Returns false if the ring is
+  // empty.
+  template <typename Consume>
+  bool try_pop(Consume&& consume) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      slot& s = slots_[pos & mask_];
+      const size_t sequence = s.sequence_.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          T* element = s.get();
+          consume(std::move(*element));
+          element->~T();
+          s.sequence_.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct slot {
+    std::atomic<size_t> sequence_;
+    alignas(T) unsigned char storage_[sizeof(T)];
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage_)); }
+  };
+
+  static size_t round_up_to_power_of_two(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  alignas(cache_line_size) std::atomic<size_t> head_{0};
+  alignas(cache_line_size) std::atomic<size_t> tail_{0};
+  alignas(cache_line_size) const size_t mask_;
+  std::unique_ptr<slot[]> slots_;
+};
+}  // namespace coro_detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_MPMC_RING_H
@@ -0,0 +1,80 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_PARKER_H
+#define GENERATOR_REWRITE_EXAMPLES_PARKER_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace coro_detail {
+// A one-shot event on which a single thread blocks (`park`) until another thread, or the same one
+// beforehand, calls `unpark`. The parked thread first spins for a short while, as the event often
+// arrives within microseconds (e.g. a task that hopped onto a thread pool), and then sleeps on a
+// futex. `unpark` only makes a system call if the parked thread actually sleeps.
+//
+// Unlike a mutex and a condition variable, `unpark` doesn't have to keep the parked thread from
+// returning (and destroying the parker) before it has finished: the `FUTEX_WAKE` only uses the
+// address, and a spurious wakeup of an unrelated futex that reuses the address is harmless.
+class parker {
+ public:
+  // The number of iterations of the spin loop before sleeping, roughly a few microseconds.
+  static constexpr unsigned spin_count = 100;
+
+  parker() noexcept = default;
+  parker(const parker&) = delete;
+  parker& operator=(const parker&) = delete;
+
+  void park() noexcept {
+    for (unsigned i = 0; i < spin_count; ++i) {
+      if (state_.load(std::memory_order_acquire) == notified) {
+        return;
+      }
+      cpu_relax();
+    }
+    uint32_t expected = empty;
+    if (!state_.compare_exchange_strong(expected, sleeping, std::memory_order_acquire)) {
+      // Notified in the meantime.
+      return;
+    }
+    // `FUTEX_WAIT` returns right away if the state is not `sleeping` anymore, and might wake up
+    // spuriously.
+    do {
+      ::syscall(SYS_futex, futex_word(), FUTEX_WAIT_PRIVATE, sleeping, nullptr, nullptr, 0);
+    } while (state_.load(std::memory_order_acquire) != notified);
+  }
+
+  // Everything that happens before `unpark` happens-before `park` returns.
+  void unpark() noexcept {
+    if (state_.exchange(notified, std::memory_order_release) == sleeping) {
+      ::syscall(SYS_futex, futex_word(), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+  }
+
+ private:
+  static constexpr uint32_t empty = 0;
+  static constexpr uint32_t notified = 1;
+  static constexpr uint32_t sleeping = 2;
+
+  static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  uint32_t* futex_word() noexcept { return reinterpret_cast<uint32_t*>(&state_); }
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+  std::atomic<uint32_t> state_{empty};
+};
+}  // namespace coro_detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_PARKER_H
@@ -0,0 +1,101 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_SPSC_RING_H
+#define GENERATOR_REWRITE_EXAMPLES_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace coro_detail {
+// Assumed size of a cache line, used to keep the indices of the producer and the consumer apart.
+inline constexpr size_t cache_line_size = 64;
+
+// A bounded, lock-free ring buffer for exactly one producer thread and one consumer thread. The
+// capacity is rounded up to a power of two. Each side keeps a cached copy of the other side's
+// index, so the shared indices are only read when the cached copy says that the ring is full
+// (producer) or empty (consumer).
+//
+// The elements are constructed in place by the producer and stay in their slot until the consumer
+// calls `pop()`, so the consumer can use them via `front()` without moving them out.
+template <typename T>
+class spsc_ring {
+ public:
+  explicit spsc_ring(size_t capacity)
+      : mask_(round_up_to_power_of_two(capacity) - 1), slots_(new slot[mask_ + 1]) {}
+
+  spsc_ring(const spsc_ring&) = delete;
+  spsc_ring& operator=(const spsc_ring&) = delete;
+
+  // Must only be called when neither the producer nor the consumer are active anymore.
+  ~spsc_ring() {
+    while (front()) {
+      pop();
+    }
+  }
+
+  size_t capacity() const noexcept { return mask_ + 1; }
+
+  // Producer only: construct an element from `args` at the end of the ring. Returns false (and
+  // doesn't touch the `args`) if the ring is full.
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ > mask_) {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+      if (tail - cachedHead_ > mask_) {
+        return false;
+      }
+    }
+    new (slots_[tail & mask_].storage_) T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only: the oldest element, or `nullptr` if the ring is empty.
+  T* front() noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cachedTail_) {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      if (head == cachedTail_) {
+        return nullptr;
+      }
+    }
+    return slots_[head & mask_].get();
+  }
+
+  // Consumer only: destroy the element that `front()` returned and hand its slot back to the
+  // producer.
+  void pop() noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    slots_[head & mask_].get()->~T();
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+ private:
+  struct slot {
+    alignas(T) unsigned char storage_[sizeof(T)];
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage_)); }
+  };
+
+  static size_t round_up_to_power_of_two(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // Written by the consumer.
+  alignas(cache_line_size) std::atomic<size_t> head_{0};
+  size_t cachedTail_ = 0;
+  // Written by the producer.
+  alignas(cache_line_size) std::atomic<size_t> tail_{0};
+  size_t cachedHead_ = 0;
+
+  alignas(cache_line_size) const size_t mask_;
+  std::unique_ptr<slot[]> slots_;
+};
+}  // namespace coro_detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_SPSC_RING_H
@@ -0,0 +1,217 @@
+#ifndef GENERATOR_REWRITE_EXAMPLES_TIMER_WHEEL_H
+#define GENERATOR_REWRITE_EXAMPLES_TIMER_WHEEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "util/coroutine_handle.h"
+
+namespace coro_detail {
+class timer_wheel;
+
+// An intrusive timer, usually a member of an awaiter (and thus of a coroutine frame), so arming a
+// timer never allocates. `expire_` is called when the timer expires, and returns the coroutine to
+// resume (or a null handle). It must not cancel other timers.
+struct timer_node {
+  using expire_func = stackless_coroutine_handle<void> (*)(timer_node&);
+
+  explicit timer_node(expire_func expire) noexcept : expire_(expire) {}
+
+  // A node must not be copied or moved while it is armed.
+  timer_node(const timer_node& other) noexcept : expire_(other.expire_) {}
+  timer_node& operator=(const timer_node&) = delete;
+
+  bool armed() const noexcept { return slot_ != nullptr; }
+
+  expire_func expire_;
+  uint64_t expiry_ = 0;
+
+ private:
+  friend class timer_wheel;
+  timer_node* prev_ = nullptr;
+  timer_node* next_ = nullptr;
+  // The head of the list that contains this node, null if the node is not armed.
+  timer_node** slot_ = nullptr;
+};
+
+// A hierarchical timing wheel (Varghese and Lauck, "Hashed and Hierarchical Timing Wheels", 1987)
+// with 4 levels of 64 slots. The time is measured in ticks. A timer that expires in fewer than 64
+// ticks is placed in the slot of its expiry on level 0, otherwise on the level whose slots are
+// just fine enough, and moved down a level ("cascaded") when the current time reaches the slot.
+// Timers beyond the range of 2^24 ticks wait in an overflow list, which is cascaded once per
+// revolution of the top level.
+//
+// `insert` and `cancel` are O(1) (doubly-linked slot lists), `advance` is O(1) per elapsed tick
+// that has a non-empty slot, plus O(1) per expired or cascaded timer. A bitmap of the non-empty
+// slots per level lets `advance` skip over empty ticks and `next_expiry` compute the next wakeup
+// without scanning the slots.
+class timer_wheel {
+ public:
+  static constexpr unsigned bits_per_level = 6;
+  static constexpr unsigned slots_per_level = 1u << bits_per_level;
+  static constexpr unsigned num_levels = 4;
+  static constexpr uint64_t no_expiry = std::numeric_limits<uint64_t>::max();
+
+  explicit timer_wheel(uint64_t now = 0) noexcept : now_(now) {}
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+
+  // The last tick that was processed by `advance`.
+  uint64_t now() const noexcept { return now_; }
+
+  size_t size() const noexcept { return size_; }
+
+  // Arm the (unarmed) `node`, which expires at the tick `expiry`. Expiries that are not in the
+  // future expire at the next tick.
+  void insert(timer_node& node, uint64_t expiry) noexcept {
+    node.expiry_ = expiry > now_ ? expiry : now_ + 1;
+    link(node);
+    ++size_;
+  }
+
+  // Disarm the `node`, no-op if it isn't armed.
+  void cancel(timer_node& node) noexcept {
+    if (node.armed()) {
+      unlink(node);
+      --size_;
+    }
+  }
+
+  // A lower bound for the next tick at which a timer expires, `no_expiry` if no timer is armed.
+  uint64_t next_expiry() const noexcept {
+    if (size_ == 0) {
+      return no_expiry;
+    }
+    uint64_t next = no_expiry;
+    for (unsigned level = 0; level < num_levels; ++level) {
+      if (!occupied_[level]) {
+        continue;
+      }
+      const unsigned shift = level * bits_per_level;
+      // The first non-empty slot after the current one, the current slot itself comes last.
+      const unsigned first = static_cast<unsigned>((now_ >> shift) + 1) & (slots_per_level - 1);
+      const uint64_t rotated = rotate_right(occupied_[level], first);
+      const uint64_t block = (now_ >> shift) + 1 + static_cast<uint64_t>(__builtin_ctzll(rotated));
+      next = std::min(next, block << shift);
+    }
+    if (overflow_) {
+      const unsigned shift = num_levels * bits_per_level;
+      next = std::min(next, ((now_ >> shift) + 1) << shift);
+    }
+    return next;
+  }
+
+  // Process all the ticks up to (and including) `target`. The coroutines of the expired timers are
+  // appended to `ready`.
+  void advance(uint64_t target, std::vector<HandleFrame*>& ready) {
+    while (now_ < target) {
+      // No cascades and no expiries are skipped, as `next_expiry` is a lower bound for both.
+      const uint64_t next = next_expiry();
+      if (next > target) {
+        now_ = target;
+        return;
+      }
+      now_ = next;
+      cascade();
+      expire(ready);
+    }
+  }
+
+ private:
+  static uint64_t rotate_right(uint64_t bits, unsigned n) noexcept {
+    return n == 0 ? bits : (bits >> n) | (bits << (64 - n));
+  }
+
+  void link(timer_node& node) noexcept {
+    const uint64_t delta = node.expiry_ - now_;
+    timer_node** slot = &overflow_;
+    for (unsigned level = 0; level < num_levels; ++level) {
+      const unsigned shift = level * bits_per_level;
+      if (delta < (uint64_t{slots_per_level} << shift)) {
+        const unsigned index =
+            static_cast<unsigned>(node.expiry_ >> shift) & (slots_per_level - 1);
+        slot = &slots_[level][index];
+        occupied_[level] |= uint64_t{1} << index;
+        break;
+      }
+    }
+    node.slot_ = slot;
+    node.prev_ = nullptr;
+    node.next_ = *slot;
+    if (*slot) {
+      (*slot)->prev_ = &node;
+    }
+    *slot = &node;
+  }
+
+  void unlink(timer_node& node) noexcept {
+    if (node.prev_) {
+      node.prev_->next_ = node.next_;
+    } else {
+      *node.slot_ = node.next_;
+      if (!node.next_ && node.slot_ != &overflow_) {
+        const size_t flat = static_cast<size_t>(node.slot_ - &slots_[0][0]);
+        occupied_[flat / slots_per_level] &= ~(uint64_t{1} << (flat % slots_per_level));
+      }
+    }
+    if (node.next_) {
+      node.next_->prev_ = node.prev_;
+    }
+    node.slot_ = nullptr;
+  }
+
+  // Move the timers of the slots that start at `now_` one or more levels down, starting with the
+  // highest level, as its timers might land in a slot of a lower level that starts at `now_`.
+  void cascade() noexcept {
+    if ((now_ & ((uint64_t{1} << (num_levels * bits_per_level)) - 1)) == 0) {
+      relink(overflow_);
+    }
+    for (unsigned level = num_levels - 1; level > 0; --level) {
+      const unsigned shift = level * bits_per_level;
+      if ((now_ & ((uint64_t{1} << shift) - 1)) == 0) {
+        const unsigned index = static_cast<unsigned>(now_ >> shift) & (slots_per_level - 1);
+        relink(slots_[level][index]);
+        occupied_[level] &= ~(uint64_t{1} << index);
+      }
+    }
+  }
+
+  void relink(timer_node*& head) noexcept {
+    timer_node* node = head;
+    head = nullptr;
+    while (node) {
+      timer_node* next = node->next_;
+      link(*node);
+      node = next;
+    }
+  }
+
+  void expire(std::vector<HandleFrame*>& ready) {
+    const unsigned index = static_cast<unsigned>(now_) & (slots_per_level - 1);
+    timer_node* node = slots_[0][index];
+    slots_[0][index] = nullptr;
+    occupied_[0] &= ~(uint64_t{1} << index);
+    while (node) {
+      timer_node* next = node->next_;
+      node->slot_ = nullptr;
+      --size_;
+      if (auto h = node->expire_(*node)) {
+        ready.push_back(h.ptr);
+      }
+      node = next;
+    }
+  }
+
+  uint64_t now_;
+  size_t size_ = 0;
+  timer_node* slots_[num_levels][slots_per_level] = {};
+  uint64_t occupied_[num_levels] = {};
+  timer_node* overflow_ = nullptr;
+};
+}  // namespace coro_detail
+
+#endif  // GENERATOR_REWRITE_EXAMPLES_TIMER_WHEEL_H
@@ -1,6 +1,12 @@
 #ifndef GENERATOR_REWRITE_EXAMPLES_TYPE_TRAITS_H
 #define GENERATOR_REWRITE_EXAMPLES_TYPE_TRAITS_H
 
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 // Helper type traits used to analyze promise types and awaitables.
 namespace coro_detail {
 // A class that is implicitly convertible to anything, but the conversion operator is not defined.
@@ -10,6 +16,11 @@ struct ConvertibleToAnything {
   operator T();
 };
 
+// Always false, but only evaluated when a template is instantiated, for `static_assert`s in
+// templates that must not be instantiated.
+template <typename...>
+inline constexpr bool dependent_false = false;
+
 // `has_await_transform<Promise>::value` is true iff. `Promise` has a member function
 // `await_transform` that can be called with a single argument.
 template <typename Promise, typename = void>
@@ -95,6 +106,54 @@ struct has_promise_delete_unsized<P,
                                   std::void_t<decltype(P::operator delete(std::declval<void*>()))>>
     : std::true_type {};
 
+// Type trait that checks whether a (stackful) coroutine frame opted in to being cloned via
+// `using is_cloneable [[maybe_unused]] = std::true_type` (frames are often local classes, which
+// can't have static data members, and GCC reports typedefs of local classes as unused even if they
+// are only read by a trait like this one).
+template <typename Frame, typename = void>
+struct is_cloneable_frame : std::false_type {};
+
+template <typename Frame>
+struct is_cloneable_frame<Frame, std::enable_if_t<Frame::is_cloneable::value>> : std::true_type {};
+
+// Type trait that checks whether a (stackless) coroutine frame opted in to being relocated into
+// the buffer of its return object via `using is_relocatable [[maybe_unused]] = std::true_type` (see
+// `stackless_coro_crtp::ramp_in_buffer`).
+template <typename Frame, typename = void>
+struct is_relocatable_frame : std::false_type {};
+
+template <typename Frame>
+struct is_relocatable_frame<Frame, std::enable_if_t<Frame::is_relocatable::value>>
+    : std::true_type {};
+
+// Type trait that checks whether a (stackful) coroutine frame promises to never yield batches
+// (see `unified_generator_promise::yield_batch`) via
+// `using is_unbatched [[maybe_unused]] = std::true_type`, so consumers can skip the batch handling.
+template <typename Frame, typename = void>
+struct is_unbatched_frame : std::false_type {};
+
+template <typename Frame>
+struct is_unbatched_frame<Frame, std::enable_if_t<Frame::is_unbatched::value>> : std::true_type {};
+
+// Type trait that checks whether a promise type has a member function
+// `rebase(const void* from, const void* to, size_t size)` (see `stackful_coro_crtp::rebaseCopy` and
+// `stackless_coro_crtp::relocate`).
+template <typename P, typename = void>
+struct has_rebase : std::false_type {};
+
+template <typename P>
+struct has_rebase<P, std::void_t<decltype(std::declval<P&>().rebase(
+                         std::declval<const void*>(), std::declval<const void*>(), size_t{}))>>
+    : std::true_type {};
+
+// Whether the coroutine arguments `Args` start with `std::allocator_arg`.
+template <typename... Args>
+inline constexpr bool starts_with_allocator_arg = false;
+
+template <typename First, typename... Rest>
+inline constexpr bool starts_with_allocator_arg<First, Rest...> =
+    std::is_same_v<std::decay_t<First>, std::allocator_arg_t>;
+
 // Allocate the coroutine frame using the promise type's operator new if available.
 // Per the C++ spec, the fallback chain is:
 //   1. P::operator new(size, args...) — with coroutine arguments
@@ -102,6 +161,9 @@ struct has_promise_delete_unsized<P,
 //   3. ::operator new(size)           — global
 template <typename P, typename... Args>
 void* promise_allocate(size_t size, Args&&... args) {
+  static_assert(!starts_with_allocator_arg<Args...> || has_promise_new_with_args<P, Args...>::value,
+                "The promise has to be wrapped in `resource_allocated` to allocate the frame from "
+                "an explicit memory resource");
   if constexpr (sizeof...(Args) > 0 && has_promise_new_with_args<P, Args...>::value) {
     return P::operator new(size, std::forward<Args>(args)...);
   } else if constexpr (has_promise_new<P>::value) {